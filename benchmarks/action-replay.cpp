@@ -0,0 +1,200 @@
+/* #Checks the action logs, and the pace and timing of `ActionLog::Replayer`.
+! Every kind of action is formatted and parsed back, then a log of `LOG_ACTIONS` is read to time
+the parser. A replay of `REPLAY_ACTIONS` then runs on a window, some of them not being ready at
+first: they must all run in order, no sooner than their delays allow, and each must get a
+response time.
+! Fails when an action doesn't survive the round trip, or the replay doesn't run as it should.
+Exits with 77 (skipped) when there's no display to initialize GTK with.
+*/
+#include <fstream>
+#include <glibmm/main.h>
+#include <gtkmm/application.h>
+#include <gtkmm/label.h>
+#include <gtkmm/window.h>
+#include <momuma/spdlog.h>
+#include <unistd.h>
+#include <vector>
+
+#include "ActionLog.h"
+
+
+using Clock = chrono::steady_clock;
+using ActionLog::Action;
+using ActionLog::Kind;
+
+constexpr size_t LOG_ACTIONS = 100'000;
+
+constexpr size_t REPLAY_ACTIONS = 200;
+constexpr chrono::milliseconds REPLAY_DELAY { 20 };
+constexpr double REPLAY_SPEED = 10.0;
+// every so many actions aren't ready for a few polls
+constexpr size_t LATE_EVERY = 10;
+constexpr size_t LATE_POLLS = 3;
+
+[[nodiscard]] static Action make_action(const size_t i)
+{
+	const auto kind = static_cast<Kind>(i % static_cast<size_t>(Kind::COUNT));
+	return Action { chrono::milliseconds(i % 5000), kind, i % 7, i * 31,
+		(kind == Kind::OPEN || kind == Kind::PLACEHOLDER)
+			? fmt::format("Playlist {:d} (with spaces)", i) : ""
+	};
+}
+
+// Whether the fields a kind of action uses are the same.
+[[nodiscard]] static bool same_action(const Action &a, const Action &b)
+{
+	if (a.delay != b.delay || a.kind != b.kind) { return false; }
+	switch (a.kind)
+	{
+	case Kind::OPEN:
+	case Kind::PLACEHOLDER:
+		return a.playlist == b.playlist;
+	case Kind::FOCUS:
+		return a.page == b.page;
+	case Kind::MOVE:
+	case Kind::ACTIVATE:
+		return a.page == b.page && a.value == b.value;
+	case Kind::DROP:
+	case Kind::SCROLL:
+		return a.value == b.value;
+	default:
+		return true;
+	}
+}
+
+// Format and parse every kind of action, and lines that aren't actions.
+[[nodiscard]] static size_t round_trip_errors(void)
+{
+	size_t errors = 0;
+	for (size_t i = 0; i < static_cast<size_t>(Kind::COUNT); ++i) {
+		const Action action = make_action(i);
+		const std::string line = ActionLog::format(action);
+		const std::optional<Action> parsed = ActionLog::parse(line);
+		if (!parsed.has_value() || !same_action(action, parsed.value())) {
+			SPDLOG_ERROR("'{:s}' isn't parsed back as it was", line);
+			++errors;
+		}
+	}
+	for (const char *const line : { "", "12", "-5 next", "10 jump", "10 next 1", "10 open",
+		"10 focus", "10 focus x", "10 move 1", "10 activate 1", "10 drop -4", "10 scroll" }
+	) {
+		if (ActionLog::parse(line).has_value()) {
+			SPDLOG_ERROR("'{:s}' was parsed as an action", line);
+			++errors;
+		}
+	}
+	return errors;
+}
+
+// Write a log of `LOG_ACTIONS`, with a comment and an invalid line, then time reading it.
+[[nodiscard]] static size_t read_errors(const fs::path &file)
+{
+	{
+		std::ofstream out(file, std::ios::trunc);
+		out << "# momuma-gtk actions 1\n# a comment\nnot an action\n";
+		for (size_t i = 0; i < LOG_ACTIONS; ++i) {
+			out << ActionLog::format(make_action(i)) << '\n';
+		}
+	}
+	
+	const Clock::time_point begin = Clock::now();
+	const std::optional<std::vector<Action>> actions = ActionLog::read(file);
+	const chrono::duration<double, std::milli> elapsed = Clock::now() - begin;
+	SPDLOG_INFO("Read {:d} actions in {:.1f} ms ({:.0f} ns per action), {:d} KiB",
+		LOG_ACTIONS, elapsed.count(), elapsed.count() * 1e6 / LOG_ACTIONS,
+		fs::file_size(file) >> 10
+	);
+	fs::remove(file);
+	
+	if (!actions.has_value() || actions->size() != LOG_ACTIONS) {
+		SPDLOG_ERROR("Expected {:d} actions in the log", LOG_ACTIONS);
+		return 1;
+	}
+	size_t errors = 0;
+	for (size_t i = 0; i < LOG_ACTIONS; ++i) {
+		errors += !same_action(make_action(i), actions->at(i));
+	}
+	return errors;
+}
+
+int main(int argc, char **argv)
+{
+	spdlog::set_level(spdlog::level::info);
+	size_t errors = round_trip_errors();
+	errors += read_errors(fs::temp_directory_path()
+		/ fmt::format("momuma-gtk-actions-{:d}.log", ::getpid())
+	);
+	
+	if (!gtk_init_check(&argc, &argv)) {
+		SPDLOG_WARN("No display available, skipping the replay");
+		return errors > 0 ? 1 : 77;
+	}
+	// initializes the gtkmm wrappers
+	const Glib::RefPtr<Gtk::Application> app = Gtk::Application::create();
+	
+	Gtk::Window window;
+	window.set_default_size(400, 300);
+	Gtk::Label label;
+	window.add(label);
+	window.show_all();
+	
+	std::vector<Action> actions;
+	for (size_t i = 0; i < REPLAY_ACTIONS; ++i) {
+		actions.push_back(Action { REPLAY_DELAY, Kind::FOCUS, i, 0, "" });
+	}
+	ActionLog::Replayer replayer(actions, REPLAY_SPEED, window);
+	
+	const Glib::RefPtr<Glib::MainLoop> loop = Glib::MainLoop::create();
+	replayer.signal_finished().connect(sigc::mem_fun(*loop, &Glib::MainLoop::quit));
+	
+	size_t polls = 0;
+	std::vector<size_t> performed;
+	replayer.start(
+		[&polls](const Action &action) -> bool
+		{
+			if (action.page % LATE_EVERY != 0 || polls == LATE_POLLS) {
+				polls = 0;
+				return true;
+			}
+			++polls;
+			return false;
+		},
+		[&performed, &label](const Action &action) -> void
+		{
+			performed.push_back(action.page);
+			label.set_text(fmt::format("Action {:d}", action.page));
+		}
+	);
+	const Clock::time_point begin = Clock::now();
+	loop->run();
+	const Clock::duration elapsed = Clock::now() - begin;
+	replayer.log_report();
+	
+	for (size_t i = 0; i < performed.size(); ++i) {
+		if (performed[i] != i) {
+			SPDLOG_ERROR("Action {:d} ran in place of action {:d}", performed[i], i);
+			++errors;
+			break;
+		}
+	}
+	const size_t responses = replayer.responses(Kind::FOCUS).count();
+	if (performed.size() != REPLAY_ACTIONS || responses != REPLAY_ACTIONS
+		|| replayer.skipped() > 0 || !replayer.is_finished()
+	) {
+		SPDLOG_ERROR("Ran {:d} of {:d} actions, with {:d} response times",
+			performed.size(), REPLAY_ACTIONS, responses
+		);
+		++errors;
+	}
+	const auto minimum = chrono::duration_cast<Clock::duration>(
+		REPLAY_DELAY * REPLAY_ACTIONS / REPLAY_SPEED
+	);
+	if (elapsed < minimum) {
+		SPDLOG_ERROR("The replay took {:d} ms, it can't run faster than {:d} ms",
+			chrono::duration_cast<chrono::milliseconds>(elapsed).count(),
+			chrono::duration_cast<chrono::milliseconds>(minimum).count()
+		);
+		++errors;
+	}
+	return errors > 0 ? 1 : 0;
+}
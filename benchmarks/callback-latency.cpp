@@ -0,0 +1,124 @@
+/* #Checks the latency histograms and the stall watchdog of `LoopMonitor`.
+! Measures what `MONITOR_CALLBACK()` costs a callback, and compares the percentiles of a
+`LatencyHistogram` with the exact ones of a million durations spread over six orders of
+magnitude. Then runs a main loop with a callback that blocks it, which the watchdog must
+report exactly once.
+! Fails when a percentile is off by more than `MAX_ERROR`, when a monitored callback costs more
+than `MAX_OVERHEAD`, or when the stall isn't reported.
+*/
+#include <algorithm>
+#include <cmath>
+#include <glibmm/init.h>
+#include <glibmm/main.h>
+#include <momuma/spdlog.h>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "LoopMonitor.h"
+
+
+constexpr size_t SAMPLES = 1'000'000;
+constexpr double MAX_ERROR = 0.016;
+constexpr chrono::nanoseconds MAX_OVERHEAD { 1000 };
+
+constexpr chrono::milliseconds STALL_THRESHOLD { 50 };
+constexpr chrono::milliseconds STALL { 4 * STALL_THRESHOLD };
+
+using Clock = chrono::steady_clock;
+
+[[gnu::noinline]] static void monitored(void)
+{
+	MONITOR_CALLBACK("monitored");
+}
+
+// Worst relative error of the percentiles.
+[[nodiscard]] static double histogram_error(void)
+{
+	std::mt19937_64 rng(1);
+	// median of about 400 µs, with a long tail into the seconds
+	std::lognormal_distribution<double> distribution(6.0, 2.0);
+	
+	LatencyHistogram histogram;
+	std::vector<int64_t> samples(SAMPLES);
+	for (int64_t &sample : samples) {
+		sample = std::min<int64_t>(static_cast<int64_t>(distribution(rng)),
+			LatencyHistogram::MAX.count()
+		);
+		histogram.record(LatencyHistogram::Duration(sample));
+	}
+	std::sort(samples.begin(), samples.end());
+	
+	double worst = 0.0;
+	for (const double percent : { 1.0, 50.0, 90.0, 99.0, 99.9, 99.99, 100.0 }) {
+		const auto rank = static_cast<size_t>(std::ceil(percent / 100.0 * SAMPLES));
+		const int64_t exact = samples[std::max<size_t>(rank, 1) - 1];
+		const int64_t got = histogram.percentile(percent).count();
+		const double error = exact == 0 ? 0.0
+			: std::abs(static_cast<double>(got - exact)) / static_cast<double>(exact);
+		SPDLOG_INFO("p{:<6g} exact {:>9d} µs, histogram {:>9d} µs ({:.2f}%)",
+			percent, exact, got, error * 100.0
+		);
+		worst = std::max(worst, error);
+	}
+	return worst;
+}
+
+[[nodiscard]] static chrono::nanoseconds monitor_overhead(void)
+{
+	const Clock::time_point begin = Clock::now();
+	for (size_t i = 0; i < SAMPLES; ++i) { monitored(); }
+	return (Clock::now() - begin) / SAMPLES;
+}
+
+// Number of stalls the watchdog reports for a callback blocking the main loop once.
+[[nodiscard]] static size_t detect_stall(void)
+{
+	const Glib::RefPtr<Glib::MainLoop> loop = Glib::MainLoop::create();
+	LoopMonitor::Watchdog watchdog(STALL_THRESHOLD);
+	watchdog.start();
+	
+	Glib::signal_timeout().connect_once(
+		[](void) -> void
+		{
+			MONITOR_CALLBACK("blocking");
+			std::this_thread::sleep_for(STALL);
+		},
+		static_cast<unsigned int>(STALL_THRESHOLD.count())
+	);
+	// leaves time for the heartbeat to notice the main loop iterates again
+	Glib::signal_timeout().connect_once([&loop](void) -> void { loop->quit(); },
+		static_cast<unsigned int>((STALL + 4 * STALL_THRESHOLD).count())
+	);
+	loop->run();
+	
+	watchdog.stop();
+	return watchdog.stalls();
+}
+
+int main(void)
+{
+	spdlog::set_level(spdlog::level::info);
+	Glib::init();
+	
+	const double error = histogram_error();
+	const chrono::nanoseconds overhead = monitor_overhead();
+	SPDLOG_INFO("MONITOR_CALLBACK() costs {:d} ns", overhead.count());
+	const size_t stalls = detect_stall();
+	LoopMonitor::log_histograms();
+	
+	bool failed = false;
+	if (error > MAX_ERROR) {
+		SPDLOG_ERROR("A percentile is off by {:.2f}%", error * 100.0);
+		failed = true;
+	}
+	if (overhead > MAX_OVERHEAD) {
+		SPDLOG_ERROR("A monitored callback costs more than {:d} ns", MAX_OVERHEAD.count());
+		failed = true;
+	}
+	if (stalls != 1) {
+		SPDLOG_ERROR("The watchdog reported {:d} stalls instead of 1", stalls);
+		failed = true;
+	}
+	return failed ? 1 : 0;
+}
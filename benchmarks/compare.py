@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Compare two result files of a benchmark, e.g `playlist-ops.json`.
+
+Results are matched by name and number of rows, and their medians compared, along with the
+overall speedup. Exits with 1 when a result got slower than the threshold allows, so it can gate
+a change.
+
+	./compare.py before.json after.json --threshold 10
+"""
+import argparse
+import json
+import math
+import sys
+
+
+def load(path):
+	with open(path, encoding='utf-8') as file:
+		data = json.load(file)
+	return data.get('unit', 'ms'), {(r['name'], r['rows']): r for r in data['results']}
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+	parser.add_argument('baseline', help='results to compare against')
+	parser.add_argument('current', help='results to check')
+	parser.add_argument('--threshold', type=float, default=10.0,
+		help='slowdown of a median, in percent, flagged as a regression (default: 10)')
+	parser.add_argument('--min-delta', type=float, default=0.01,
+		help='differences of less than this many units are noise (default: 0.01)')
+	args = parser.parse_args()
+	
+	unit, baseline = load(args.baseline)
+	_, current = load(args.current)
+	
+	regressions = 0
+	ratios = []
+	print(f'{"benchmark":<16} {"rows":>7} {"before":>12} {"after":>12} {"change":>8}')
+	for key in sorted(baseline.keys() | current.keys(), key=lambda k: (k[1], k[0])):
+		name, rows = key
+		if key not in baseline or key not in current:
+			where = 'baseline' if key not in baseline else 'current results'
+			print(f'{name:<16} {rows:>7} missing from the {where}')
+			continue
+		
+		before = baseline[key]['median']
+		after = current[key]['median']
+		if before > 0 and after > 0:
+			ratios.append(before / after)
+		change = (after - before) / before * 100.0 if before > 0 else 0.0
+		regressed = change > args.threshold and after - before > args.min_delta
+		regressions += regressed
+		print(f'{name:<16} {rows:>7} {before:>9.3f} {unit:<2} {after:>9.3f} {unit:<2} '
+			f'{change:>+7.1f}%{"  REGRESSION" if regressed else ""}')
+	
+	if ratios:
+		speedup = math.exp(sum(math.log(r) for r in ratios) / len(ratios))
+		print(f'speedup: {speedup:.3f}x (geometric mean of {len(ratios)} results)')
+	
+	if regressions > 0:
+		print(f'{regressions} regression(s) past {args.threshold:g}%', file=sys.stderr)
+		return 1
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main())
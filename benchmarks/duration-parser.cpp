@@ -0,0 +1,249 @@
+/* #Compares `Media::parse_duration()` with `Momuma::MpvPlayer::query_duration()`.
+! A corpus of small synthetic media files is generated in a temporary folder, the durations
+read by the header parser are checked against the generated ones, then both paths are timed
+over the whole corpus.
+*/
+#include <array>
+#include <fstream>
+#include <glibmm/miscutils.h>
+#include <momuma/momuma.h>
+#include <momuma/spdlog.h>
+#include <vector>
+
+#include "MediaDuration.h"
+
+
+constexpr int FILES_PER_FORMAT = 40;
+constexpr int PARSER_ROUNDS = 20;
+
+struct CorpusFile
+{
+	fs::path path;
+	chrono::microseconds duration;
+};
+
+class Writer
+{
+public:
+	void u8(const uint32_t v) { m_data.push_back(static_cast<char>(v & 0xff)); }
+	void u16_le(const uint32_t v) { u8(v); u8(v >> 8); }
+	void u32_le(const uint32_t v) { u16_le(v); u16_le(v >> 16); }
+	void u64_le(const uint64_t v)
+	{
+		u32_le(static_cast<uint32_t>(v));
+		u32_le(static_cast<uint32_t>(v >> 32));
+	}
+	void u16_be(const uint32_t v) { u8(v >> 8); u8(v); }
+	void u32_be(const uint32_t v) { u16_be(v >> 16); u16_be(v); }
+	void str(const std::string_view s) { m_data.append(s); }
+	void zeros(const size_t n) { m_data.append(n, '\0'); }
+	
+	[[nodiscard]] size_t size(void) const { return m_data.size(); }
+	[[nodiscard]] const std::string& data(void) const { return m_data; }
+	
+	void save(const fs::path &path) const
+	{
+		std::ofstream(path, std::ios::binary).write(m_data.data(),
+			static_cast<std::streamsize>(m_data.size())
+		);
+	}
+	
+private:
+	std::string m_data;
+};
+
+[[nodiscard]] static
+chrono::microseconds samples_to_duration(const uint64_t samples, const uint64_t rate)
+{
+	return chrono::microseconds(samples * 1'000'000 / rate);
+}
+
+static CorpusFile make_wav(const fs::path &path, const uint32_t seconds)
+{
+	constexpr uint32_t RATE = 44100, CHANNELS = 2, BYTES_PER_SAMPLE = 2;
+	const uint32_t dataSize = seconds * RATE * CHANNELS * BYTES_PER_SAMPLE;
+	
+	Writer w;
+	w.str("RIFF"); w.u32_le(36 + dataSize); w.str("WAVE");
+	w.str("fmt "); w.u32_le(16);
+	w.u16_le(1); w.u16_le(CHANNELS); w.u32_le(RATE);
+	w.u32_le(RATE * CHANNELS * BYTES_PER_SAMPLE); w.u16_le(CHANNELS * BYTES_PER_SAMPLE);
+	w.u16_le(BYTES_PER_SAMPLE * 8);
+	w.str("data"); w.u32_le(dataSize); w.zeros(dataSize);
+	w.save(path);
+	return { path, chrono::seconds(seconds) };
+}
+
+// MPEG-1 Layer III, 128 kbit/s, 44.1 kHz, stereo
+static CorpusFile make_mp3(const fs::path &path, const uint32_t frames, const bool withXing)
+{
+	constexpr uint32_t FRAME_SIZE = 417; // 144 * 128000 / 44100, without padding
+	
+	const auto write_frame_header = [](Writer &w) -> void
+	{
+		w.u8(0xff); w.u8(0xfb); w.u8(0x90); w.u8(0x00);
+	};
+	
+	Writer w;
+	if (withXing) {
+		write_frame_header(w);
+		w.zeros(32); // side information
+		w.str("Info"); w.u32_be(0x1); w.u32_be(frames);
+		w.zeros(FRAME_SIZE - w.size());
+	}
+	for (uint32_t i = 0; i < frames; ++i) {
+		write_frame_header(w);
+		w.zeros(FRAME_SIZE - 4);
+	}
+	w.save(path);
+	
+	const auto duration = withXing ?
+		samples_to_duration(uint64_t { frames } * 1152, 44100) :
+		chrono::microseconds(uint64_t { w.size() } * 8 * 1'000'000 / 128'000);
+	return { path, duration };
+}
+
+static CorpusFile make_flac(const fs::path &path, const uint64_t samples)
+{
+	constexpr uint32_t RATE = 44100;
+	
+	Writer w;
+	w.str("fLaC");
+	w.u8(0x80); w.u8(0); w.u8(0); w.u8(34); // last metadata block, STREAMINFO, 34 bytes
+	w.u16_be(4096); w.u16_be(4096); // block sizes
+	w.zeros(6); // frame sizes
+	// sample rate (20 bits), channels - 1 (3 bits), bits per sample - 1 (5 bits),
+	// samples (36 bits)
+	w.u8(RATE >> 12); w.u8((RATE >> 4) & 0xff);
+	w.u8(((RATE & 0xf) << 4) | (1 << 1));
+	w.u8(0xf0 | static_cast<uint32_t>((samples >> 32) & 0xf));
+	w.u32_be(static_cast<uint32_t>(samples));
+	w.zeros(16); // MD5
+	w.save(path);
+	return { path, samples_to_duration(samples, RATE) };
+}
+
+static void write_ogg_page(Writer &w, const uint64_t granule, const uint32_t sequence,
+	const uint32_t type, const std::string_view packet
+) {
+	w.str("OggS"); w.u8(0); w.u8(type);
+	w.u64_le(granule); w.u32_le(0x1234); w.u32_le(sequence); w.u32_le(0 /* CRC */);
+	w.u8(1); w.u8(static_cast<uint32_t>(packet.size()));
+	w.str(packet);
+}
+
+static CorpusFile make_opus(const fs::path &path, const uint64_t samples)
+{
+	constexpr uint32_t PRE_SKIP = 312;
+	
+	Writer head;
+	head.str("OpusHead"); head.u8(1); head.u8(2); head.u16_le(PRE_SKIP);
+	head.u32_le(48000); head.u16_le(0); head.u8(0);
+	
+	Writer tags;
+	tags.str("OpusTags"); tags.u32_le(0); tags.u32_le(0);
+	
+	const std::string audio(100, '\0');
+	Writer w;
+	write_ogg_page(w, 0, 0, 0x02, head.data());
+	write_ogg_page(w, 0, 1, 0x00, tags.data());
+	for (uint32_t i = 2; i < 40; ++i) {
+		write_ogg_page(w, 960 * i, i, 0x00, audio);
+	}
+	write_ogg_page(w, samples + PRE_SKIP, 40, 0x04, audio);
+	w.save(path);
+	return { path, samples_to_duration(samples, 48000) };
+}
+
+static CorpusFile make_m4a(const fs::path &path, const uint32_t timescale, const uint32_t units)
+{
+	Writer w;
+	w.u32_be(20); w.str("ftyp"); w.str("M4A "); w.u32_be(0); w.str("isom");
+	w.u32_be(8 + 8 + 100); w.str("moov");
+	w.u32_be(8 + 100); w.str("mvhd");
+	w.u32_be(0); // version 0, no flags
+	w.u32_be(0); w.u32_be(0); w.u32_be(timescale); w.u32_be(units);
+	w.zeros(100 - 20);
+	w.u32_be(8 + 1024); w.str("mdat"); w.zeros(1024);
+	w.save(path);
+	return { path, samples_to_duration(units, timescale) };
+}
+
+[[nodiscard]] static std::vector<CorpusFile> generate_corpus(const fs::path &folder)
+{
+	std::vector<CorpusFile> corpus;
+	for (uint32_t i = 0; i < FILES_PER_FORMAT; ++i) {
+		const auto name = [&folder, i](const char *ext) -> fs::path
+		{
+			return folder / fmt::format("{:03d}.{:s}", i, ext);
+		};
+		corpus.push_back(make_wav(name("wav"), 1 + i % 3));
+		corpus.push_back(make_mp3(name("xing.mp3"), 100 + i, true));
+		corpus.push_back(make_mp3(name("cbr.mp3"), 100 + i, false));
+		corpus.push_back(make_flac(name("flac"), 44100 * (60 + i)));
+		corpus.push_back(make_opus(name("opus"), 48000 * (120 + i)));
+		corpus.push_back(make_m4a(name("m4a"), 44100, 44100 * (180 + i)));
+	}
+	return corpus;
+}
+
+int main(void)
+{
+	spdlog::set_level(spdlog::level::info);
+	if (!Momuma::init()) {
+		SPDLOG_CRITICAL("Failed to initiate Momuma");
+		return 1;
+	}
+	
+	const fs::path folder = fs::path(Glib::get_tmp_dir()) / "momuma-gtk-duration-corpus";
+	fs::remove_all(folder);
+	fs::create_directories(folder);
+	const std::vector<CorpusFile> corpus = generate_corpus(folder);
+	
+	int failures = 0;
+	for (const CorpusFile &file : corpus) {
+		const auto parsed = Media::parse_duration(file.path);
+		const auto error = chrono::abs(parsed.value_or(chrono::hours(1)) - file.duration);
+		if (error > chrono::milliseconds(1)) {
+			SPDLOG_ERROR("Wrong duration for '{:s}': {} instead of {}",
+				file.path.filename().string(),
+				parsed.value_or(chrono::microseconds(-1)), file.duration
+			);
+			++failures;
+		}
+	}
+	
+	using Clock = chrono::steady_clock;
+	
+	chrono::microseconds sink(0);
+	const Clock::time_point parserBegin = Clock::now();
+	for (int round = 0; round < PARSER_ROUNDS; ++round) {
+		for (const CorpusFile &file : corpus) {
+			sink += Media::parse_duration(file.path).value_or(chrono::microseconds(0));
+		}
+	}
+	const auto parserTime = (Clock::now() - parserBegin) / PARSER_ROUNDS;
+	
+	const Clock::time_point mpvBegin = Clock::now();
+	for (const CorpusFile &file : corpus) {
+		sink += chrono::duration_cast<chrono::microseconds>(
+			Momuma::MpvPlayer::query_duration(file.path)
+		);
+	}
+	const auto mpvTime = Clock::now() - mpvBegin;
+	
+	const auto perFile = [&corpus](const Clock::duration d) -> double
+	{
+		const chrono::duration<double, std::micro> micros(d);
+		return micros.count() / static_cast<double>(corpus.size());
+	};
+	SPDLOG_INFO("{:d} files, {:d} wrong durations (checksum {})",
+		corpus.size(), failures, sink
+	);
+	SPDLOG_INFO("Header parser: {:.2f} us/file", perFile(parserTime));
+	SPDLOG_INFO("mpv:           {:.2f} us/file", perFile(mpvTime));
+	SPDLOG_INFO("Speedup:       {:.1f}x", perFile(mpvTime) / perFile(parserTime));
+	
+	fs::remove_all(folder);
+	return failures == 0 ? 0 : 1;
+}
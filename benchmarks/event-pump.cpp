@@ -0,0 +1,179 @@
+/* #Checks that `PlayerEventPump` handles the events of a player that wakes it up as they come.
+! A fake player is paused and resumed `COMMANDS` times, each command queuing a state change,
+and the time until the main loop handles it is measured. Then a playlist plays to its end on
+the clock of a fast fake player, and the pump mustn't miss any of its streams. Finally the
+player is left paused for `IDLE`, during which the pump mustn't wake up at all.
+! Fails when the fake player doesn't wake the pump up, when an event is missing, or when the
+pump wakes up while the player is paused. The latencies are only reported, they depend on the
+load of the machine.
+*/
+#include <glibmm/init.h>
+#include <glibmm/main.h>
+#include <momuma/spdlog.h>
+
+#include "FakeBackend.h"
+#include "LatencyHistogram.h"
+#include "PlayerEventPump.h"
+
+
+using Clock = chrono::steady_clock;
+using PlayerState = Backend::Player::State;
+
+constexpr size_t COMMANDS = 1'000;
+constexpr size_t TRACKS = 5;
+// virtual seconds per real second, the generated tracks then last 45 to 300 ms
+constexpr double FAST_SPEED = 2000.0;
+constexpr chrono::milliseconds IDLE { 500 };
+// how long an event may take to be handled before it counts as missed
+constexpr chrono::seconds TIMEOUT { 10 };
+
+// The events handled by the main loop
+struct Events
+{
+	size_t states = 0, started = 0, ended = 0;
+	PlayerState state = PlayerState::STOP;
+	
+	void connect(Backend::Player &player)
+	{
+		player.signal_stateChanged.connect(
+			[this](Backend::Player&, PlayerState, const PlayerState newState) -> void
+			{
+				++states;
+				state = newState;
+			}
+		);
+		player.signal_streamStarted.connect(
+			[this](Backend::Player&) -> void { ++started; }
+		);
+		player.signal_streamEnded.connect(
+			[this](Backend::Player&) -> void { ++ended; }
+		);
+	}
+};
+
+[[nodiscard]] static inline double to_ms(const LatencyHistogram::Duration d)
+{
+	return chrono::duration<double, std::milli>(d).count();
+}
+
+// Run the main loop until `done()`, for at most `TIMEOUT`.
+template <typename Pred>
+[[nodiscard]] static bool iterate_until(Pred done)
+{
+	const Glib::RefPtr<Glib::MainContext> context = Glib::MainContext::get_default();
+	const Clock::time_point deadline = Clock::now() + TIMEOUT;
+	while (!done()) {
+		if (Clock::now() > deadline) { return false; }
+		(void)context->iteration(true);
+	}
+	return true;
+}
+
+// Time how long each command takes to be handled.
+[[nodiscard]] static size_t command_errors(void)
+{
+	FakeBackend::Config config;
+	config.seekLatency = chrono::microseconds(0);
+	FakeBackend backend(config);
+	Backend::Player &player = backend.get_player();
+	PlayerEventPump pump(player);
+	if (!pump.is_woken_up()) {
+		SPDLOG_ERROR("The fake player doesn't wake the event pump up");
+		return 1;
+	}
+	Events events;
+	events.connect(player);
+	(void)player.append_media(FakeBackend::track_path(0, 0));
+	
+	LatencyHistogram latencies;
+	for (size_t i = 0; i < COMMANDS; ++i) {
+		const size_t before = events.states;
+		const Clock::time_point begin = Clock::now();
+		player.set_play(i % 2 == 0);
+		const auto handled = [&events, before](void) -> bool
+		{
+			return events.states > before;
+		};
+		if (!iterate_until(handled)) {
+			SPDLOG_ERROR("The state change of command {:d} was never handled", i);
+			return 1;
+		}
+		latencies.record(
+			chrono::duration_cast<LatencyHistogram::Duration>(Clock::now() - begin)
+		);
+	}
+	SPDLOG_INFO("{:d} commands handled after p50={:.3f} p99={:.3f} max={:.3f} ms",
+		latencies.count(), to_ms(latencies.percentile(50)), to_ms(latencies.percentile(99)),
+		to_ms(latencies.max())
+	);
+	return 0;
+}
+
+// Play streams to their end, then stay paused.
+[[nodiscard]] static size_t playback_errors(void)
+{
+	FakeBackend::Config config;
+	config.seekLatency = chrono::microseconds(0);
+	config.speed = FAST_SPEED;
+	FakeBackend backend(config);
+	Backend::Player &player = backend.get_player();
+	PlayerEventPump pump(player);
+	Events events;
+	events.connect(player);
+	size_t errors = 0;
+	
+	// the streams end on the player's own clock, without any command
+	for (size_t i = 0; i < TRACKS; ++i) {
+		(void)player.append_media(FakeBackend::track_path(0, i));
+	}
+	const Clock::time_point begin = Clock::now();
+	player.set_play(true);
+	const bool finished = iterate_until([&events](void) -> bool
+		{
+			return events.ended == TRACKS && events.state == PlayerState::STOP;
+		}
+	);
+	const chrono::duration<double, std::milli> played = Clock::now() - begin;
+	SPDLOG_INFO("Played {:d} streams to the end in {:.1f} ms, {:d} wakeups",
+		events.ended, played.count(), pump.wakeups()
+	);
+	if (!finished || events.started != TRACKS) {
+		SPDLOG_ERROR("{:d} of {:d} streams started, {:d} ended",
+			events.started, TRACKS, events.ended
+		);
+		++errors;
+	}
+	
+	// nothing wakes the main loop up while the player is paused
+	(void)player.append_media(FakeBackend::track_path(0, 0));
+	player.set_play(true);
+	player.set_play(false);
+	const auto paused = [&events](void) -> bool { return events.state == PlayerState::PAUSE; };
+	if (!iterate_until(paused)) {
+		SPDLOG_ERROR("The player was never paused");
+		return errors + 1;
+	}
+	const uint64_t wakeups = pump.wakeups();
+	bool idle = false;
+	Glib::signal_timeout().connect_once([&idle](void) -> void { idle = true; },
+		static_cast<unsigned int>(IDLE.count())
+	);
+	(void)iterate_until([&idle](void) -> bool { return idle; });
+	SPDLOG_INFO("{:d} wakeups in {:d} ms while paused",
+		pump.wakeups() - wakeups, IDLE.count()
+	);
+	if (pump.wakeups() != wakeups) {
+		SPDLOG_ERROR("The event pump woke up while the player was paused");
+		++errors;
+	}
+	return errors;
+}
+
+int main(void)
+{
+	Glib::init();
+	spdlog::set_level(spdlog::level::info);
+	
+	const size_t errors = command_errors() + playback_errors();
+	return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/* #Checks that closing a large playlist page doesn't hold the window back.
+! A page with 100k rows is shown then removed, while a tick callback records the time between
+two frames of the notebook. Removing the page must return right away, and no frame may be held
+back for long until the page is destroyed.
+! Exits with 77 (skipped) when there's no display to initialize GTK with.
+*/
+#include <algorithm>
+#include <glibmm/main.h>
+#include <gtkmm/application.h>
+#include <gtkmm/window.h>
+#include <momuma/spdlog.h>
+#include <vector>
+
+#include "Gui/PlaylistNotebook.h"
+
+
+using PageId = Gui::PlaylistNotebook::PageId;
+
+constexpr size_t ROW_COUNT = 100'000;
+
+constexpr chrono::milliseconds MAX_REMOVE_TIME { 5 };
+constexpr chrono::milliseconds MAX_FRAME_TIME { 50 };
+
+[[nodiscard]] static std::vector<Gui::NotebookRowData> generate_rows(void)
+{
+	std::vector<Gui::NotebookRowData> rows;
+	rows.reserve(ROW_COUNT);
+	for (size_t i = 0; i < ROW_COUNT; ++i) {
+		rows.push_back({ fmt::format("{:06d} - Artist - Title.flac", i),
+			chrono::seconds(180)
+		});
+	}
+	return rows;
+}
+
+int main(int argc, char **argv)
+{
+	spdlog::set_level(spdlog::level::info);
+	if (!gtk_init_check(&argc, &argv)) {
+		SPDLOG_WARN("No display available, skipping");
+		return 77;
+	}
+	// initializes the gtkmm wrappers
+	const Glib::RefPtr<Gtk::Application> app = Gtk::Application::create();
+	
+	Gtk::Window window;
+	window.set_default_size(800, 600);
+	Gui::PlaylistNotebook notebook;
+	window.add(notebook.w_);
+	window.show_all();
+	
+	// a second page, shown once the large one is removed
+	(void)notebook.page_create("other");
+	const PageId page = notebook.page_create("benchmark");
+	notebook.get_page(page).append_rows(generate_rows());
+	
+	using Clock = chrono::steady_clock;
+	const Glib::RefPtr<Glib::MainLoop> loop = Glib::MainLoop::create();
+	std::vector<chrono::microseconds> frames;
+	std::optional<int64_t> lastFrame;
+	
+	// keeps the frame clock running, so a frame is drawn whenever the main loop allows it
+	notebook.w_.add_tick_callback(
+		[&frames, &lastFrame](const Glib::RefPtr<Gdk::FrameClock> &clock) -> bool
+		{
+			const int64_t now = clock->get_frame_time();
+			if (lastFrame.has_value()) {
+				frames.emplace_back(now - lastFrame.value());
+			}
+			lastFrame = now;
+			return true; // keep ticking
+		}
+	);
+	Clock::time_point begin, removed, destroyed;
+	notebook.signal_page_destroyed().connect(
+		[&loop, &destroyed](PageId) -> void
+		{
+			destroyed = Clock::now();
+			loop->quit();
+		}
+	);
+	// lets the page be drawn before removing it
+	Glib::signal_timeout().connect_once(
+		[&notebook, page, &frames, &lastFrame, &begin, &removed](void) -> void
+		{
+			frames.clear();
+			lastFrame.reset();
+			begin = Clock::now();
+			notebook.page_remove(page);
+			removed = Clock::now();
+		},
+		500
+	);
+	loop->run();
+	
+	const auto toMs = [](const Clock::duration d) -> double
+	{
+		return chrono::duration<double, std::milli>(d).count();
+	};
+	const chrono::microseconds longest = frames.empty() ?
+		chrono::microseconds(0) : *std::max_element(frames.begin(), frames.end());
+	SPDLOG_INFO("Removed the page in {:.3f} ms, destroyed its {:d} rows in {:.1f} ms",
+		toMs(removed - begin), ROW_COUNT, toMs(destroyed - begin)
+	);
+	SPDLOG_INFO("{:d} frames, longest frame: {:.1f} ms", frames.size(), toMs(longest));
+	
+	if (removed - begin > MAX_REMOVE_TIME || longest > MAX_FRAME_TIME) {
+		SPDLOG_ERROR("The window doesn't stay responsive while a page is destroyed");
+		return 1;
+	}
+	return 0;
+}
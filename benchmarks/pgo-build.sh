@@ -0,0 +1,80 @@
+#!/bin/sh
+# Build the release with profile-guided optimization, and report its speedup over plain -O2 and
+# over the release without the profile.
+#
+#	benchmarks/pgo-build.sh [BUILD_DIR]
+#	meson compile -C build pgo-build
+#
+# Every build uses `release.ini`. The instrumented build replays `training.log` against the fake
+# backend, then it's built again with the profile. `playlist-ops` runs on the three builds, and
+# `compare.py` reports the change of each operation and the overall speedup, from -O2 and from
+# -O2 with LTO to LTO and PGO. Builds in BUILD_DIR (default: build-pgo), the -O2 baseline in
+# BUILD_DIR-o2 and the LTO one in BUILD_DIR-lto.
+set -eu
+
+source_dir=$(cd "$(dirname "$0")/.." && pwd)
+build_dir=${1:-build-pgo}
+baseline_dir=${build_dir}-o2
+lto_dir=${build_dir}-lto
+
+# Configure a release build, or change the options of an existing one
+setup() {
+	dir=$1
+	shift
+	if [ -d "$dir/meson-private" ]; then
+		meson configure "$@" "$dir"
+	else
+		meson setup --native-file "$source_dir/release.ini" "$@" "$dir" "$source_dir"
+	fi
+}
+
+# the training and the benchmarks need a display, a virtual one is used when there's none
+with_display() {
+	if [ -n "${DISPLAY:-}" ]; then
+		"$@"
+	else
+		xvfb-run --auto-servernum "$@"
+	fi
+}
+
+echo '==> Building the -O2 baseline'
+setup "$baseline_dir" -Db_lto=false
+meson compile -C "$baseline_dir"
+
+echo '==> Building the LTO baseline'
+setup "$lto_dir" -Db_lto=true -Db_pgo=off
+meson compile -C "$lto_dir"
+
+echo '==> Building the instrumented release'
+setup "$build_dir" -Db_pgo=generate
+meson compile -C "$build_dir"
+# profiles of a previous training would be added up with the new one
+find "$build_dir" -name '*.gcda' -delete
+
+echo '==> Training'
+# a home of its own, so neither the training nor the user's data change the other
+home=$(mktemp -d)
+trap 'rm -rf "$home"' EXIT
+with_display env HOME="$home" \
+	MOMUMA_GTK_FAKE_BACKEND='probe_us=100,seek_us=1000,speed=10' \
+	MOMUMA_GTK_REPLAY="$source_dir/benchmarks/training.log" \
+	MOMUMA_GTK_REPLAY_SPEED=0 \
+	MOMUMA_GTK_REPLAY_REPORT="$build_dir/training.json" \
+	"$build_dir/momuma-gtk"
+
+echo '==> Building the optimized release'
+setup "$build_dir" -Db_pgo=use
+meson compile -C "$build_dir"
+
+echo '==> Benchmarking'
+for dir in "$baseline_dir" "$lto_dir" "$build_dir"; do
+	with_display "$dir/benchmarks/playlist-ops" "$dir/playlist-ops.json"
+done
+# a slower operation is reported, but doesn't fail the build
+compare() {
+	echo "==> $1 => LTO+PGO"
+	"$source_dir/benchmarks/compare.py" "$2/playlist-ops.json" \
+		"$build_dir/playlist-ops.json" || true
+}
+compare -O2 "$baseline_dir"
+compare LTO "$lto_dir"
@@ -0,0 +1,97 @@
+/* #Checks that moving the playing row of a page takes constant time.
+! The playing row of models of growing sizes is moved around, counting the `row-changed`
+signals emitted and timing each move. A move must touch at most two rows, and be about as
+fast on a 100k-row page as on a 1k-row one.
+! The timings depend on the load of the machine, so a slower move only fails when it's slow
+enough to have walked the page (`MAX_NS_PER_MOVE`), otherwise it's only reported.
+! Exits with 77 (skipped) when there's no display to initialize GTK with.
+*/
+#include <array>
+#include <gtkmm/application.h>
+#include <momuma/spdlog.h>
+#include <vector>
+
+#include "Gui/PlaylistModel.h"
+
+
+constexpr std::array<size_t, 3> PAGE_SIZES = { 1'000, 10'000, 100'000 };
+constexpr size_t MOVES = 100'000;
+
+// slower than this compared to the smallest page means the cost depends on the page's size
+constexpr double MAX_SLOWDOWN = 10.0;
+// a constant time move takes about a hundred ns, walking 100k rows takes tens of µs
+constexpr double MAX_NS_PER_MOVE = 5'000.0;
+
+struct Result
+{
+	double nsPerMove;
+	double signalsPerMove;
+};
+
+[[nodiscard]] static Result measure(const size_t pageSize)
+{
+	const Glib::RefPtr<Gui::PlaylistModel> model = Gui::PlaylistModel::create();
+	const std::vector<Gui::NotebookRowData> rows(pageSize,
+		Gui::NotebookRowData { "row", chrono::seconds(180) }
+	);
+	model->append(rows);
+	
+	size_t signals = 0;
+	model->signal_row_changed().connect(
+		[&signals](const Gtk::TreePath&, const Gtk::TreeIter&) -> void { ++signals; }
+	);
+	
+	using Clock = chrono::steady_clock;
+	const Clock::time_point begin = Clock::now();
+	for (size_t i = 0; i < MOVES; ++i) {
+		// jump all over the page, so nothing stays in the cache
+		model->set_playing_row((i * 7919) % pageSize);
+	}
+	const chrono::duration<double, std::nano> elapsed = Clock::now() - begin;
+	
+	return {
+		elapsed.count() / static_cast<double>(MOVES),
+		static_cast<double>(signals) / static_cast<double>(MOVES),
+	};
+}
+
+int main(int argc, char **argv)
+{
+	spdlog::set_level(spdlog::level::info);
+	if (!gtk_init_check(&argc, &argv)) {
+		SPDLOG_WARN("No display available, skipping");
+		return 77;
+	}
+	// initializes the gtkmm wrappers
+	const Glib::RefPtr<Gtk::Application> app = Gtk::Application::create();
+	
+	std::vector<Result> results;
+	for (const size_t pageSize : PAGE_SIZES) {
+		results.push_back(measure(pageSize));
+		SPDLOG_INFO("{:>7d} rows: {:.1f} ns/move, {:.2f} row-changed/move",
+			pageSize, results.back().nsPerMove, results.back().signalsPerMove
+		);
+	}
+	
+	int failures = 0;
+	for (size_t i = 0; i < results.size(); ++i) {
+		if (results[i].signalsPerMove > 2.0) {
+			SPDLOG_ERROR("{:d} rows: more than 2 rows changed per move", PAGE_SIZES[i]);
+			++failures;
+		}
+		if (results[i].nsPerMove <= results.front().nsPerMove * MAX_SLOWDOWN) { continue; }
+		
+		const double slowdown = results[i].nsPerMove / results.front().nsPerMove;
+		if (results[i].nsPerMove > MAX_NS_PER_MOVE) {
+			SPDLOG_ERROR("{:d} rows: {:.1f}x slower than {:d} rows", PAGE_SIZES[i],
+				slowdown, PAGE_SIZES.front()
+			);
+			++failures;
+		} else {
+			SPDLOG_WARN("{:d} rows: {:.1f}x slower than {:d} rows, under {:.0f} ns",
+				PAGE_SIZES[i], slowdown, PAGE_SIZES.front(), MAX_NS_PER_MOVE
+			);
+		}
+	}
+	return failures == 0 ? 0 : 1;
+}
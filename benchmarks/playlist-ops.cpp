@@ -0,0 +1,323 @@
+/* #Times the operations of a playlist page at 1k, 10k and 100k rows.
+! Each operation is run `RUNS` times per size on a synthetic playlist, and the results are
+written as JSON to the file given as the first argument, for `compare.py` to find regressions:
+- add_playlist: `PlaylistOpener::open()`, which `add_playlist_to_view()` calls, until the page
+  is loaded. The paths are read from the database of a `FakeBackend`, whose files don't exist:
+  none is found in the `MetadataCache`, and every row is probed in the background, as in the
+  application run with the fake backend.
+- row_activated: `RowPlayer::play()`, which `cb__row_activated()` calls, timed per activation.
+  The player is the one of a `FakeBackend`, so nothing is played.
+- mark_rows / get_rows: over every row of the page.
+- page_remove: the call, then page_teardown until the page is destroyed.
+- scroll: drawing a `PlaylistTreeView` one screen at a time, from its first row to its last.
+! Exits with 77 (skipped) when there's no display to initialize GTK with, run the benchmarks
+with `--setup=xvfb` to get one.
+*/
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fmt/ranges.h>
+#include <fstream>
+#include <glibmm/main.h>
+#include <gtkmm/application.h>
+#include <gtkmm/offscreenwindow.h>
+#include <gtkmm/scrolledwindow.h>
+#include <momuma/spdlog.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "DatabaseService.h"
+#include "FakeBackend.h"
+#include "Gui/PlaylistNotebook.h"
+#include "Gui/PlaylistTreeView.h"
+#include "MetadataCache.h"
+#include "PlaybackWindow.h"
+#include "PlayerEventPump.h"
+#include "PlaylistLoader.h"
+#include "PlaylistOpener.h"
+#include "RowPlayer.h"
+
+
+using PageId = Gui::PlaylistNotebook::PageId;
+using Clock = chrono::steady_clock;
+
+constexpr std::array<size_t, 3> SIZES { 1'000, 10'000, 100'000 };
+constexpr size_t RUNS = 5;
+constexpr size_t ACTIVATIONS = 1'000; // per run
+
+constexpr int WIDTH = 800;
+constexpr int HEIGHT = 600;
+
+// The fake player, as the application drives it
+struct Player
+{
+	Backend::Player &player;
+	PlaybackWindow &playback;
+	RowPlayer &rows;
+};
+
+// Opens the pages, as the application does
+struct Opener
+{
+	PageMap &pages;
+	PlaylistOpener &opener;
+	PlaylistLoader &loader;
+};
+
+// The times of an operation at a size, in milliseconds
+struct Result
+{
+	std::string name;
+	size_t rows;
+	std::vector<double> runs;
+};
+
+[[nodiscard]] static std::vector<Gui::NotebookRowData> generate_rows(const size_t count)
+{
+	std::vector<Gui::NotebookRowData> rows;
+	rows.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		const chrono::seconds duration = (i % 7 == 0) ?
+			Gui::NotebookRowData::UNKNOWN_DURATION : chrono::seconds(120 + i % 300);
+		rows.push_back({ fmt::format("{:06d} - Artist - Title.flac", i), duration });
+	}
+	return rows;
+}
+
+[[nodiscard]] static inline double to_ms(const Clock::duration d)
+{
+	return chrono::duration<double, std::milli>(d).count();
+}
+
+template <typename Func>
+[[nodiscard]] static double time_ms(Func &&func)
+{
+	const Clock::time_point begin = Clock::now();
+	func();
+	return to_ms(Clock::now() - begin);
+}
+
+// Run what the main loop has pending, without waiting for more.
+static void drain_main_loop(void)
+{
+	const Glib::RefPtr<Glib::MainContext> context = Glib::MainContext::get_default();
+	while (context->pending()) { context->iteration(false); }
+}
+
+// Open a playlist as `add_playlist_to_view()` does, and wait until its page is loaded.
+[[nodiscard]] static PageId add_playlist(Opener &opener, const Glib::ustring &playlist)
+{
+	const Glib::RefPtr<Glib::MainLoop> loop = Glib::MainLoop::create();
+	PageId id = PageId::Null;
+	bool done = false;
+	sigc::connection loaded = opener.loader.signal_loaded().connect(
+		[&loop, &id, &done](const PageId page) -> void
+		{
+			if (page != id) { return; }
+			done = true;
+			loop->quit();
+		}
+	);
+	id = opener.opener.open(playlist);
+	if (!done) { loop->run(); }
+	loaded.disconnect();
+	return id;
+}
+
+static void run_page_operations(Gui::PlaylistNotebook &notebook, Player &player,
+	Opener &opener, const Glib::ustring &playlist, const size_t rows,
+	std::array<Result, 6> &results
+) {
+	auto &[add, activate, mark, get, removal, teardown] = results;
+	
+	PageId id = PageId::Null;
+	add.runs.push_back(time_ms(
+		[&opener, &playlist, &id](void) -> void { id = add_playlist(opener, playlist); }
+	));
+	notebook.page_focus(id);
+	drain_main_loop();
+	const Gui::NotebookPageProxy page = notebook.get_page(id);
+	const PlaybackWindow::Paths paths = opener.pages.at(id).paths;
+	if (!paths || page.size() != rows || paths->size() != rows) {
+		SPDLOG_ERROR("Loaded {:d} rows of {:d} paths, expected {:d}", page.size(),
+			paths ? paths->size() : 0, rows
+		);
+		std::abort();
+	}
+	
+	// the rows of a shuffled playlist, with a fixed seed
+	uint64_t seed = 0x9E3779B97F4A7C15;
+	activate.runs.push_back(time_ms(
+		[id, &player, &paths, &seed](void) -> void
+		{
+			for (size_t i = 0; i < ACTIVATIONS; ++i) {
+				seed = seed * 6364136223846793005 + 1442695040888963407;
+				const size_t row = (seed >> 33) % paths->size();
+				player.rows.play(id, paths, row);
+			}
+		}
+	) / ACTIVATIONS);
+	drain_main_loop();
+	player.player.stop_playback();
+	player.playback.reset();
+	
+	mark.runs.push_back(time_ms(
+		[&page](void) -> void { page.mark_rows(Gui::NotebookColBit::All); }
+	));
+	get.runs.push_back(time_ms(
+		[&page, rows](void) -> void
+		{
+			const std::vector<Gui::NotebookRowProxy> proxies = page.get_rows();
+			if (proxies.size() != rows) { std::abort(); }
+		}
+	));
+	
+	const Glib::RefPtr<Glib::MainLoop> loop = Glib::MainLoop::create();
+	sigc::connection destroyed = notebook.signal_page_destroyed().connect(
+		[&loop](PageId) -> void { loop->quit(); }
+	);
+	const Clock::time_point begin = Clock::now();
+	notebook.page_remove(id);
+	removal.runs.push_back(to_ms(Clock::now() - begin));
+	loop->run();
+	teardown.runs.push_back(to_ms(Clock::now() - begin));
+	destroyed.disconnect();
+}
+
+[[nodiscard]] static double time_full_scroll(const std::vector<Gui::NotebookRowData> &rows)
+{
+	Gtk::OffscreenWindow window;
+	window.set_default_size(WIDTH, HEIGHT);
+	Gtk::ScrolledWindow scroller;
+	Gui::PlaylistTreeView view;
+	scroller.add(view);
+	window.add(scroller);
+	view.get_playlist_model().append(rows);
+	window.show_all();
+	drain_main_loop();
+	
+	const auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, WIDTH, HEIGHT);
+	const auto cr = Cairo::Context::create(surface);
+	const Glib::RefPtr<Gtk::Adjustment> adjustment = scroller.get_vadjustment();
+	return time_ms(
+		[&scroller, &adjustment, &cr](void) -> void
+		{
+			const double end = adjustment->get_upper() - adjustment->get_page_size();
+			for (double top = 0.0; ; top += adjustment->get_page_size()) {
+				adjustment->set_value(std::min(top, end));
+				drain_main_loop();
+				scroller.draw(cr);
+				if (top >= end) { break; }
+			}
+		}
+	);
+}
+
+[[nodiscard]] static double median(std::vector<double> runs)
+{
+	std::sort(runs.begin(), runs.end());
+	return runs[runs.size() / 2];
+}
+
+static bool write_json(const fs::path &file, const std::vector<Result> &results)
+{
+	std::string json = "{\n\t\"benchmark\": \"playlist-ops\",\n\t\"unit\": \"ms\",\n"
+		"\t\"results\": [\n";
+	for (const Result &result : results) {
+		json += fmt::format("\t\t{{ \"name\": \"{:s}\", \"rows\": {:d}, "
+			"\"median\": {:.6f}, \"min\": {:.6f}, \"max\": {:.6f}, "
+			"\"runs\": [{:.6f}] }}{:s}\n",
+			result.name, result.rows, median(result.runs),
+			*std::min_element(result.runs.begin(), result.runs.end()),
+			*std::max_element(result.runs.begin(), result.runs.end()),
+			fmt::join(result.runs, ", "), &result == &results.back() ? "" : ","
+		);
+	}
+	json += "\t]\n}\n";
+	
+	std::ofstream out(file, std::ios::trunc);
+	out << json;
+	if (!out.flush()) {
+		SPDLOG_ERROR("Failed to write '{:s}'", file.string());
+		return false;
+	}
+	SPDLOG_INFO("Results written to '{:s}'", file.string());
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	spdlog::set_level(spdlog::level::info);
+	if (!gtk_init_check(&argc, &argv)) {
+		SPDLOG_WARN("No display available, skipping");
+		return 77;
+	}
+	// initializes the gtkmm wrappers
+	const Glib::RefPtr<Gtk::Application> app = Gtk::Application::create();
+	const fs::path file = (argc > 1) ? argv[1] : "playlist-ops.json";
+	
+	Gtk::OffscreenWindow window;
+	window.set_default_size(WIDTH, HEIGHT);
+	Gui::PlaylistNotebook notebook;
+	window.add(notebook.w_);
+	window.show_all();
+	// a page left behind, so removing the other one shows something else
+	(void)notebook.page_create("other");
+	
+	FakeBackend::Config config;
+	config.playlists = std::vector<size_t>(SIZES.begin(), SIZES.end());
+	config.seekLatency = chrono::microseconds(0);
+	FakeBackend backend(config);
+	PageMap pages;
+	pages.connect_page_destroyed(notebook);
+	
+	Backend::Player &backendPlayer = backend.get_player();
+	PlaybackWindow playback(backendPlayer);
+	PlayerEventPump pump(backendPlayer);
+	RowPlayer rowPlayer(notebook, pages, backendPlayer, playback, pump);
+	Player player { backendPlayer, playback, rowPlayer };
+	
+	DatabaseService database;
+	database.attach(backend.get_database());
+	// never saved, the fake backend's files are never found in it anyway
+	MetadataCache cache(fs::temp_directory_path()
+		/ fmt::format("momuma-gtk-ops-cache-{:d}.bin", ::getpid())
+	);
+	MediaProber prober(FakeBackend::make_probe(config));
+	TaskScheduler scheduler(window);
+	PlaylistLoader playlistLoader(notebook, prober, scheduler);
+	PlaylistOpener playlistOpener(notebook, pages, database, cache, prober, playlistLoader);
+	notebook.signal_page_remove().connect(sigc::mem_fun(prober, &MediaProber::cancel));
+	notebook.signal_page_remove().connect(
+		sigc::mem_fun(scheduler, &TaskScheduler::cancel_page)
+	);
+	Opener opener { pages, playlistOpener, playlistLoader };
+	
+	std::vector<Result> results;
+	for (size_t i = 0; i < SIZES.size(); ++i) {
+		const size_t size = SIZES[i];
+		const Glib::ustring playlist = FakeBackend::playlist_name(i, size);
+		const std::vector<Gui::NotebookRowData> rows = generate_rows(size);
+		std::array<Result, 6> ops {
+			Result { "add_playlist", size, { } }, Result { "row_activated", size, { } },
+			Result { "mark_rows", size, { } }, Result { "get_rows", size, { } },
+			Result { "page_remove", size, { } }, Result { "page_teardown", size, { } },
+		};
+		Result scroll { "scroll", size, { } };
+		for (size_t run = 0; run < RUNS; ++run) {
+			run_page_operations(notebook, player, opener, playlist, size, ops);
+			scroll.runs.push_back(time_full_scroll(rows));
+		}
+		
+		for (Result &result : ops) { results.push_back(std::move(result)); }
+		results.push_back(std::move(scroll));
+	}
+	
+	for (const Result &result : results) {
+		SPDLOG_INFO("{:<14s} {:>7d} rows: {:>10.3f} ms", result.name, result.rows,
+			median(result.runs)
+		);
+	}
+	return write_json(file, results) ? 0 : 1;
+}
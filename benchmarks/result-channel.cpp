@@ -0,0 +1,126 @@
+/* #Stress test of `MainLoopChannel`, from every core to the main loop.
+! One thread per core pushes messages for a handful of pages as fast as it can, while the main
+loop drains them and coalesces them into one update per page and batch. A 1 ms heartbeat timer
+measures how long the main loop is kept from running anything else.
+! Fails when a message is lost, duplicated or received out of order.
+*/
+#include <algorithm>
+#include <array>
+#include <glibmm/init.h>
+#include <glibmm/main.h>
+#include <momuma/spdlog.h>
+#include <thread>
+#include <vector>
+
+#include "MainLoopChannel.h"
+
+
+constexpr size_t MESSAGES = 4'000'000;
+constexpr size_t CAPACITY = 4096;
+constexpr size_t PAGES = 16;
+
+struct Message
+{
+	uint32_t producer;
+	uint32_t page;
+	uint64_t sequence; // per producer
+};
+
+using Clock = chrono::steady_clock;
+
+int main(void)
+{
+	spdlog::set_level(spdlog::level::info);
+	Glib::init();
+	const Glib::RefPtr<Glib::MainLoop> loop = Glib::MainLoop::create();
+	
+	const size_t producers = std::max(std::thread::hardware_concurrency(), 1U);
+	const size_t perProducer = MESSAGES / producers;
+	const size_t total = perProducer * producers;
+	
+	MainLoopChannel<Message> channel(CAPACITY);
+	
+	std::vector<uint64_t> expected(producers, 0);
+	size_t received = 0, batches = 0, pageUpdates = 0, errors = 0;
+	Clock::duration longestDrain { 0 };
+	channel.connect(
+		[&](const std::span<Message> batch) -> void
+		{
+			const Clock::time_point drainStart = Clock::now();
+			std::array<size_t, PAGES> perPage {};
+			for (const Message &message : batch) {
+				if (message.sequence != expected[message.producer]++) { ++errors; }
+				++perPage[message.page];
+			}
+			// what a model update per page would be
+			pageUpdates += static_cast<size_t>(
+				std::count_if(perPage.begin(), perPage.end(),
+					[](const size_t count) -> bool { return count > 0; }
+				)
+			);
+			received += batch.size();
+			++batches;
+			longestDrain = std::max(longestDrain, Clock::now() - drainStart);
+			
+			if (received >= total) { loop->quit(); }
+		}
+	);
+	
+	// the longest time the main loop couldn't dispatch a 1 ms timer
+	Clock::time_point lastBeat = Clock::now();
+	Clock::duration longestStall { 0 };
+	sigc::connection heartbeat = Glib::signal_timeout().connect(
+		[&lastBeat, &longestStall](void) -> bool
+		{
+			const Clock::time_point now = Clock::now();
+			const Clock::duration late = now - lastBeat - chrono::milliseconds(1);
+			longestStall = std::max(longestStall, late);
+			lastBeat = now;
+			return true;
+		},
+		1
+	);
+	
+	const Clock::time_point begin = Clock::now();
+	std::vector<std::jthread> threads;
+	threads.reserve(producers);
+	for (size_t p = 0; p < producers; ++p) {
+		threads.emplace_back(
+			[&channel, p, perProducer](void) -> void
+			{
+				for (uint64_t i = 0; i < perProducer; ++i) {
+					channel.push({ static_cast<uint32_t>(p),
+						static_cast<uint32_t>((p + i) % PAGES), i
+					});
+				}
+			}
+		);
+	}
+	loop->run();
+	const chrono::duration<double> elapsed = Clock::now() - begin;
+	heartbeat.disconnect();
+	threads.clear(); // joins
+	
+	const auto toMs = [](const Clock::duration d) -> double
+	{
+		return chrono::duration<double, std::milli>(d).count();
+	};
+	SPDLOG_INFO("{:d} messages from {:d} threads in {:.3f} s: {:.2f} M messages/s",
+		received, producers, elapsed.count(),
+		static_cast<double>(received) / elapsed.count() / 1e6
+	);
+	SPDLOG_INFO("{:d} batches of {:.1f} messages, coalesced into {:d} page updates",
+		batches, static_cast<double>(received) / static_cast<double>(batches), pageUpdates
+	);
+	SPDLOG_INFO("Longest drain: {:.3f} ms, longest main loop stall: {:.3f} ms",
+		toMs(longestDrain), toMs(longestStall)
+	);
+	
+	if (errors > 0 || received != total) {
+		SPDLOG_ERROR("{:d} messages out of order, {:d} received out of {:d}",
+			errors, received, total
+		);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,145 @@
+/* #Measures how long restoring a session of 20 pages takes, up to the first frame.
+! A snapshot of 20 pages with 5000 rows each is written, then restored the way the application
+does it: every page is added as a placeholder, and only the shown one gets its rows from the
+memory-mapped snapshot. Fails when the window isn't drawn within `MAX_RESTORE_TIME`, or when a
+restored row differs from the saved one.
+! Exits with 77 (skipped) when there's no display to initialize GTK with.
+*/
+#include <glibmm/main.h>
+#include <gtkmm/application.h>
+#include <gtkmm/window.h>
+#include <momuma/spdlog.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Gui/PlaylistNotebook.h"
+#include "SessionSnapshot.h"
+
+
+using PageId = Gui::PlaylistNotebook::PageId;
+
+constexpr size_t PAGE_COUNT = 20;
+constexpr size_t ROW_COUNT = 5000; // per page
+constexpr size_t CURRENT_PAGE = 7;
+
+constexpr chrono::milliseconds MAX_RESTORE_TIME { 200 };
+
+[[nodiscard]] static std::string row_name(const size_t page, const size_t row)
+{
+	return fmt::format("{:02d}-{:04d} - Artist - Title", page, row);
+}
+
+static bool write_snapshot(const fs::path &file)
+{
+	SessionSnapshot::Builder builder;
+	for (size_t page = 0; page < PAGE_COUNT; ++page) {
+		builder.add_page(fmt::format("Playlist {:d}", page), page * 10);
+		for (size_t row = 0; row < ROW_COUNT; ++row) {
+			const std::string name = row_name(page, row);
+			builder.add_row("/music/library/" + name + ".flac", name,
+				chrono::seconds(180 + row % 60)
+			);
+		}
+		if (page == CURRENT_PAGE) { builder.mark_current(); }
+	}
+	builder.set_volume(50.0);
+	return builder.write(file);
+}
+
+int main(int argc, char **argv)
+{
+	spdlog::set_level(spdlog::level::info);
+	if (!gtk_init_check(&argc, &argv)) {
+		SPDLOG_WARN("No display available, skipping");
+		return 77;
+	}
+	// initializes the gtkmm wrappers
+	const Glib::RefPtr<Gtk::Application> app = Gtk::Application::create();
+	
+	const fs::path file = fs::temp_directory_path()
+		/ fmt::format("momuma-gtk-session-{:d}.bin", ::getpid());
+	if (!write_snapshot(file)) { return 1; }
+	
+	using Clock = chrono::steady_clock;
+	const Clock::time_point begin = Clock::now();
+	
+	SessionSnapshot session(file);
+	const Clock::time_point mapped = Clock::now();
+	
+	Gtk::Window window;
+	window.set_default_size(800, 600);
+	Gui::PlaylistNotebook notebook;
+	window.add(notebook.w_);
+	
+	std::vector<PageId> ids;
+	for (size_t i = 0; i < session.page_count(); ++i) {
+		Pango::AttrList attrs;
+		ids.push_back(notebook.page_create_placeholder(
+			Glib::ustring(std::string(session.page(i).name)), attrs
+		));
+		notebook.page_focus(ids.back());
+	}
+	
+	const size_t current = session.current_page().value_or(0);
+	const SessionSnapshot::Page page = session.page(current);
+	std::vector<Gui::NotebookRowData> rows;
+	rows.reserve(page.rows);
+	for (size_t i = 0; i < page.rows; ++i) {
+		const SessionSnapshot::Row row = session.row(current, i);
+		rows.push_back({ Glib::ustring(std::string(row.name)), row.duration });
+	}
+	notebook.page_focus(ids[current]);
+	notebook.page_create_view(ids[current]);
+	notebook.get_page(ids[current]).append_rows(rows);
+	notebook.page_restore_view_state(ids[current], Gui::PageViewState { page.topRow, { } });
+	window.show_all();
+	const Clock::time_point restored = Clock::now();
+	
+	const Glib::RefPtr<Glib::MainLoop> loop = Glib::MainLoop::create();
+	Clock::time_point drawn;
+	notebook.w_.add_tick_callback(
+		[&loop, &drawn](const Glib::RefPtr<Gdk::FrameClock>&) -> bool
+		{
+			drawn = Clock::now();
+			loop->quit();
+			return false;
+		}
+	);
+	loop->run();
+	
+	size_t errors = 0;
+	notebook.get_page(ids[current]).read_rows(0, ROW_COUNT,
+		[&errors](const size_t row, const char *name, const chrono::seconds duration)
+			-> void
+		{
+			if (name != row_name(CURRENT_PAGE, row)
+				|| duration != chrono::seconds(180 + row % 60)
+			) {
+				++errors;
+			}
+		}
+	);
+	session.close();
+	fs::remove(file);
+	
+	const auto toMs = [](const Clock::duration d) -> double
+	{
+		return chrono::duration<double, std::milli>(d).count();
+	};
+	SPDLOG_INFO("Mapped the session in {:.3f} ms, restored {:d} pages in {:.1f} ms",
+		toMs(mapped - begin), ids.size(), toMs(restored - begin)
+	);
+	SPDLOG_INFO("First frame after {:.1f} ms", toMs(drawn - begin));
+	
+	if (errors > 0 || notebook.get_page(ids[current]).size() != ROW_COUNT) {
+		SPDLOG_ERROR("{:d} rows weren't restored as they were saved", errors);
+		return 1;
+	}
+	if (drawn - begin > MAX_RESTORE_TIME) {
+		SPDLOG_ERROR("Restoring the session took longer than {:d} ms",
+			MAX_RESTORE_TIME.count()
+		);
+		return 1;
+	}
+	return 0;
+}
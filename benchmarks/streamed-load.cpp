@@ -0,0 +1,121 @@
+/* #Checks that the window keeps drawing frames while a large playlist is loaded.
+! A 100k-row playlist is streamed into a shown page by a `PlaylistLoader`, while a tick
+callback records the time between two frames of the view. Most frames must come at 60 fps,
+and none may be held back for long by the loading.
+! Exits with 77 (skipped) when there's no display to initialize GTK with.
+*/
+#include <algorithm>
+#include <glibmm/main.h>
+#include <gtkmm/application.h>
+#include <gtkmm/window.h>
+#include <momuma/spdlog.h>
+#include <vector>
+
+#include "MediaDuration.h"
+#include "PlaylistLoader.h"
+
+
+constexpr size_t ROW_COUNT = 100'000;
+
+// a 60 fps frame, with some slack for the compositor
+constexpr chrono::microseconds FRAME_TIME { 1'000'000 / 60 + 4'000 };
+// frames allowed to be late, GTK itself drops a few when the scrollbar is resized
+constexpr double MAX_LATE_RATIO = 0.05;
+constexpr chrono::milliseconds MAX_FRAME_TIME { 100 };
+
+[[nodiscard]] static PlaylistLoader::Paths generate_paths(void)
+{
+	auto paths = std::make_shared<std::vector<fs::path>>();
+	paths->reserve(ROW_COUNT);
+	for (size_t i = 0; i < ROW_COUNT; ++i) {
+		paths->push_back(fmt::format("/music/{:06d} - Artist - Title.flac", i));
+	}
+	return paths;
+}
+
+int main(int argc, char **argv)
+{
+	spdlog::set_level(spdlog::level::info);
+	if (!gtk_init_check(&argc, &argv)) {
+		SPDLOG_WARN("No display available, skipping");
+		return 77;
+	}
+	// initializes the gtkmm wrappers
+	const Glib::RefPtr<Gtk::Application> app = Gtk::Application::create();
+	
+	Gtk::Window window;
+	window.set_default_size(800, 600);
+	Gui::PlaylistNotebook notebook;
+	window.add(notebook.w_);
+	window.show_all();
+	
+	MediaProber prober(Media::query_duration);
+	TaskScheduler scheduler(window);
+	PlaylistLoader loader(notebook, prober, scheduler);
+	const PageId page = notebook.page_create("benchmark");
+	
+	using Clock = chrono::steady_clock;
+	const Glib::RefPtr<Glib::MainLoop> loop = Glib::MainLoop::create();
+	std::vector<chrono::microseconds> frames;
+	std::optional<int64_t> lastFrame;
+	Clock::time_point end;
+	
+	// keeps the frame clock running, so a frame is drawn whenever the main loop allows it
+	notebook.w_.add_tick_callback(
+		[&frames, &lastFrame](const Glib::RefPtr<Gdk::FrameClock> &clock) -> bool
+		{
+			const int64_t now = clock->get_frame_time();
+			if (lastFrame.has_value()) {
+				frames.emplace_back(now - lastFrame.value());
+			}
+			lastFrame = now;
+			return true; // keep ticking
+		}
+	);
+	loader.signal_loaded().connect(
+		[&loop, &end](PageId) -> void
+		{
+			end = Clock::now();
+			loop->quit();
+		}
+	);
+	
+	const Clock::time_point begin = Clock::now();
+	loader.load(page, generate_paths(),
+		[](const fs::path &path) -> std::optional<Gui::NotebookRowData>
+		{
+			// as if every row was in the metadata cache
+			return Gui::NotebookRowData {
+				path.filename().string(), chrono::seconds(180)
+			};
+		}
+	);
+	loop->run();
+	const chrono::duration<double, std::milli> elapsed = end - begin;
+	
+	if (notebook.get_page(page).size() != ROW_COUNT || frames.empty()) {
+		SPDLOG_ERROR("Loaded {:d} rows in {:d} frames", notebook.get_page(page).size(),
+			frames.size()
+		);
+		return 1;
+	}
+	
+	const size_t late = static_cast<size_t>(std::count_if(frames.begin(), frames.end(),
+		[](const chrono::microseconds frame) -> bool { return frame > FRAME_TIME; }
+	));
+	const chrono::microseconds longest = *std::max_element(frames.begin(), frames.end());
+	const double lateRatio = static_cast<double>(late) / static_cast<double>(frames.size());
+	
+	SPDLOG_INFO("Loaded {:d} rows in {:.1f} ms, {:d} frames", ROW_COUNT, elapsed.count(),
+		frames.size()
+	);
+	SPDLOG_INFO("Late frames: {:d} ({:.1f}%), longest frame: {:.1f} ms", late, lateRatio * 100,
+		chrono::duration<double, std::milli>(longest).count()
+	);
+	
+	if (lateRatio > MAX_LATE_RATIO || longest > MAX_FRAME_TIME) {
+		SPDLOG_ERROR("The window doesn't stay responsive while loading");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,207 @@
+/* #Counts the heap allocations made while rendering the rows of a `Gui::PlaylistTreeView`.
+! Every row of a playlist is pushed through the cell data functions of the view, the same way
+GTK does it when drawing, and every `malloc()` done on the main thread is counted.
+! The result is compared against a floor whose cell data functions set nothing, what GTK
+allocates per cell on its own. On top of that, the view allocates once per text a renderer is
+given: `GtkCellRendererText` copies its text, and offers no way around it. So rendering a row
+isn't allocation-free, and the benchmark fails when it allocates more than those copies.
+! Exits with 77 (skipped) when there's no display to initialize GTK with.
+*/
+#include <array>
+#include <gtkmm/application.h>
+#include <gtkmm/cellrenderertext.h>
+#include <momuma/spdlog.h>
+#include <vector>
+
+#include "Gui/PlaylistTreeView.h"
+
+#if defined(__SANITIZE_ADDRESS__)
+	#define HAS_ASAN 1
+#elif defined(__has_feature)
+	#if __has_feature(address_sanitizer)
+		#define HAS_ASAN 1
+	#endif
+#endif
+#ifndef HAS_ASAN
+	#define HAS_ASAN 0
+#endif
+
+#if HAS_ASAN
+	#include <sanitizer/allocator_interface.h>
+#endif
+
+
+constexpr size_t ROW_COUNT = 10'000;
+constexpr int RENDER_ROUNDS = 20;
+
+// only the allocations of the main thread are counted, GTK has a few threads of its own
+static thread_local bool t_counting = false;
+static thread_local size_t t_allocations = 0;
+
+#if HAS_ASAN
+
+static void hook_malloc(const volatile void*, size_t)
+{
+	if (t_counting) { ++t_allocations; }
+}
+
+static void hook_free(const volatile void*)
+{
+}
+
+#else
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void *ptr, size_t size);
+
+extern "C" void* malloc(size_t size)
+{
+	if (t_counting) { ++t_allocations; }
+	return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+	if (t_counting) { ++t_allocations; }
+	return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void *ptr, size_t size)
+{
+	if (t_counting) { ++t_allocations; }
+	return __libc_realloc(ptr, size);
+}
+
+#endif
+
+// Count the allocations done by `func` on the calling thread
+template <typename Func>
+[[nodiscard]] static size_t count_allocations(Func &&func)
+{
+	t_allocations = 0;
+	t_counting = true;
+	func();
+	t_counting = false;
+	return t_allocations;
+}
+
+[[nodiscard]] static std::vector<Gui::NotebookRowData> generate_rows(void)
+{
+	std::vector<Gui::NotebookRowData> rows;
+	rows.reserve(ROW_COUNT);
+	for (size_t i = 0; i < ROW_COUNT; ++i) {
+		// a mix of unknown durations, minutes and hours
+		const chrono::seconds duration = (i % 7 == 0) ?
+			Gui::NotebookRowData::UNKNOWN_DURATION :
+			chrono::seconds((i * 37) % (i % 5 == 0 ? 20'000 : 3'600));
+		rows.push_back({ fmt::format("{:05d} - Artist - Title.flac", i), duration });
+	}
+	return rows;
+}
+
+int main(int argc, char **argv)
+{
+	spdlog::set_level(spdlog::level::info);
+	if (!gtk_init_check(&argc, &argv)) {
+		SPDLOG_WARN("No display available, skipping");
+		return 77;
+	}
+	// initializes the gtkmm wrappers
+	const Glib::RefPtr<Gtk::Application> app = Gtk::Application::create();
+#if HAS_ASAN
+	__sanitizer_install_malloc_and_free_hooks(&hook_malloc, &hook_free);
+#endif
+
+	Gui::PlaylistTreeView view;
+	Gui::PlaylistModel &model = view.get_playlist_model();
+	model.append(generate_rows());
+	const Glib::RefPtr<Gtk::TreeModel> treeModel = view.get_model();
+	const auto columns = view.get_render_columns();
+	
+	const auto render_all_rows = [&model, &treeModel, &columns](void) -> void
+	{
+		for (size_t row = 0; row < ROW_COUNT; ++row) {
+			const Gtk::TreeIter iter = model.index_to_iter(row);
+			for (Gtk::TreeViewColumn *column : columns) {
+				column->cell_set_cell_data(treeModel, iter, false, false);
+			}
+		}
+	};
+	
+	// what GTK allocates for the same cells, with data functions that set nothing
+	std::array<Gtk::TreeViewColumn, 3> floorColumns;
+	for (Gtk::TreeViewColumn &column : floorColumns) {
+		auto *renderer = Gtk::make_managed<Gtk::CellRendererText>();
+		column.pack_start(*renderer, true);
+		column.set_cell_data_func(*renderer,
+			[](Gtk::CellRenderer*, const Gtk::TreeIter&) -> void {}
+		);
+	}
+	const auto render_floor = [&model, &treeModel, &floorColumns](void) -> void
+	{
+		for (size_t row = 0; row < ROW_COUNT; ++row) {
+			const Gtk::TreeIter iter = model.index_to_iter(row);
+			for (Gtk::TreeViewColumn &column : floorColumns) {
+				column.cell_set_cell_data(treeModel, iter, false, false);
+			}
+		}
+	};
+	
+	// what a renderer allocates when given a text, without the view
+	Gtk::CellRendererText textRenderer;
+	const auto set_text = [&textRenderer](void) -> void
+	{
+		GValue text = G_VALUE_INIT;
+		g_value_init(&text, G_TYPE_STRING);
+		g_value_set_static_string(&text, "00:00");
+		g_object_set_property(G_OBJECT(textRenderer.gobj()), "text", &text);
+		g_value_unset(&text);
+	};
+	
+	// the first pass sets the attribute lists of the renderers, which isn't done per row
+	render_all_rows();
+	render_floor();
+	set_text();
+	const size_t viewAllocations = count_allocations(render_all_rows);
+	const size_t floorAllocations = count_allocations(render_floor);
+	const size_t textAllocations = count_allocations(set_text);
+	// one text per cell, the renderers' copies are all the view may allocate
+	const size_t copyAllocations = textAllocations * columns.size() * ROW_COUNT;
+	
+	// marked rows switch the attribute lists back and forth
+	for (size_t row = 0; row < ROW_COUNT; row += 16) {
+		model.set_marked(row, Gui::NotebookColBit::All);
+	}
+	const size_t markedAllocations = count_allocations(render_all_rows);
+	
+	using Clock = chrono::steady_clock;
+	const Clock::time_point begin = Clock::now();
+	for (int round = 0; round < RENDER_ROUNDS; ++round) {
+		render_all_rows();
+	}
+	const chrono::duration<double, std::nano> elapsed = Clock::now() - begin;
+	
+	const auto perRow = [](const size_t allocations) -> double
+	{
+		return static_cast<double>(allocations) / static_cast<double>(ROW_COUNT);
+	};
+	const size_t rowAllocations = viewAllocations
+		- std::min(viewAllocations, floorAllocations);
+	SPDLOG_INFO("Allocations per row: {:.3f} (GTK floor {:.3f}, {:.3f} with marked rows)",
+		perRow(viewAllocations), perRow(floorAllocations), perRow(markedAllocations)
+	);
+	SPDLOG_INFO("Allocations per row by the cell data functions: {:.3f} "
+		"({:.3f} for the renderers' copies of the texts)",
+		perRow(rowAllocations), perRow(copyAllocations)
+	);
+	SPDLOG_INFO("Render time: {:.1f} ns/row",
+		elapsed.count() / static_cast<double>(RENDER_ROUNDS * ROW_COUNT)
+	);
+	
+	if (rowAllocations > copyAllocations) {
+		SPDLOG_ERROR("The cell data functions allocate more than the copies of the texts");
+		return 1;
+	}
+	return 0;
+}
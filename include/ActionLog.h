@@ -0,0 +1,198 @@
+#ifndef ACTION_LOG_H
+#define ACTION_LOG_H
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtkmm/widget.h>
+#include <momuma/sigc.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LatencyHistogram.h"
+
+
+/* #Records what the user does, to replay it later as a repeatable performance test.
+! Only the high-level actions are recorded: the pages opened, switched and closed from the
+keyboard, the pages shown or moved with the mouse, the rows activated and the slider dragged.
+The log is a text file of one action per
+line, preceded by the milliseconds since the previous one, e.g `830 activate 1 4512`. Pages are
+referred to by their position in the notebook, so a log replays the same on every run.
+! A `Replayer` runs the actions of a log again, at the recorded speed or faster, and times how
+long each one takes to show up on screen.
+*/
+namespace ActionLog
+{
+
+using Clock = std::chrono::steady_clock;
+
+// environment variable naming the file the actions are recorded to
+constexpr char RECORD_ENV[] = "MOMUMA_GTK_RECORD";
+// environment variable naming the file of the actions replayed instead of recording
+constexpr char REPLAY_ENV[] = "MOMUMA_GTK_REPLAY";
+// how many times faster the actions are replayed, 0 runs them back to back
+constexpr char SPEED_ENV[] = "MOMUMA_GTK_REPLAY_SPEED";
+// environment variable naming the file the timings of a replay are written to, as JSON
+constexpr char REPORT_ENV[] = "MOMUMA_GTK_REPLAY_REPORT";
+
+enum class Kind
+{
+	OPEN, // a playlist was opened, from the keyboard
+	PLACEHOLDER, // a playlist was restored from the session, it's loaded once shown
+	FOCUS, // a page was shown
+	NEXT_PAGE,
+	PREV_PAGE,
+	NEW_PAGE,
+	CLOSE_PAGE, // the page shown was closed
+	MOVE, // a page was moved to another position, e.g by dragging its tab
+	ACTIVATE, // a row was double-clicked
+	DRAG, // the slider was pressed
+	DROP, // the slider was released, seeking
+	SCROLL, // the page shown was scrolled to a row, only written by hand in scripted logs
+	
+	COUNT
+};
+
+struct Action
+{
+	// since the previous action
+	std::chrono::milliseconds delay;
+	Kind kind;
+	// position of the page, for `FOCUS`, `MOVE` (before it moved) and `ACTIVATE`
+	size_t page;
+	// the row for `ACTIVATE` and `SCROLL`, the position in milliseconds for `DROP`, the new
+	// position of the page for `MOVE`
+	size_t value;
+	// name of the playlist, for `OPEN` and `PLACEHOLDER`
+	std::string playlist;
+};
+
+// Name of an action in the log.
+[[nodiscard]] const char* kind_name(Kind kind);
+
+// An action as a line of the log, without the newline.
+[[nodiscard]] std::string format(const Action &action);
+
+// Parse a line of the log, `nullopt` when it isn't an action.
+[[nodiscard]] std::optional<Action> parse(std::string_view line);
+
+/* #Read the actions of a log.
+! Invalid lines are skipped with a warning.
+! @return: `nullopt` when the file couldn't be read.
+*/
+[[nodiscard]] std::optional<std::vector<Action>> read(const std::filesystem::path &file);
+
+// Read the replay speed from `SPEED_ENV`, 1 when unset or invalid.
+[[nodiscard]] double speed_from_env(void);
+
+
+// Writes the actions to a log as they happen
+class Recorder final
+{
+public:
+	explicit Recorder(const std::filesystem::path &file);
+	
+	Recorder(const Recorder&) = delete;
+	Recorder& operator=(const Recorder&) = delete;
+	
+	// Whether the log could be opened, nothing is recorded otherwise.
+	[[nodiscard]] bool is_open(void) const;
+	
+	// Record an action, its delay is the time since the previous one.
+	void record(Kind kind, size_t page = 0, size_t value = 0, std::string_view playlist = { });
+	
+private:
+	std::ofstream m_out;
+	Clock::time_point m_last;
+};
+
+
+/* #Runs the actions of a log on the main loop, one after the other.
+! An action is run once its delay, divided by the speed, went by since the previous one ran and
+the previous one was drawn. Actions that can't run yet (e.g their row isn't loaded) wait until
+they can, for at most `READY_TIMEOUT`, then they're skipped.
+! The response time of an action is how long it takes from running it until the end of the
+next frame painted by the widget.
+*/
+class Replayer final
+{
+public:
+	// Whether an action can run now
+	using ReadySlot = sigc::slot<bool(const Action&)>;
+	// Run an action
+	using PerformSlot = sigc::slot<void(const Action&)>;
+	
+	// how long an action may wait to be ready
+	static constexpr std::chrono::seconds READY_TIMEOUT { 30 };
+	// how often an action that isn't ready is checked again
+	static constexpr std::chrono::milliseconds READY_POLL { 10 };
+	
+	
+	/* #Replay actions, drawn by `widget`.
+	! @param speed: how many times faster than recorded, 0 runs them without waiting.
+	*/
+	Replayer(std::vector<Action> actions, double speed, Gtk::Widget &widget);
+	~Replayer(void);
+	
+	Replayer(const Replayer&) = delete;
+	Replayer& operator=(const Replayer&) = delete;
+	
+	// Start replaying, the widget must be shown so its frames are drawn.
+	void start(ReadySlot ready, PerformSlot perform);
+	
+	[[nodiscard]] bool is_finished(void) const;
+	
+	// Number of actions that never got ready, and weren't run.
+	[[nodiscard]] size_t skipped(void) const;
+	
+	// Response times of an action.
+	[[nodiscard]] const LatencyHistogram& responses(Kind kind) const;
+	
+	// Log the response times, and how long the replay took.
+	void log_report(void) const;
+	
+	/* #Write the response times as JSON, like the results of the benchmarks.
+	! @return: false when the file couldn't be written.
+	*/
+	bool write_report(const std::filesystem::path &file) const;
+	
+	// Emitted once every action ran
+	[[nodiscard]] sigc::signal<void()> signal_finished(void);
+	
+private:
+	const std::vector<Action> m_actions;
+	const double m_speed;
+	Gtk::Widget &d_widget;
+	ReadySlot m_ready;
+	PerformSlot m_perform;
+	
+	// the next action to run
+	size_t m_next;
+	size_t m_skipped;
+	// when the previous action ran, and when the next one started waiting to be ready
+	Clock::time_point m_lastRun, m_waitBegin;
+	Clock::time_point m_begin, m_end;
+	std::array<LatencyHistogram, static_cast<size_t>(Kind::COUNT)> m_responses;
+	
+	sigc::connection m_timer, m_afterPaint;
+	guint m_tickId;
+	sigc::signal<void()> m_signal_finished;
+	
+	
+	// Wait for the next action's delay
+	void schedule_next(void);
+	
+	bool cb__due(void);
+	
+	// Called on the first frame after an action ran
+	bool cb__tick(const Glib::RefPtr<Gdk::FrameClock> &clock);
+	
+	void cb__after_paint(void);
+};
+
+}
+
+#endif /* ACTION_LOG_H */
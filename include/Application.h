@@ -2,13 +2,32 @@
 #define APPLICATION_H
 
 #include <gtkmm/application.h>
+#include <memory>
 #include <momuma/momuma.h>
+#include <optional>
+#include <thread>
 
+#include "ActionLog.h"
+#include "Backend.h"
+#include "DatabaseService.h"
+#include "FakeBackend.h"
 #include "Gui.h"
+#include "LoopMonitor.h"
+#include "MainLoopChannel.h"
+#include "MediaProber.h"
+#include "MetadataCache.h"
+#include "PageLru.h"
 #include "Pages.h"
+#include "PlaybackWindow.h"
+#include "PlayerEventPump.h"
+#include "PlaylistLoader.h"
+#include "PlaylistOpener.h"
+#include "RowPlayer.h"
+#include "SessionSnapshot.h"
+#include "TaskScheduler.h"
 
 
-using PlayerState = Momuma::MpvPlayer::State;
+using PlayerState = Backend::Player::State;
 
 
 class Application final : public Gtk::Application
@@ -16,27 +35,80 @@ class Application final : public Gtk::Application
 public:
 	const Glib::ustring _title;
 	
-	bool add_playlist_to_view(const Glib::ustring &playlistName);
+	/* #Add a page for a playlist, and load its rows.
+	! The rows are read in the background, a failure to read them is logged once it's known.
+	*/
+	void add_playlist_to_view(const Glib::ustring &playlistName);
 	
-	[[nodiscard]] Momuma::Momuma &get_backend(void);
+	/* #Add a page for a playlist, without reading it.
+	! The page is a placeholder until it's first shown, at which point its rows are loaded.
+	*/
+	PageId add_playlist_placeholder(const Glib::ustring &playlistName);
+	
+	// Only valid once the backend is ready, see `is_backend_ready()`.
+	[[nodiscard]] Backend &get_backend(void);
+	
+	[[nodiscard]] bool is_backend_ready(void) const;
 	
 	
 	Application(void);
 	
 private:
-	Momuma::Momuma m_backend;
+	// settings of the fake backend, which replaces the real one when they're set
+	const std::optional<FakeBackend::Config> m_fakeBackend;
+	// created on `m_backendThread`, `nullptr` until it's ready
+	std::unique_ptr<Backend> m_backend;
+	// the only user of the backend's database once created, queries wait for it until then
+	DatabaseService m_database;
 	
 	Glib::RefPtr<Gio::Menu> m_menubar;
 	Gui::MasterWindow m_window;
 	
 	PageMap m_pages;
-	bool m_letSliderUpdate;
+	MetadataCache m_metadataCache;
+	MediaProber m_prober;
+	TaskScheduler m_scheduler;
+	PlaylistLoader m_loader;
+	PlaylistOpener m_opener;
+	PageLru m_pageLru;
+	// the pages of the last session, until they're all restored
+	SessionSnapshot m_session;
+	// stops the periodic save of the session, its snapshot is outdated once a page changes
+	TaskScheduler::CancelToken m_sessionSave;
+	// writes the periodic snapshots of the session
+	std::jthread m_sessionWriter;
+	// created along with the player, once the backend is ready
+	std::optional<PlayerEventPump> m_eventPump;
+	std::optional<PlaybackWindow> m_playback;
+	std::optional<RowPlayer> m_rowPlayer;
+	// when a row was last activated, until its stream starts
+	std::optional<std::chrono::steady_clock::time_point> m_activationTime;
+	// connected until the window's first frame
+	sigc::connection m_firstFrame;
+	// reports the callbacks that keep the main loop from iterating
+	LoopMonitor::Watchdog m_watchdog;
+	// logs the latencies of the callbacks on SIGUSR1, 0 when not installed
+	unsigned int m_latencySignal;
+	// records the actions of the user, see `ActionLog::RECORD_ENV`
+	std::optional<ActionLog::Recorder> m_recorder;
+	// the pages in the order the log knows them, to record where a moved page was
+	std::vector<PageId> m_recordedPages;
+	// set while a key's action runs, the pages it shows aren't recorded on their own
+	bool m_keyAction;
+	// replays the actions of a log instead, see `ActionLog::REPLAY_ENV`
+	std::optional<ActionLog::Replayer> m_replayer;
+	
+	// hands the backend over to the main loop once it's created
+	MainLoopChannel<std::unique_ptr<Backend>> m_backendReady;
+	// must be the last member, so it's joined before the channel is destroyed
+	std::jthread m_backendThread;
 	
 	
 	void set_accel_for_action(const Glib::ustring& actionName, const Glib::ustring& accel);
 	
 	void on_startup(void) override;
 	void on_activate(void) override;
+	void on_shutdown(void) override;
 	
 	void create_keyboard_only_shortcuts(void);
 	
@@ -58,6 +130,62 @@ private:
 	
 	void prefix_title(Glib::ustring prefix);
 	
+	/* #Read the paths of a page's playlist from the database, then load its rows.
+	! Pages of the last session are restored from its snapshot instead, see
+	`PlaylistOpener::read()` for the others.
+	*/
+	void load_page(PageId id);
+	
+	// Open the pages of the last session, as placeholders except for the shown one
+	void restore_session(void);
+	
+	/* #Fill a page with its rows from the session snapshot.
+	! The rows are then checked against the database in the background, the page is loaded
+	again if its playlist changed since.
+	*/
+	void restore_page(PageId id);
+	
+	/* #Add a page to a session snapshot, without its rows.
+	! Pages that aren't loaded are added without rows, they're read from the database when
+	they're restored.
+	! @return: the number of rows to add with `snapshot_rows()`.
+	*/
+	size_t snapshot_page(SessionSnapshot::Builder &builder, PageId id);
+	
+	void snapshot_rows(SessionSnapshot::Builder &builder, PageId id,
+		size_t first, size_t count
+	);
+	
+	// Save the session, a few rows per frame
+	TaskScheduler::Task save_session_task(void);
+	
+	// Whether a page can give its rows back, to be read again once it's shown
+	[[nodiscard]] bool is_evictable(PageId id);
+	
+	// Evict the least recently shown pages, while the pages use more than `m_pageLru`'s budget
+	void evict_pages(void);
+	
+	// Add an untitled page, its playlist is chosen later
+	void new_untitled_page(void);
+	
+	// Close the page shown, stopping the playback when it's the one playing
+	void close_current_page(void);
+	
+	// Record the actions to the log named by `ActionLog::RECORD_ENV`, from the pages open
+	void start_recording(void);
+	
+	/* #Replay the log named by `ActionLog::REPLAY_ENV`, from an empty notebook.
+	! The session is neither restored nor saved, and the application quits once the replay ends.
+	! @return: false when there's no log to replay.
+	*/
+	bool start_replay(void);
+	
+	// Whether an action of the replay can run, e.g its row is loaded
+	[[nodiscard]] bool is_replay_ready(const ActionLog::Action &action);
+	
+	// Run an action of the replay, through the same callbacks as the user's actions
+	void replay_action(const ActionLog::Action &action);
+	
 	void on_action_quit(void);
 	void on_action_openPlaylist(void);
 	void on_action_closePlaylist(void);
@@ -66,19 +194,51 @@ private:
 	
 	bool cb__window_keypress(const GdkEventKey *const event);
 	
+	// Called when the window is (de)iconified, hidden, etc.
+	void cb__window_state_changed(const GdkEventWindowState *const event);
+	
 	void cb__row_activated(const PageId id, const int rowIndex, Gui::NotebookRowProxy row);
 	
+	/* #Called once the backend was created on `m_backendThread`.
+	! Connects the player to the controls, which stay insensitive until then.
+	*/
+	void cb__backend_ready(std::span<std::unique_ptr<Backend>> backend);
+	
+	// Called when the window is first drawn
+	bool cb__first_frame(const Cairo::RefPtr<Cairo::Context>&);
+	
+	// Called once `m_loader` appended every row of a page
+	void cb__playlist_loaded(const PageId id);
+	
+	// Called when a page is about to be shown, placeholders are loaded then
+	void cb__page_focused(const PageId id);
+	
+	// Records a page shown by other means than a recorded action, e.g by clicking its tab
+	void cb__record_focus(const PageId id);
+	
+	// Records a page moved to another position, e.g by dragging its tab
+	void cb__record_move(const PageId id, const size_t position);
+	
+	// Called every `SESSION_SAVE_INTERVAL`, saves the session in the background
+	void cb__save_session(void);
+	
 	// Called when the user presses/releases the `MasterWindow`'s slider
 	void cb__slider_update(Gui::Slider::DragPhase phase);
 	
+	// Called when the next/previous song buttons are clicked
+	void cb__skip_song(int offset);
+	
+	// Called once every action of `m_replayer` ran
+	void cb__replay_finished(void);
+	
 	// Called when the `Player` starts the stream
-	void cb__audioStreamStarted(Momuma::MpvPlayer &src);
+	void cb__audioStreamStarted(Backend::Player &src);
 	
 	// Called when the `Player` reaches the end-of-stream
-	void cb__audioStreamEnded(Momuma::MpvPlayer &src);
+	void cb__audioStreamEnded(Backend::Player &src);
 	
 	// Called when the `Player` changes states
-	void cb__audioStateChanged(Momuma::MpvPlayer &src,
+	void cb__audioStateChanged(Backend::Player &src,
 		PlayerState prevState, PlayerState newState
 	);
 };
@@ -1,8 +1,7 @@
 #ifndef APPLICATION_INTERFACE_H
 #define APPLICATION_INTERFACE_H
 
-#include <momuma/momuma.h>
-
+#include "Backend.h"
 #include "glibmm/ustring.h"
 
 
@@ -11,9 +10,9 @@
 class Application
 {
 public:
-	bool add_playlist_to_view(const Glib::ustring &playlistName);
+	void add_playlist_to_view(const Glib::ustring &playlistName);
 	
-	Momuma::Momuma &get_backend(void);
+	Backend &get_backend(void);
 	
 private:
 	Application(void) = delete;
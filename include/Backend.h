@@ -0,0 +1,116 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <momuma/momuma.h>
+#include <momuma/sigc.h>
+
+
+/* #What the application needs of the library: a player, and a database of playlists.
+! `MomumaBackend` is the real one. `FakeBackend` generates its playlists and plays on a virtual
+clock, so the interface can be load tested without a database or an audio output.
+! Both are only used from the main loop, except for the database which is only used by
+`DatabaseService`.
+*/
+class Backend
+{
+public:
+	// Plays a playlist of media, its events are handled on the main loop by `handle_event()`
+	class Player
+	{
+	public:
+		using State = Momuma::MpvPlayer::State;
+		
+		sigc::signal<void(Player &src)> signal_streamStarted;
+		sigc::signal<void(Player &src)> signal_streamEnded;
+		sigc::signal<void(Player &src, State prevState, State newState)>
+			signal_stateChanged;
+		
+		// Called from any thread when the player queues an event
+		using WakeupFunc = std::function<void(void)>;
+		
+		virtual ~Player(void) = default;
+		
+		// Handle the next pending event, emitting its signal, without waiting for one.
+		virtual void handle_event(void) = 0;
+		
+		/* #Have `wakeup` called once for every event the player queues, from any thread.
+		! An empty function stops the calls, none is made once this returns.
+		! @return: false when the player can't, its events must be polled then.
+		*/
+		virtual bool set_wakeup(WakeupFunc wakeup) = 0;
+		
+		[[nodiscard]] virtual State get_state(void) = 0;
+		
+		// Position in the current stream.
+		[[nodiscard]] virtual std::chrono::microseconds get_position(mpv_error &error) = 0;
+		
+		// Duration of the current stream.
+		[[nodiscard]] virtual std::chrono::microseconds get_duration(mpv_error &error) = 0;
+		
+		virtual void set_play(bool play) = 0;
+		
+		// Seek in the current stream.
+		virtual void set_position(std::chrono::milliseconds position) = 0;
+		
+		virtual void set_volume(double volume) = 0;
+		
+		// Stop the playback and clear the playlist.
+		virtual void stop_playback(void) = 0;
+		
+		virtual mpv_error append_media(const std::filesystem::path &path) = 0;
+		
+		/* #Remove an entry of the playlist other than the current one, which keeps playing.
+		! The entries after it move down by one index, the current one included.
+		! @return: false when it's the current entry, out of range, or the player can't.
+		*/
+		virtual bool remove_media(int index) = 0;
+		
+		[[nodiscard]] virtual bool playlist_empty(void) = 0;
+		
+		// Index of the current entry of the playlist, negative when there's none.
+		[[nodiscard]] virtual int64_t get_index(void) = 0;
+		
+		virtual void set_index(int index) = 0;
+	};
+	
+	// The playlists, only used by `DatabaseService`
+	class Database
+	{
+	public:
+		using IterFlag = Momuma::Database::IterFlag;
+		
+		virtual ~Database(void) = default;
+		
+		/* #List the playlists.
+		! @return: the number of playlists, negative on error.
+		*/
+		virtual int get_playlists(
+			const std::function<IterFlag(Glib::ustring)> &callback
+		) = 0;
+		
+		/* #List the media of a playlist, in order.
+		! @return: the number of media, negative on error.
+		*/
+		virtual int get_media_paths(const Glib::ustring &playlist,
+			const std::function<IterFlag(std::filesystem::path)> &callback
+		) = 0;
+	};
+	
+	// Reads the duration of a media, called from the threads of `MediaProber`
+	using ProbeFunc = std::function<std::chrono::microseconds(const std::filesystem::path&)>;
+	
+	
+	virtual ~Backend(void) = default;
+	
+	// Whether the backend was created, the player and database can't be used otherwise.
+	[[nodiscard]] virtual bool is_valid(void) const = 0;
+	
+	[[nodiscard]] virtual Player& get_player(void) = 0;
+	
+	[[nodiscard]] virtual Database& get_database(void) = 0;
+};
+
+#endif /* BACKEND_H */
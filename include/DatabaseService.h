@@ -0,0 +1,124 @@
+#ifndef DATABASE_SERVICE_H
+#define DATABASE_SERVICE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <momuma/sigc.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Backend.h"
+#include "MainLoopChannel.h"
+
+
+/* #Runs the queries of a `Backend::Database` on a thread of its own.
+! Once the service is created, the database must only be used through it. The rows of a query
+are sent back to the main loop in chunks as they're read, so a long query shows up
+incrementally and never blocks the UI.
+! Every query returns a `Request`, cancelling it stops the query at the next row and drops the
+chunks that weren't delivered yet. The callbacks are only ever called on the main loop.
+! The service may be created before the database is, queries wait until one is `attach()`ed.
+*/
+class DatabaseService final
+{
+public:
+	using Database = Backend::Database;
+	
+	// rows read between two chunks sent to the main loop, at most
+	static constexpr size_t CHUNK_ROWS = 512;
+	
+	// Called with the result of the query, false when it failed or was cut short by an error
+	using DoneSlot = sigc::slot<void(bool success)>;
+	
+	template <typename Row>
+	using RowsSlot = sigc::slot<void(std::vector<Row> &&rows)>;
+	
+	// A query that may still be running
+	class Request
+	{
+	public:
+		Request(void);
+		
+		// Stop the query, none of its callbacks are called after this.
+		void cancel(void);
+		
+		// Whether the query is still running and wasn't cancelled.
+		[[nodiscard]] bool is_pending(void) const;
+		
+	private:
+		friend DatabaseService;
+		
+		struct State
+		{
+			std::atomic<bool> cancelled { false };
+			// only accessed from the main loop
+			bool done = false;
+		};
+		std::shared_ptr<State> m_state;
+	};
+	
+	
+	DatabaseService(void);
+	~DatabaseService(void);
+	
+	DatabaseService(const DatabaseService&) = delete;
+	DatabaseService& operator=(const DatabaseService&) = delete;
+	
+	/* #Run the queries on a database, the ones already queued included.
+	! Must be called once, the database must outlive the service.
+	*/
+	void attach(Database &database);
+	
+	// List the playlists.
+	Request get_playlists(RowsSlot<Glib::ustring> onRows, DoneSlot onDone);
+	
+	// List the media of a playlist, in order.
+	Request get_media_paths(const Glib::ustring &playlist,
+		RowsSlot<std::filesystem::path> onRows, DoneSlot onDone
+	);
+	
+private:
+	using IterFlag = Database::IterFlag;
+	// runs on the service thread
+	using Job = std::function<void(Database&, const std::stop_token&)>;
+	// runs on the main loop
+	using Delivery = std::function<void(void)>;
+	
+	template <typename Row>
+	using Query = std::function<int(Database&, const std::function<IterFlag(Row)>&)>;
+	
+	std::mutex m_jobsMutex;
+	// `nullptr` until attached, guarded by `m_jobsMutex`
+	Database *d_database;
+	std::condition_variable_any m_jobsCv;
+	std::deque<Job> m_jobs;
+	
+	// chunks of rows and completions of the queries
+	MainLoopChannel<Delivery> m_deliveries;
+	
+	// must be the last member, so the thread is stopped before anything is destroyed
+	std::jthread m_thread;
+	
+	
+	/* #Queue a query whose rows are delivered in chunks.
+	! @param query: calls the database with a callback for each row.
+	*/
+	template <typename Row>
+	Request submit(Query<Row> query, RowsSlot<Row> onRows, DoneSlot onDone);
+	
+	void thread_loop(std::stop_token stop);
+	
+	/* #Hand something to the main loop, from the service thread.
+	! @return: false when the service stopped while waiting for room, `delivery` is dropped.
+	*/
+	bool deliver(Delivery &&delivery, const std::stop_token &stop);
+	
+	void cb__deliver(std::span<Delivery> deliveries);
+};
+
+#endif /* DATABASE_SERVICE_H */
@@ -0,0 +1,80 @@
+#ifndef FAKE_BACKEND_H
+#define FAKE_BACKEND_H
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Backend.h"
+
+
+/* #A backend made up from a generator, for load testing without a database or audio output.
+! The database serves playlists of synthetic paths, as many as configured. Durations are
+derived from the paths, so every run sees the same ones, and probing one takes
+`Config::probeLatency`.
+! The player plays nothing: a virtual clock runs at `Config::speed` times the real time, streams
+end once their duration went by on it, and every seek or stream start takes
+`Config::seekLatency`. Its signals are emitted from `handle_event()` like the real player's.
+! Selected by setting `CONFIG_ENV`, e.g. `playlists=1000:100000,probe_us=500,speed=10`.
+*/
+class FakeBackend final : public Backend
+{
+public:
+	struct Config
+	{
+		// number of tracks of each playlist
+		std::vector<size_t> playlists { 1'000, 10'000, 100'000 };
+		std::chrono::microseconds probeLatency { 2'000 };
+		std::chrono::microseconds seekLatency { 20'000 };
+		// virtual seconds per real second
+		double speed = 1.0;
+	};
+	
+	// environment variable enabling the fake backend, with its settings
+	static constexpr char CONFIG_ENV[] = "MOMUMA_GTK_FAKE_BACKEND";
+	
+	/* #Read the configuration from `CONFIG_ENV`.
+	! Made of comma-separated `key=value` settings: `playlists` (sizes separated by colons),
+	`probe_us`, `seek_us` and `speed`. The ones left out keep their default.
+	! @return: `nullopt` when it isn't set, the real backend is used then.
+	*/
+	[[nodiscard]] static std::optional<Config> config_from_env(void);
+	
+	// Name of a generated playlist.
+	[[nodiscard]] static std::string playlist_name(size_t playlist, size_t tracks);
+	
+	// Path of a generated track.
+	[[nodiscard]] static std::filesystem::path track_path(size_t playlist, size_t track);
+	
+	// Duration of a generated track, derived from its path.
+	[[nodiscard]] static std::chrono::seconds track_duration(const std::filesystem::path &path);
+	
+	// Probes like the fake backend, taking `config.probeLatency` per track.
+	[[nodiscard]] static ProbeFunc make_probe(const Config &config);
+	
+	
+	explicit FakeBackend(Config config);
+	~FakeBackend(void) override;
+	
+	FakeBackend(const FakeBackend&) = delete;
+	FakeBackend& operator=(const FakeBackend&) = delete;
+	
+	[[nodiscard]] bool is_valid(void) const override;
+	
+	[[nodiscard]] Player& get_player(void) override;
+	
+	[[nodiscard]] Database& get_database(void) override;
+	
+private:
+	class VirtualPlayer;
+	class Generator;
+	
+	const Config m_config;
+	std::unique_ptr<VirtualPlayer> m_player;
+	std::unique_ptr<Generator> m_database;
+};
+
+#endif /* FAKE_BACKEND_H */
@@ -8,6 +8,7 @@
 #include <gtkmm/listviewtext.h>
 #include <gtkmm/togglebutton.h>
 #include <momuma/sigc.h>
+#include <optional>
 #include <tuple>
 
 #include "Gui/PlaylistNotebook.h"
@@ -50,10 +51,36 @@ private:
 
 struct Slider final : public TopWidget<Gtk::HBox>
 {
+	struct PlaybackTime
+	{
+		std::chrono::milliseconds position;
+		std::chrono::milliseconds duration;
+	};
+	
+	// Reads the current playback time, returns `nullopt` when it's unavailable
+	using PlaybackSource = sigc::slot<std::optional<PlaybackTime>()>;
+	
+	
 	void reset_widget_text(void);
 	
 	Slider(void);
 	
+	/* #Follow the playback of a player.
+	! While playing, the position is extrapolated on every frame of the scale's frame clock
+	from the last time read from `source`, which is only read again every so often. The scale
+	is only moved when the displayed second or pixel changes.
+	*/
+	void set_playback_source(PlaybackSource source);
+	
+	// Start or stop following the playback (e.g when the player is (un)paused)
+	void set_playing(bool playing);
+	
+	// Stop following the playback while the slider can't be seen (e.g the window is iconified)
+	void set_suspended(bool suspended);
+	
+	// Read the time from the playback source right away (e.g after seeking)
+	void resync(void);
+	
 	// set the slider's current time
 	void set_time(std::chrono::milliseconds time);
 	
@@ -92,6 +119,26 @@ private:
 	
 	// use to handle multi-clicks (which send only 1 release signal)
 	DragPhase m_lastDragPhase;
+	
+	PlaybackSource m_playbackSource;
+	// last time read from `m_playbackSource`, and when it was read (monotonic clock)
+	PlaybackTime m_anchor;
+	std::chrono::microseconds m_anchorTime;
+	// what the scale shows, to only move it when it visibly changes
+	int64_t m_shownSecond, m_shownPixel;
+	guint m_tickId;
+	bool m_playing, m_suspended;
+	
+	// Add or remove the tick callback, depending on the playback state
+	void update_ticking(void);
+	
+	bool cb__tick(const Glib::RefPtr<Gdk::FrameClock> &clock);
+	
+	// Returns false when the playback source had no time to give
+	bool resync_at(std::chrono::microseconds now);
+	
+	// Move the scale, if `time` changes what's displayed
+	void show_time(std::chrono::milliseconds time);
 };
 
 
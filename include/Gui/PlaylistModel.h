@@ -0,0 +1,167 @@
+#ifndef GUI__PLAYLIST_MODEL_H
+#define GUI__PLAYLIST_MODEL_H
+
+#include <glibmm/object.h>
+#include <gtkmm/treemodel.h>
+#include <momuma/sigc.h>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Gui/PlaylistNotebook.h"
+
+
+namespace Gui
+{
+
+/* #A flat `Gtk::TreeModel` holding the rows of a playlist page.
+! The rows are stored column by column in contiguous arrays (a struct-of-arrays), the names
+living back-to-back in a single string arena. An iterator holds the index of its row, so
+converting between the two never walks the model.
+! Bulk operations don't emit per-row signals. Instead they're wrapped by `signal_reset()`, and
+views are expected to detach from the model on `ResetPhase::BEGIN` and re-attach on
+`ResetPhase::END`.
+*/
+class PlaylistModel final : public Glib::Object, public Gtk::TreeModel
+{
+public:
+	enum Column : int { MARKED, NAME, DURATION, N_COLUMNS };
+	enum class ResetPhase { BEGIN, END };
+	
+	[[nodiscard]] static Glib::RefPtr<PlaylistModel> create(void);
+	
+	// Number of rows in the model.
+	[[nodiscard]] size_t size(void) const;
+	
+	// Equivalent to `PlaylistModel::size() == 0`.
+	[[nodiscard]] bool empty(void) const;
+	
+	/* #Append a single row and emit `row-inserted`.
+	! The names of all the rows share an arena of at most 4 GiB. A row whose name doesn't fit is
+	logged and not appended, false is returned then.
+	*/
+	bool append(const NotebookRowData &data);
+	
+	/* #Append many rows at once, surrounded by `signal_reset()`.
+	! The rows are appended up to the first one whose name doesn't fit, see `append()`.
+	*/
+	void append(std::span<const NotebookRowData> rows);
+	
+	/* #Append a batch of rows and emit `row-inserted` for each of them.
+	! Meant for feeding a model a few rows at a time while it's shown: the views stay attached
+	and keep their scroll position, which is cheap for views in fixed-height mode.
+	! The rows are appended up to the first one whose name doesn't fit, see `append()`.
+	*/
+	void extend(std::span<const NotebookRowData> rows);
+	
+	// Remove all the rows, surrounded by `signal_reset()`.
+	void clear(void);
+	
+	/* #Remove the rows past the first `size` ones and emit `row-deleted` for each of them.
+	! Meant for tearing a model down a few rows at a time: unlike `clear()` the views stay
+	attached, and only update the rows that were removed.
+	*/
+	void truncate(size_t size);
+	
+	/* #Row accessors.
+	! The setters emit `row-changed`. Out of range indices are a programming error, except for
+	`set_marked()` which ignores them: a marked row may be gone once the model was truncated.
+	*/
+	[[nodiscard]] NotebookColBit get_marked(size_t row) const;
+	void set_marked(size_t row, NotebookColBit marked);
+	
+	/* #The names are NUL-terminated strings, stored one after the other in a single arena.
+	! Appending rows or renaming any of them may reallocate the arena, which invalidates every
+	string returned by `get_name()` so far, as does clearing or truncating the model.
+	! A name that doesn't fit in the arena is logged and the row keeps its name, see `append()`.
+	*/
+	[[nodiscard]] const char* get_name(size_t row) const;
+	void set_name(size_t row, const Glib::ustring &name);
+	
+	[[nodiscard]] std::chrono::seconds get_duration(size_t row) const;
+	void set_duration(size_t row, std::chrono::seconds duration);
+	
+	/* #Mark the playing row, and unmark the previously playing one.
+	! Only those two rows are touched (and emit `row-changed`), whatever the size of the model.
+	! @param row: the new playing row, or `nullopt` to only unmark the previous one.
+	! @param marked: the columns to mark in `row`.
+	*/
+	void set_playing_row(std::optional<size_t> row,
+		NotebookColBit marked = NotebookColBit::NAME
+	);
+	
+	[[nodiscard]] std::optional<size_t> get_playing_row(void) const;
+	
+	/* #Get the index of the row an iterator points to.
+	! The iterator must be a valid iterator of this model.
+	*/
+	[[nodiscard]] static size_t iter_to_index(const Gtk::TreeIter &iter);
+	
+	// Get an iterator to the row at `row`, or an invalid iterator when it's out of range.
+	[[nodiscard]] Gtk::TreeIter index_to_iter(size_t row);
+	
+	/* #Changes whenever rows are removed.
+	! Row indices obtained in one generation are only valid in that same generation. No two
+	models ever have the same one.
+	*/
+	[[nodiscard]] int generation(void) const;
+	
+	// Approximate number of bytes used by the rows.
+	[[nodiscard]] size_t memory_usage(void) const;
+	
+	[[nodiscard]] sigc::signal<void(ResetPhase)> signal_reset(void);
+	
+protected:
+	PlaylistModel(void);
+	
+	Gtk::TreeModelFlags get_flags_vfunc(void) const override;
+	int get_n_columns_vfunc(void) const override;
+	GType get_column_type_vfunc(int index) const override;
+	
+	void get_value_vfunc(
+		const iterator &iter, int column, Glib::ValueBase &value
+	) const override;
+	
+	bool iter_next_vfunc(const iterator &iter, iterator &iterNext) const override;
+	bool iter_children_vfunc(const iterator &parent, iterator &iter) const override;
+	bool iter_has_child_vfunc(const iterator &iter) const override;
+	int iter_n_children_vfunc(const iterator &iter) const override;
+	int iter_n_root_children_vfunc(void) const override;
+	bool iter_nth_child_vfunc(const iterator &parent, int n, iterator &iter) const override;
+	bool iter_nth_root_child_vfunc(int n, iterator &iter) const override;
+	bool iter_parent_vfunc(const iterator &child, iterator &iter) const override;
+	
+	Path get_path_vfunc(const iterator &iter) const override;
+	bool get_iter_vfunc(const Path &path, iterator &iter) const override;
+	
+private:
+	// renewed whenever existing iterators become invalid, doubles as the generation
+	int m_stamp;
+	
+	std::vector<uint8_t> m_marked;
+	std::vector<uint32_t> m_nameOffsets; // offsets of NUL-terminated strings in `m_names`
+	std::vector<int32_t> m_durations; // seconds, negative when unknown
+	std::vector<char> m_names;
+	
+	std::optional<size_t> m_playingRow;
+	
+	sigc::signal<void(ResetPhase)> m_signal_reset;
+	
+	
+	// Whether a name of `size` bytes fits in `m_names`, its offset must fit in 32 bits
+	[[nodiscard]] bool name_fits(size_t size) const;
+	
+	// Returns false and logs an error when the name of the row doesn't fit
+	[[nodiscard]] bool push_row(const NotebookRowData &data);
+	
+	// Returns false and invalidates `iter` when `row` is out of range
+	bool set_iter(iterator &iter, size_t row) const;
+	
+	[[nodiscard]] bool is_valid(const iterator &iter) const;
+	
+	void emit_row_changed(size_t row);
+};
+
+}
+
+#endif /* GUI__PLAYLIST_MODEL_H */
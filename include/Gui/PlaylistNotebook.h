@@ -1,11 +1,14 @@
 #ifndef GUI__PLAYLIST_NOTEBOOK_H
 #define GUI__PLAYLIST_NOTEBOOK_H
 
+#include <deque>
 #include <gtkmm/notebook.h>
 #include <gtkmm/scrolledwindow.h>
-#include <gtkmm/treerowreference.h>
 #include <gtkmm/treeview.h>
 #include <momuma/enum_operators.h>
+#include <optional>
+#include <span>
+#include <vector>
 
 #include "Gui/TopWidget.h"
 
@@ -15,13 +18,25 @@ namespace Gui
 
 class NotebookPageProxy;
 class NotebookRowProxy;
+class PlaylistModel;
 
 struct NotebookRowData
 {
+	// `mediaDuration` of a row whose duration isn't known (yet)
+	static constexpr std::chrono::seconds UNKNOWN_DURATION { -1 };
+	
 	Glib::ustring mediaName;
 	std::chrono::seconds mediaDuration;
 };
 
+// Where the view of a page was, to show it the same way once its rows are back
+struct PageViewState
+{
+	// first row in view
+	std::optional<size_t> topRow;
+	std::vector<size_t> selectedRows;
+};
+
 enum class NotebookColBit : uint32_t
 {
 	None = 0, All = (1ULL << (sizeof (NotebookColBit) * CHAR_BIT)) - 1,
@@ -46,6 +61,7 @@ public:
 	void reset_widget_text(void);
 	
 	PlaylistNotebook(void);
+	~PlaylistNotebook(void);
 	
 	// Get the number of pages in a notebook.
 	[[nodiscard]] int size(void);
@@ -56,6 +72,18 @@ public:
 	
 	[[nodiscard]] PageId current_page_id(void) const;
 	
+	// Ids of the pages, in the order they're shown.
+	[[nodiscard]] std::vector<PageId> page_ids(void) const;
+	
+	// Whether a page is in the notebook, i.e. wasn't removed.
+	[[nodiscard]] bool has_page(PageId page) const;
+	
+	// Show the given page.
+	void page_focus(PageId page);
+	
+	// Move a page to another position, as if its tab was dragged there.
+	void page_move(PageId page, size_t position);
+	
 	/* #Focuses on the page right of the focused one.
 	! Does nothing when there are no pages.
 	! Wraps to the left-most page when the right-most page is focused.
@@ -77,7 +105,38 @@ public:
 	*/
 	PageId page_create(const Glib::ustring &title, Pango::AttrList &titleAttributes);
 	
+	/* #Creates a new page without a view, which costs next to nothing until it's shown.
+	! The page is added to the right of the focused page like with `page_create()`, but doesn't
+	steal the focus. It has no rows until `page_create_view()` is called.
+	! @return: id of the newly created page.
+	*/
+	PageId page_create_placeholder(const Glib::ustring &title,
+		Pango::AttrList &titleAttributes
+	);
+	
+	// Whether a page has a view, as opposed to being a placeholder.
+	[[nodiscard]] bool page_has_view(PageId page) const;
+	
+	// Give a placeholder page an empty view, does nothing when the page already has one.
+	void page_create_view(PageId page);
+	
+	// Where the view of a page is, empty for a placeholder.
+	[[nodiscard]] PageViewState page_get_view_state(PageId page) const;
+	
+	/* #Turn a page back into a placeholder, dropping its view and rows.
+	! The rows are released in the background, like those of a removed page.
+	! @return: where the view was, for `page_restore_view_state()`.
+	*/
+	PageViewState page_drop_view(PageId page);
+	
+	/* #Scroll and select rows as they were when the view was dropped.
+	! Rows past the end of the page are ignored, call it once the rows are back.
+	*/
+	void page_restore_view_state(PageId page, const PageViewState &state);
+	
 	/* #Remove the given page.
+	! The page is taken out of the notebook right away, but its rows are released a few at a
+	time while the main loop is idle, and the page is only destroyed once they're all gone.
 	! @param page: the page to remove.
 	*/
 	void page_remove(PageId page);
@@ -106,18 +165,56 @@ public:
 	// Emitted before the page is destroyed
 	[[nodiscard]] sigc::signal<void(PageId)> signal_page_remove(void);
 	
-	// Emitted after the page is destroyed
+	// Emitted after the page is destroyed, some time after it was removed
 	[[nodiscard]] sigc::signal<void(PageId)> signal_page_destroyed(void);
 	
+	// Emitted when a page is about to be shown, including placeholders
+	[[nodiscard]] sigc::signal<void(PageId)> signal_page_focused(void);
+	
+	// Emitted after a page was moved to another position, e.g by dragging its tab
+	[[nodiscard]] sigc::signal<void(PageId, size_t position)> signal_page_reordered(void);
+	
 	[[nodiscard]]
 	sigc::signal<void(PageId, int rowIndex, NotebookRowProxy)> signal_row_activated(void);
 	
 private:
 	sigc::signal<void(PageId)> m_signal_pageCreated, m_signal_pageRemove, m_signal_pageDestroyed;
+	sigc::signal<void(PageId)> m_signal_pageFocused;
+	sigc::signal<void(PageId, size_t position)> m_signal_pageReordered;
 	sigc::signal<void(PageId, int rowIndex, RowProxy)> m_signal_rowActivated;
 	
+	// rows released by a slice of teardown, between two looks at the clock
+	static constexpr size_t TEARDOWN_ROWS = 512;
+	// time spent tearing pages down per main loop iteration, at most
+	static constexpr std::chrono::microseconds TEARDOWN_BUDGET { 2000 };
+	
+	struct Closing
+	{
+		// the container of a removed page or a dropped view, referenced until it's released
+		Gtk::Widget *widget;
+		// null when the page was a placeholder
+		Glib::RefPtr<PlaylistModel> model;
+		// `PageId::Null` when only the view of the page was dropped
+		PageId page;
+	};
+	// widgets waiting for their rows to be released, oldest first
+	std::deque<Closing> m_closing;
+	sigc::connection m_teardown;
+	
+	
 	void initialize_gui(void);
 	
+	// Insert a page to the right of the focused page, without focusing it
+	void insert_page(Gtk::ScrolledWindow &container,
+		const Glib::ustring &title, Pango::AttrList &titleAttributes
+	);
+	
+	// Queue a widget whose rows must be released before it is
+	void close_later(Closing &&closing);
+	
+	// Release the rows of the removed pages, destroying the pages left without rows
+	bool cb__teardown(void);
+	
 	void cb__row_activated(
 		const Gtk::TreeModel::Path &rowPath, Gtk::TreeView::Column *tvc, PageId id
 	);
@@ -150,6 +247,9 @@ public:
 	// Equivalent to `PageProxy::size() == 0`.
 	[[nodiscard]] bool empty(void) const;
 	
+	// Approximate number of bytes used by the rows of the page, in its model and view.
+	[[nodiscard]] size_t memory_usage(void) const;
+	
 	[[nodiscard]]
 	Glib::ustring get_name() const;
 	
@@ -162,11 +262,42 @@ public:
 	
 	void append_row(const NotebookRowData &data) const;
 	
+	/* #Append many rows at once.
+	! Much faster than calling `append_row()` for each row, as the view is only updated once.
+	*/
+	void append_rows(std::span<const NotebookRowData> rows) const;
+	
+	/* #Append a batch of rows while the page is shown.
+	! Unlike `append_rows()` the view isn't refreshed as a whole, it keeps its scroll position.
+	Meant for loading a page a few rows at a time.
+	*/
+	void extend_rows(std::span<const NotebookRowData> rows) const;
+	
+	// Remove all the rows of the page.
+	void clear(void) const;
+	
+	/* #Set the duration of multiple rows at once.
+	! @param durations: pairs of a row *index* and its new duration.
+	Rows that are out of range are ignored.
+	*/
+	void set_durations(
+		const std::vector<std::pair<size_t, std::chrono::seconds>> &durations
+	) const;
+	
 	enum class IterFlag : bool { STOP = false, NEXT = !STOP };
 	/* #Execute a callback for each row in the page.
 	*/
 	void foreach_row(sigc::slot<IterFlag(long row, NotebookRowProxy rowProxy)> callback) const;
 	
+	/* #Read a range of rows, without copying them.
+	! Much cheaper than `foreach_row()` for reading many rows.
+	! @param callback: called with the index, name and duration of each row. The name is only
+	valid until the callback returns.
+	*/
+	void read_rows(size_t first, size_t count,
+		const sigc::slot<void(size_t row, const char *name, std::chrono::seconds)> &callback
+	) const;
+	
 	/* #Get a proxy for each row.
 	! @param firstLine: the line *index* to start getting rows from. Must NOT be negative.
 	! @param lineCount: the number of lines to get. 0 or a negative number are a no-op.
@@ -175,8 +306,21 @@ public:
 	[[nodiscard]]
 	std::vector<NotebookRowProxy> get_rows(long firstLine = 0, long lineCount = INT_MAX) const;
 	
+	/* #Get a handle to a single row, in constant time.
+	! @param index: the row *index*. Must be less than `size()`.
+	*/
+	[[nodiscard]] NotebookRowProxy row_at(size_t index) const;
+	
 	void mark_rows(NotebookColBit column) const;
 	
+	/* #Mark the playing row of the page, and unmark the previous one.
+	! Takes constant time, only the two rows are updated.
+	! @param row: the row *index*, or `nullopt` to only unmark the previous row.
+	*/
+	void set_playing_row(std::optional<size_t> row) const;
+	
+	[[nodiscard]] std::optional<size_t> get_playing_row(void) const;
+	
 	
 	// #Convenience wrapper for `rename()`.
 	inline void rename(const Glib::ustring &title)
@@ -187,19 +331,28 @@ public:
 };
 
 
+/* #A handle to a row of a page.
+! Made of the page, the row's index and the generation of the page's model when the handle was
+created. Rows are only ever appended, and removing them starts a new generation, so the index
+stays valid as long as the generation matches.
+! Handles are cheap to copy and aren't tracked by the model. Accessing a stale handle is a no-op
+(getters return default values), check `is_valid()` when it matters.
+! The model is looked up from the page on every access. A handle whose page was closed is stale
+too, generations being unique across the models of every page.
+*/
 class NotebookRowProxy
 {
 public:
-	Gtk::TreeRowReference _ref;
-	
-	NotebookRowProxy(const Glib::RefPtr<Gtk::TreeModel> &model, const Gtk::TreePath &path) :
-		_ref { model, path }
-	{}
-	
-	NotebookRowProxy(NotebookRowProxy &&other) : _ref { std::move(other._ref) } {}
+	PlaylistNotebook::PageId _page;
+	size_t _row;
 	
-	NotebookRowProxy(const NotebookRowProxy &other) : _ref { other._ref } {}
+	// `page` must be a page of `notebook`.
+	NotebookRowProxy(const PlaylistNotebook &notebook, PlaylistNotebook::PageId page,
+		size_t row
+	);
 	
+	// Whether the row still exists.
+	[[nodiscard]] bool is_valid(void) const;
 	
 	void toggle_marked(NotebookColBit column);
 	void set_marked(NotebookColBit column);
@@ -210,6 +363,14 @@ public:
 	
 	void set_duration(std::chrono::seconds);
 	[[nodiscard]] std::chrono::seconds get_duration(void);
+	
+private:
+	const PlaylistNotebook *d_notebook;
+	int m_generation;
+	
+	
+	// Returns `nullptr` when the handle is stale
+	[[nodiscard]] PlaylistModel* resolve(void) const;
 };
 
 }
@@ -0,0 +1,79 @@
+#ifndef GUI__PLAYLIST_TREE_VIEW_H
+#define GUI__PLAYLIST_TREE_VIEW_H
+
+#include <array>
+#include <gtkmm/cellrenderertext.h>
+#include <gtkmm/treeview.h>
+#include <optional>
+
+#include "Gui/PlaylistModel.h"
+
+
+namespace Gui
+{
+
+/* #The view of a playlist page, showing the line, name and duration of each row.
+! The view is in fixed-height mode with fixed-width columns, so inserting rows doesn't measure
+them. Rows can be streamed into a shown view.
+! The view detaches from the model while it's reset, and is then scrolled back to where it was
+with the same rows selected and the cursor on the same row, those that still exist.
+! The cell data functions run for every visible cell on each redraw, so they don't allocate
+themselves: the row index is read from the iterator, the text is formatted into stack buffers
+and the attribute lists are built once and shared. The renderers still copy the text of each
+cell, `GtkCellRendererText` can't be given one without a copy.
+*/
+class PlaylistTreeView final : public Gtk::TreeView
+{
+public:
+	using Model = PlaylistModel;
+	using ColumnBit = NotebookColBit;
+	
+	PlaylistTreeView(void);
+	
+	[[nodiscard]] Model& get_playlist_model(void);
+	
+	// Columns in the order they're shown, for driving the cell data functions directly
+	[[nodiscard]] std::array<Gtk::TreeViewColumn*, 3> get_render_columns(void);
+	
+private:
+	struct CellColumn
+	{
+		Gtk::TreeViewColumn *column;
+		Gtk::CellRendererText *renderer;
+		// attribute list currently set on `renderer`, to only set it when it changes
+		const PangoAttrList *attributes;
+	};
+	
+	Glib::RefPtr<Model> m_model;
+	CellColumn m_line, m_name, m_duration;
+	// where the view was before the model was reset, restored once it's attached again
+	PageViewState m_resetState;
+	std::optional<size_t> m_resetCursor;
+	
+	
+	void cb__model_reset(Model::ResetPhase phase);
+	
+	// Remember where the view is, before it's detached from the model
+	void save_reset_state(void);
+	
+	// Put the view back where it was, once it's attached again
+	void restore_reset_state(void);
+	
+	void cb__render_line(Gtk::CellRenderer *cellRenderer, const Gtk::TreeIter &iter);
+	void cb__render_name(Gtk::CellRenderer *cellRenderer, const Gtk::TreeIter &iter);
+	void cb__render_duration(Gtk::CellRenderer *cellRenderer, const Gtk::TreeIter &iter);
+	
+	CellColumn append_cell_column(
+		void (PlaylistTreeView::*dataFunc)(Gtk::CellRenderer*, const Gtk::TreeIter&)
+	);
+	
+	// Width a cell needs to show `text`, with the current font
+	[[nodiscard]] int text_width(const CellColumn &cell, const char *text);
+	
+	// Set the text and attributes of a cell, `text` is copied by the renderer
+	void set_cell(CellColumn &cell, const char *text, size_t row, ColumnBit column) const;
+};
+
+}
+
+#endif /* GUI__PLAYLIST_TREE_VIEW_H */
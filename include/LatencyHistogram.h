@@ -0,0 +1,65 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+
+/* #Histogram of durations with a bounded relative error, in the manner of HdrHistogram.
+! Durations are counted in microseconds. Those under `1 << SUB_BITS` µs are exact, longer ones
+fall in buckets spanning 1/64th of their power of two, so a percentile is never off by more
+than about 1.6%. Durations past `MAX` are counted as `MAX`.
+! Recording is a few instructions with no allocation, the buckets are part of the object.
+*/
+class LatencyHistogram final
+{
+public:
+	using Duration = std::chrono::microseconds;
+	
+	// bits of a duration kept exact
+	static constexpr unsigned SUB_BITS = 7;
+	// durations are counted up to 2^MAX_BITS µs (about 71 minutes)
+	static constexpr unsigned MAX_BITS = 32;
+	static constexpr Duration MAX { (uint64_t(1) << MAX_BITS) - 1 };
+	
+	
+	LatencyHistogram(void);
+	
+	void record(Duration duration);
+	
+	// Forget every duration recorded.
+	void reset(void);
+	
+	// Number of durations recorded.
+	[[nodiscard]] uint64_t count(void) const;
+	
+	/* #The duration under which a percentage of the durations are.
+	! @param percent: from 0 to 100.
+	! @return: 0 when nothing was recorded.
+	*/
+	[[nodiscard]] Duration percentile(double percent) const;
+	
+	// Longest duration recorded, exact.
+	[[nodiscard]] Duration max(void) const;
+	
+	[[nodiscard]] Duration mean(void) const;
+	
+private:
+	static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+	static constexpr size_t HALF_BUCKETS = SUB_BUCKETS / 2;
+	static constexpr size_t BUCKETS = SUB_BUCKETS + (MAX_BITS - SUB_BITS) * HALF_BUCKETS;
+	
+	std::array<uint64_t, BUCKETS> m_counts;
+	uint64_t m_count;
+	uint64_t m_total; // µs
+	uint64_t m_max; // µs
+	
+	
+	[[nodiscard]] static size_t bucket_of(uint64_t value);
+	
+	// Highest value counted in a bucket
+	[[nodiscard]] static uint64_t bucket_top(size_t bucket);
+};
+
+#endif /* LATENCY_HISTOGRAM_H */
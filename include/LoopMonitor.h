@@ -0,0 +1,117 @@
+#ifndef LOOP_MONITOR_H
+#define LOOP_MONITOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <momuma/sigc.h>
+#include <mutex>
+#include <thread>
+
+#include "LatencyHistogram.h"
+#include "Trace.h"
+
+
+/* #Finds out which callbacks hold the main loop back.
+! `MONITOR_CALLBACK("name")` marks the rest of a scope as being the named callback: its
+duration goes into a `LatencyHistogram` of that name, and `Watchdog` reports it when the main
+loop stalls while it runs. It's also a `TRACE_SPAN()`. Only callbacks of the main loop may be
+monitored, the name must be a string literal.
+! The percentiles of every callback are logged by `log_histograms()`.
+*/
+namespace LoopMonitor
+{
+
+using Clock = std::chrono::steady_clock;
+
+// environment variable overriding the stall threshold, in milliseconds (0 disables it)
+constexpr char THRESHOLD_ENV[] = "MOMUMA_GTK_STALL_MS";
+constexpr std::chrono::milliseconds DEFAULT_THRESHOLD { 250 };
+// callbacks nested deeper than this are timed, but not reported by the watchdog
+constexpr size_t MAX_DEPTH = 8;
+
+// Read the stall threshold from `THRESHOLD_ENV`, falling back to `DEFAULT_THRESHOLD`.
+[[nodiscard]] std::chrono::milliseconds threshold_from_env(void);
+
+// The histogram of a callback, created on first use.
+[[nodiscard]] LatencyHistogram& histogram(const char *name);
+
+// Log the percentiles of every callback, the slowest first.
+void log_histograms(void);
+
+// Marks a scope as a callback, see `MONITOR_CALLBACK()`
+class Scope final
+{
+public:
+	Scope(const char *name, LatencyHistogram &histogram);
+	~Scope(void);
+	
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+	
+private:
+	LatencyHistogram &d_histogram;
+	Clock::time_point m_begin;
+};
+
+
+/* #Reports the main loop when it doesn't iterate for longer than a threshold.
+! A timer of the main loop beats every half threshold, a thread of its own checks the beats.
+When they stop for longer than the threshold, the callbacks running at that moment are logged
+right away, so a hang is reported even if it never ends. The length of the stall is logged
+once the main loop iterates again.
+*/
+class Watchdog final
+{
+public:
+	explicit Watchdog(std::chrono::milliseconds threshold);
+	~Watchdog(void);
+	
+	Watchdog(const Watchdog&) = delete;
+	Watchdog& operator=(const Watchdog&) = delete;
+	
+	/* #Start watching, from the main loop's thread.
+	! Must be called once the main loop runs, a loop that isn't running yet looks stalled.
+	*/
+	void start(void);
+	
+	void stop(void);
+	
+	// Number of stalls detected so far.
+	[[nodiscard]] size_t stalls(void) const;
+	
+private:
+	const std::chrono::milliseconds m_threshold;
+	sigc::connection m_heartbeat;
+	// ticks of `Clock` of the last beat
+	std::atomic<Clock::rep> m_lastBeat;
+	// whether the current stall was reported already
+	std::atomic<bool> m_stalled;
+	std::atomic<size_t> m_stalls;
+	
+	std::mutex m_mutex;
+	std::condition_variable_any m_cv;
+	// must be the last member, so it's stopped before anything is destroyed
+	std::jthread m_thread;
+	
+	
+	bool cb__heartbeat(void);
+	
+	void thread_loop(std::stop_token stop);
+};
+
+}
+
+
+#define MONITOR__CONCAT_IMPL(a, b) a##b
+#define MONITOR__CONCAT(a, b) MONITOR__CONCAT_IMPL(a, b)
+
+#define MONITOR_CALLBACK(name) \
+	TRACE_SPAN(name); \
+	static LatencyHistogram &MONITOR__CONCAT(monitorHistogram_, __LINE__) = \
+		LoopMonitor::histogram(name); \
+	const LoopMonitor::Scope MONITOR__CONCAT(monitorScope_, __LINE__) { \
+		name, MONITOR__CONCAT(monitorHistogram_, __LINE__) \
+	}
+
+#endif /* LOOP_MONITOR_H */
@@ -0,0 +1,231 @@
+#ifndef MAIN_LOOP_CHANNEL_H
+#define MAIN_LOOP_CHANNEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <glibmm/main.h>
+#include <memory>
+#include <momuma/sigc.h>
+#include <span>
+#include <stop_token>
+#include <sys/eventfd.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+/* #Hands values from any number of threads to the main loop, without locks.
+! Values are pushed in a bounded ring buffer (a multi-producer single-consumer variant of
+Dmitry Vyukov's bounded queue), and the main loop is woken up through an eventfd. Only the
+first push after the main loop started draining writes to the eventfd.
+! The main loop drains the values in batches of at most `maxBatch` values, so a flood of values
+can't stall it. The handler gets all the values of a batch at once, to coalesce them.
+! Values pushed by the same thread are received in the order they were pushed.
+*/
+template <typename T>
+class MainLoopChannel final
+{
+public:
+	// Called on the main loop with the values received, which it may move from
+	using Handler = sigc::slot<void(std::span<T>)>;
+	
+	/* #Create a channel.
+	! @param capacity: number of values the channel holds, rounded up to a power of 2.
+	! @param maxBatch: number of values handled per main loop iteration, at most.
+	! @throw std::system_error: when the eventfd can't be created.
+	*/
+	explicit MainLoopChannel(size_t capacity, size_t maxBatch = 1024);
+	~MainLoopChannel(void);
+	
+	MainLoopChannel(const MainLoopChannel&) = delete;
+	MainLoopChannel& operator=(const MainLoopChannel&) = delete;
+	
+	/* #Start handling the values on the default main context.
+	! Must be called once, from the main loop's thread.
+	*/
+	void connect(Handler handler, int priority = Glib::PRIORITY_DEFAULT);
+	
+	/* #Push a value, from any thread.
+	! @return: false when the channel is full, `value` is left untouched.
+	*/
+	[[nodiscard]] bool try_push(T &&value);
+	
+	/* #Push a value from any thread, waiting while the channel is full.
+	! Gives up once a stop is requested on `stop`, as the main loop may not drain the channel
+	anymore, e.g when the application quits.
+	! @return: false when it gave up, `value` is left untouched.
+	*/
+	bool push(T &&value, const std::stop_token &stop = { });
+	
+	[[nodiscard]] size_t capacity(void) const;
+	
+private:
+	struct alignas(64) Cell
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+	
+	const size_t m_mask;
+	const size_t m_maxBatch;
+	std::unique_ptr<Cell[]> m_cells;
+	
+	alignas(64) std::atomic<size_t> m_enqueuePos;
+	// whether the eventfd was written to since the main loop last read it
+	alignas(64) std::atomic<bool> m_signalled;
+	
+	// only accessed from the main loop
+	alignas(64) size_t m_dequeuePos;
+	std::vector<T> m_batch;
+	int m_eventFd;
+	Handler m_handler;
+	sigc::connection m_source;
+	
+	
+	void signal(void);
+	
+	bool cb__readable(Glib::IOCondition condition);
+};
+
+
+// public
+// ==================================================
+
+template <typename T>
+MainLoopChannel<T>::MainLoopChannel(const size_t capacity, const size_t maxBatch) :
+	m_mask { std::bit_ceil(std::max<size_t>(capacity, 2)) - 1 },
+	m_maxBatch { std::max<size_t>(maxBatch, 1) },
+	m_cells { std::make_unique<Cell[]>(m_mask + 1) },
+	m_enqueuePos { 0 }, m_signalled { false },
+	m_dequeuePos { 0 }, m_batch { }, m_eventFd { -1 }, m_handler { }, m_source { }
+{
+	for (size_t i = 0; i <= m_mask; ++i) {
+		m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	m_batch.reserve(m_maxBatch);
+	
+	m_eventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (m_eventFd < 0) {
+		throw std::system_error(errno, std::generic_category(), "eventfd");
+	}
+}
+
+template <typename T>
+MainLoopChannel<T>::~MainLoopChannel(void)
+{
+	m_source.disconnect();
+	::close(m_eventFd);
+}
+
+template <typename T>
+void MainLoopChannel<T>::connect(Handler handler, const int priority)
+{
+	m_handler = std::move(handler);
+	m_source = Glib::signal_io().connect(sigc::mem_fun(*this, &MainLoopChannel::cb__readable),
+		m_eventFd, Glib::IO_IN, priority
+	);
+}
+
+template <typename T>
+bool MainLoopChannel<T>::try_push(T &&value)
+{
+	size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+	Cell *cell = nullptr;
+	while (true) {
+		cell = &m_cells[pos & m_mask];
+		const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+		if (diff == 0) {
+			// the cell is free, claim it
+			const bool claimed = m_enqueuePos.compare_exchange_weak(pos, pos + 1,
+				std::memory_order_relaxed
+			);
+			if (claimed) { break; }
+		}
+		else if (diff < 0) {
+			return false; // the cell wasn't consumed yet, the channel is full
+		}
+		else {
+			pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+	
+	cell->value = std::move(value);
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	this->signal();
+	return true;
+}
+
+template <typename T>
+bool MainLoopChannel<T>::push(T &&value, const std::stop_token &stop)
+{
+	for (unsigned attempt = 0; !this->try_push(std::move(value)); ++attempt) {
+		if (stop.stop_requested()) { return false; }
+		// the main loop is busy, leave it the core
+		if (attempt < 64) {
+			std::this_thread::yield();
+		}
+		else {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+	return true;
+}
+
+template <typename T>
+size_t MainLoopChannel<T>::capacity(void) const
+{
+	return m_mask + 1;
+}
+
+
+
+// private
+// ==================================================
+
+template <typename T>
+void MainLoopChannel<T>::signal(void)
+{
+	if (m_signalled.exchange(true, std::memory_order_acq_rel)) { return; }
+	
+	const uint64_t one = 1;
+	// can only fail when the counter would overflow, in which case it's readable anyway
+	(void)!::write(m_eventFd, &one, sizeof(one));
+}
+
+template <typename T>
+bool MainLoopChannel<T>::cb__readable(Glib::IOCondition)
+{
+	uint64_t count = 0;
+	(void)!::read(m_eventFd, &count, sizeof(count));
+	// from here on, pushes wake the main loop up again. Exchanged rather than stored, to
+	// synchronize with the pushes that found it set and didn't write to the eventfd
+	(void)m_signalled.exchange(false, std::memory_order_acq_rel);
+	
+	m_batch.clear();
+	while (m_batch.size() < m_maxBatch) {
+		Cell &cell = m_cells[m_dequeuePos & m_mask];
+		const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+		if (sequence != m_dequeuePos + 1) { break; } // empty, or still being written
+		
+		m_batch.push_back(std::move(cell.value));
+		cell.sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+		++m_dequeuePos;
+	}
+	
+	if (m_batch.size() == m_maxBatch) {
+		// there may be more, handled on the next iteration so other sources get to run
+		this->signal();
+	}
+	if (!m_batch.empty()) {
+		m_handler(std::span<T>(m_batch));
+	}
+	return true;
+}
+
+#endif /* MAIN_LOOP_CHANNEL_H */
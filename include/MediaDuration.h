@@ -0,0 +1,30 @@
+#ifndef MEDIA_DURATION_H
+#define MEDIA_DURATION_H
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
+
+namespace Media
+{
+
+/* #Read the duration of a media file directly from its container headers.
+! Supported formats: FLAC (STREAMINFO), MP3 (Xing/Info/VBRI frames, otherwise assumed to be CBR),
+Ogg Vorbis/Opus (last granule position), WAV (fmt/data chunks) and MP4/M4A (mvhd box).
+! Only the few KiB needed are read with `pread()`, and nothing is allocated.
+! @return: an empty optional when the format isn't supported or the headers are invalid.
+*/
+[[nodiscard]]
+std::optional<std::chrono::microseconds> parse_duration(const std::filesystem::path &path);
+
+/* #Get the duration of a media file.
+! Uses `parse_duration()`, and falls back to `Momuma::MpvPlayer::query_duration()` for formats
+it doesn't understand.
+*/
+[[nodiscard]]
+std::chrono::microseconds query_duration(const std::filesystem::path &path);
+
+}
+
+#endif /* MEDIA_DURATION_H */
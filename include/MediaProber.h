@@ -0,0 +1,114 @@
+#ifndef MEDIA_PROBER_H
+#define MEDIA_PROBER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <momuma/sigc.h>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Backend.h"
+#include "MainLoopChannel.h"
+#include "Pages.h"
+
+
+/* #Probes media durations on a pool of worker threads.
+! The durations are read by the backend's probe, `Media::query_duration()` for the real one.
+Requests are queued per page. The results are handed back to the main loop through a
+`MainLoopChannel`, and emitted by `signal_probed()` with one batch per page.
+*/
+class MediaProber final
+{
+public:
+	struct Request
+	{
+		size_t row;
+		std::filesystem::path path;
+	};
+	
+	struct Probed
+	{
+		size_t row;
+		// 0 when the file couldn't be probed
+		std::chrono::milliseconds duration;
+		std::filesystem::path path;
+	};
+	
+	explicit MediaProber(Backend::ProbeFunc probe);
+	~MediaProber(void);
+	
+	MediaProber(const MediaProber&) = delete;
+	MediaProber& operator=(const MediaProber&) = delete;
+	
+	/* #Queue the files of a page to be probed.
+	! May be called multiple times for the same page.
+	! @param page: the page the rows belong to.
+	! @param requests: the rows to probe, in the order they should be probed.
+	*/
+	void probe(PageId page, std::vector<Request> requests);
+	
+	/* #Drop every pending probe of a page.
+	! Probes that are already running are finished, but their results are discarded.
+	*/
+	void cancel(PageId page);
+	
+	// Number of worker threads in the pool.
+	[[nodiscard]] size_t workers(void) const;
+	
+	// Emitted on the main loop with a batch of results for a single page
+	[[nodiscard]]
+	sigc::signal<void(PageId, const std::vector<Probed>&)> signal_probed(void);
+	
+private:
+	struct Job
+	{
+		PageId page;
+		uint64_t ticket;
+		Request request;
+	};
+	
+	struct Result
+	{
+		PageId page;
+		uint64_t ticket;
+		Probed probed;
+	};
+	
+	struct Pending
+	{
+		uint64_t ticket;
+		size_t remaining;
+	};
+	
+	// called by every worker
+	const Backend::ProbeFunc m_probe;
+	
+	std::mutex m_jobsMutex;
+	std::condition_variable_any m_jobsCv;
+	std::deque<Job> m_jobs;
+	
+	// results waiting for the main loop
+	static constexpr size_t RESULTS_CAPACITY = 4096;
+	MainLoopChannel<Result> m_results;
+	
+	// only accessed from the main loop
+	std::unordered_map<PageId, Pending> m_pending;
+	uint64_t m_lastTicket;
+	
+	sigc::signal<void(PageId, const std::vector<Probed>&)> m_signal_probed;
+	
+	// must be the last member, so the workers are stopped before anything is destroyed
+	std::vector<std::jthread> m_workers;
+	
+	
+	void worker_loop(std::stop_token stop);
+	
+	void cb__results_ready(std::span<Result> results);
+};
+
+#endif /* MEDIA_PROBER_H */
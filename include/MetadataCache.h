@@ -0,0 +1,109 @@
+#ifndef METADATA_CACHE_H
+#define METADATA_CACHE_H
+
+#include <chrono>
+#include <filesystem>
+#include <glibmm/ustring.h>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+
+
+/* #Persistent cache of media metadata.
+! The cache is a single binary file which is memory-mapped when the cache is created.
+Its entries are found through an open-addressed (linear probing) hash index stored in the
+file itself, so a lookup never has to read the whole file.
+! New entries are kept in memory until `save()` rewrites the file.
+! Each entry keeps the day it was last found or inserted, `save()` drops the entries that
+weren't used for `MAX_IDLE`, e.g. those of files that were moved or removed since.
+*/
+class MetadataCache final
+{
+public:
+	// An entry is only valid for the exact file it was created from
+	struct Key
+	{
+		std::filesystem::path path;
+		uintmax_t size;
+		int64_t mtime; // nanoseconds since the epoch
+	};
+	
+	struct Entry
+	{
+		std::chrono::milliseconds duration;
+		Glib::ustring name;
+	};
+	
+	struct Stats
+	{
+		size_t hits;
+		size_t misses;
+	};
+	
+	// entries that weren't used for that long are dropped
+	static constexpr std::chrono::days MAX_IDLE { 90 };
+	
+	
+	/* #Create a key for an existing file.
+	! @return: an empty optional when the file's status can't be read.
+	*/
+	[[nodiscard]] static std::optional<Key> make_key(std::filesystem::path path);
+	
+	/* #Map the cache file into memory.
+	! A missing or invalid file is treated as an empty cache, and is replaced on `save()`.
+	*/
+	explicit MetadataCache(std::filesystem::path file);
+	~MetadataCache(void);
+	
+	MetadataCache(const MetadataCache&) = delete;
+	MetadataCache& operator=(const MetadataCache&) = delete;
+	
+	/* #Look up the entry of a file.
+	! Counts a hit or a miss.
+	*/
+	[[nodiscard]] std::optional<Entry> find(const Key &key);
+	
+	// Add an entry, or replace the entry of a file with the same path.
+	void insert(const Key &key, Entry entry);
+	
+	/* #Write all entries to the cache file, except the ones not used for `MAX_IDLE`.
+	! The file is only rewritten when it changes: there are unsaved entries, entries used on a
+	day other than the one saved, or entries to drop.
+	! The file is replaced atomically, and mapped again afterwards.
+	! @return: false when writing the file failed.
+	*/
+	bool save(void);
+	
+	// Hits and misses counted since the last call to `take_stats()`.
+	[[nodiscard]] Stats take_stats(void);
+	
+private:
+	struct Slot;
+	
+	std::filesystem::path m_file;
+	
+	// the memory-mapped file, empty when there's none
+	std::span<const std::byte> m_map;
+	std::span<const Slot> m_slots;
+	std::span<const char> m_strings;
+	// the oldest use of an entry of the file, in days since the epoch
+	uint32_t m_oldestUse;
+	// indices of the slots found since the file was mapped
+	std::unordered_set<size_t> m_used;
+	
+	// entries added since the file was mapped, keyed by path
+	std::unordered_map<std::string, std::pair<Key, Entry>> m_unsaved;
+	
+	Stats m_stats;
+	
+	
+	bool map_file(void);
+	void unmap_file(void);
+	
+	[[nodiscard]] const Slot* find_slot(const std::string &path) const;
+	
+	[[nodiscard]] std::string_view slot_string(uint32_t offset, uint32_t length) const;
+};
+
+#endif /* METADATA_CACHE_H */
@@ -0,0 +1,39 @@
+#ifndef MOMUMA_BACKEND_H
+#define MOMUMA_BACKEND_H
+
+#include <filesystem>
+#include <memory>
+#include <momuma/momuma.h>
+
+#include "Backend.h"
+
+
+/* #The backend of the library: libmpv for the player, and SQLite for the database.
+! Created on a thread of its own, it takes a while.
+*/
+class MomumaBackend final : public Backend
+{
+public:
+	explicit MomumaBackend(const std::filesystem::path &folder);
+	~MomumaBackend(void) override;
+	
+	MomumaBackend(const MomumaBackend&) = delete;
+	MomumaBackend& operator=(const MomumaBackend&) = delete;
+	
+	[[nodiscard]] bool is_valid(void) const override;
+	
+	[[nodiscard]] Player& get_player(void) override;
+	
+	[[nodiscard]] Database& get_database(void) override;
+	
+private:
+	class MpvPlayer;
+	class Sqlite3;
+	
+	Momuma::Momuma m_momuma;
+	// `nullptr` when `m_momuma` isn't valid
+	std::unique_ptr<MpvPlayer> m_player;
+	std::unique_ptr<Sqlite3> m_database;
+};
+
+#endif /* MOMUMA_BACKEND_H */
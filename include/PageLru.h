@@ -0,0 +1,64 @@
+#ifndef PAGE_LRU_H
+#define PAGE_LRU_H
+
+#include <chrono>
+#include <list>
+#include <momuma/sigc.h>
+#include <unordered_map>
+#include <vector>
+
+#include "Pages.h"
+
+
+/* #Decides which pages give their rows back once they use too much memory.
+! Pages are ordered by when they were last focused. When the pages use more than the budget
+together, the least recently focused ones are evicted until the rest fits, skipping the pages
+that can't be evicted and those that were focused not long ago.
+*/
+class PageLru final
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	
+	// environment variable overriding the budget, in MiB
+	static constexpr char BUDGET_ENV[] = "MOMUMA_GTK_PAGE_MEMORY_MB";
+	static constexpr size_t DEFAULT_BUDGET = 512ULL << 20;
+	// pages focused more recently than this are never evicted
+	static constexpr std::chrono::minutes MIN_INACTIVE { 2 };
+	
+	// Read the budget from `BUDGET_ENV`, falling back to `DEFAULT_BUDGET`.
+	[[nodiscard]] static size_t budget_from_env(void);
+	
+	// @param budget: bytes the pages may use together before they're evicted.
+	explicit PageLru(size_t budget);
+	
+	// Mark the page as the most recently focused one.
+	void touch(PageId page);
+	
+	// Stop tracking the page, e.g. once it's removed.
+	void forget(PageId page);
+	
+	/* #Pick the pages to evict so the others fit in the budget, least recently focused first.
+	! @param usage: number of bytes used by a page.
+	! @param evictable: whether a page can be evicted, e.g. it isn't playing.
+	*/
+	[[nodiscard]] std::vector<PageId> select_victims(
+		const sigc::slot<size_t(PageId)> &usage, const sigc::slot<bool(PageId)> &evictable
+	) const;
+	
+	[[nodiscard]] size_t budget(void) const;
+	
+private:
+	struct Entry
+	{
+		PageId page;
+		Clock::time_point focused;
+	};
+	
+	const size_t m_budget;
+	// most recently focused first
+	std::list<Entry> m_order;
+	std::unordered_map<PageId, std::list<Entry>::iterator> m_entries;
+};
+
+#endif /* PAGE_LRU_H */
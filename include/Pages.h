@@ -1,6 +1,12 @@
 #ifndef PAGES_H
 #define PAGES_H
 
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "DatabaseService.h"
 #include "Gui/PlaylistNotebook.h"
 
 
@@ -10,8 +16,26 @@ struct PageData
 {
 	Glib::ustring name;
 	bool unsaved;
+	// path of each row, shared with the playback while the page is playing
+	std::shared_ptr<const std::vector<std::filesystem::path>> paths;
+	// reads the paths from the database, until they're all read
+	DatabaseService::Request query;
+	// approximate number of bytes used by `paths`
+	size_t pathsMemory;
+	// where the view was when the page was evicted, until it's shown again
+	std::optional<Gui::PageViewState> view;
+	// page of the session snapshot the rows are restored from, until they're restored
+	std::optional<size_t> sessionPage;
 };
 
+// Approximate number of bytes used by the paths of a page, see `PageData::pathsMemory`.
+[[nodiscard]] size_t paths_memory(const std::vector<std::filesystem::path> &paths);
+
+/* #The pages that are playlists, the others only exist in their view.
+! A `PageId` is the address of the page's container, which a new page may get once the page is
+closed. So the entry of a page must be erased when it's removed, for a new page not to be taken
+for the closed playlist.
+*/
 class PageMap final : public std::unordered_map<PageId, PageData>
 {
 public:
@@ -21,6 +45,9 @@ public:
 	
 	[[nodiscard]] bool has_playing_page(void);
 	
+	// Mark a page as playing without activating one of its rows, e.g when restoring it.
+	void set_playing(PageId id);
+	
 	void connect_page_destroyed(Gui::PlaylistNotebook &src);
 	void connect_row_activated(Gui::PlaylistNotebook &src);
 	
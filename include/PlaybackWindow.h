@@ -0,0 +1,103 @@
+#ifndef PLAYBACK_WINDOW_H
+#define PLAYBACK_WINDOW_H
+
+#include <filesystem>
+#include <memory>
+#include <momuma/sigc.h>
+#include <optional>
+#include <vector>
+
+#include "Backend.h"
+#include "Pages.h"
+
+
+/* #Keeps only a few tracks of the playing page in the player's playlist.
+! The playing row, up to `AHEAD` rows after it and `AHEAD` rows before it are loaded in the
+player. The window slides forward as the playback advances, the played entries being removed
+from the player, and is rebuilt from the new row when jumping outside of it. A player that can't
+remove entries (e.g. mpv's) keeps the played ones until then, the playback is never interrupted
+to shrink its playlist.
+! When (re)built, only the playing row is loaded right away so it can start as soon as
+possible. The rows after it are appended a few at a time from idle callbacks.
+! Indices of the player's playlist are offset from the rows of the page, use `index_to_row()`
+and `row_to_index()` to convert between the two.
+*/
+class PlaybackWindow final
+{
+public:
+	using Paths = std::shared_ptr<const std::vector<std::filesystem::path>>;
+	
+	static constexpr size_t AHEAD = 8;
+	// rows appended per idle callback
+	static constexpr size_t FILL_CHUNK = 2;
+	
+	explicit PlaybackWindow(Backend::Player &player);
+	~PlaybackWindow(void);
+	
+	PlaybackWindow(const PlaybackWindow&) = delete;
+	PlaybackWindow& operator=(const PlaybackWindow&) = delete;
+	
+	/* #Replace the player's playlist with a window around a row of a page.
+	! The player is stopped, and left at the index of `row` (it's not started).
+	! @param page: the page the paths belong to.
+	! @param paths: the paths of every row of the page.
+	! @param row: the row to play.
+	! @return: false when `row` is out of range or a path couldn't be loaded.
+	*/
+	bool load(PageId page, Paths paths, size_t row);
+	
+	/* #Move the playback to another row of the current page.
+	! Uses the loaded window when it contains `row`, otherwise it's rebuilt around it.
+	! @return: false when `row` is out of range or a path couldn't be loaded.
+	*/
+	bool jump(size_t row);
+	
+	/* #Queue tracks so there are `AHEAD` of them after the playing one, and drop the played
+	ones so there are at most `AHEAD` of them before it, when the player can remove them.
+	! Must be called whenever the player moves to another entry of its playlist.
+	*/
+	void advance(void);
+	
+	// Drop the window, e.g when the playing page is closed.
+	void reset(void);
+	
+	// The page being played, `PageId::Null` when nothing was loaded.
+	[[nodiscard]] PageId page(void) const;
+	
+	// Number of rows in the page being played.
+	[[nodiscard]] size_t rows(void) const;
+	
+	// The row of the player's current entry.
+	[[nodiscard]] std::optional<size_t> current_row(void) const;
+	
+	[[nodiscard]] std::optional<size_t> index_to_row(int64_t index) const;
+	
+	[[nodiscard]] std::optional<int64_t> row_to_index(size_t row) const;
+	
+private:
+	Backend::Player &d_player;
+	PageId m_page;
+	Paths m_paths;
+	size_t m_first; // row of the first entry in the player's playlist
+	size_t m_size; // number of entries in the player's playlist
+	
+	// appends the rows up to `m_fillEnd` from idle callbacks
+	sigc::connection m_filler;
+	size_t m_fillEnd;
+	
+	
+	bool rebuild(size_t row);
+	
+	// Remove the entries more than `AHEAD` before the playing `row` from the player's playlist
+	void trim(size_t row);
+	
+	// Append the rows [m_first + m_size, end) to the player's playlist
+	bool append_until(size_t end);
+	
+	// Append the rows up to `end` (excluded) in the background
+	void fill_until(size_t end);
+	
+	bool cb__fill(void);
+};
+
+#endif /* PLAYBACK_WINDOW_H */
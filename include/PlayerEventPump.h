@@ -0,0 +1,83 @@
+#ifndef PLAYER_EVENT_PUMP_H
+#define PLAYER_EVENT_PUMP_H
+
+#include <array>
+#include <chrono>
+#include <glibmm/main.h>
+#include <momuma/sigc.h>
+#include <optional>
+
+#include "Backend.h"
+
+
+/* #Delivers the events of a `Backend::Player` on the main loop.
+! When the player supports it (see `Backend::Player::set_wakeup()`), it wakes the main loop up
+through an eventfd for every event it queues, like a `MainLoopChannel`. The events are then
+handled as soon as they're queued, and nothing runs in between.
+! Otherwise the events are polled. The player only produces events in reaction to a command, or
+when a stream ends. So the events are drained right after each command (see `kick()`), then on
+a short backoff while the player reacts to it. While playing, a wakeup is armed for the end of
+the current stream, at most a second away. Nothing is left running while the player is paused
+or stopped.
+*/
+class PlayerEventPump final : public sigc::trackable
+{
+public:
+	/* #Start delivering the events of `player`.
+	! @throw std::system_error: when the eventfd can't be created.
+	*/
+	explicit PlayerEventPump(Backend::Player &player);
+	~PlayerEventPump(void);
+	
+	PlayerEventPump(const PlayerEventPump&) = delete;
+	PlayerEventPump& operator=(const PlayerEventPump&) = delete;
+	
+	/* #Drain the events of the player as soon as the main loop is idle.
+	! Must be called after every command sent to the player. Does nothing when the player wakes
+	the pump up by itself.
+	*/
+	void kick(void);
+	
+	// Whether the player wakes the pump up, rather than being polled.
+	[[nodiscard]] bool is_woken_up(void) const;
+	
+	// Number of times the events were drained, for diagnostics.
+	[[nodiscard]] uint64_t wakeups(void) const;
+	
+private:
+	// delays between the drains following a command or an event
+	static constexpr std::array<std::chrono::milliseconds, 10> BURST_DELAYS = {
+		std::chrono::milliseconds(1), std::chrono::milliseconds(2),
+		std::chrono::milliseconds(4), std::chrono::milliseconds(8),
+		std::chrono::milliseconds(16), std::chrono::milliseconds(32),
+		std::chrono::milliseconds(64), std::chrono::milliseconds(128),
+		std::chrono::milliseconds(256), std::chrono::milliseconds(512),
+	};
+	
+	Backend::Player &d_player;
+	int m_eventFd;
+	bool m_wokenUp;
+	sigc::connection m_source;
+	size_t m_burstStep;
+	bool m_pumping;
+	uint64_t m_wakeups;
+	
+	
+	// Handle as many events as the player woke the pump up for
+	bool cb__readable(Glib::IOCondition condition);
+	
+	bool cb__pump(void);
+	
+	// Arm the next wakeup, if any is needed
+	void schedule_next(void);
+	
+	void schedule(std::chrono::milliseconds delay);
+	
+	// Time left until the current stream ends, or `nullopt` when it's unknown
+	[[nodiscard]] std::optional<std::chrono::milliseconds> time_until_stream_end(void);
+	
+	// Any event may be followed by others (e.g. a stream ending and the next one starting)
+	void cb__player_event(void);
+};
+
+#endif /* PLAYER_EVENT_PUMP_H */
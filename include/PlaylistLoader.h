@@ -0,0 +1,71 @@
+#ifndef PLAYLIST_LOADER_H
+#define PLAYLIST_LOADER_H
+
+#include <filesystem>
+#include <memory>
+#include <momuma/sigc.h>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+#include "Gui/PlaylistNotebook.h"
+#include "MediaProber.h"
+#include "Pages.h"
+#include "TaskScheduler.h"
+
+
+/* #Streams the rows of playlists into their pages, without blocking the main loop.
+! Each page is loaded by a task of a `TaskScheduler`, which makes the rows from the paths of the
+page and appends them in batches, yielding between two of them. The tasks are tied to the token
+of their page, so they stop when the page is removed.
+! Rows whose duration isn't known are queued in a `MediaProber` as they're appended.
+! The tab label of a loading page shows its progress.
+*/
+class PlaylistLoader final
+{
+public:
+	using Paths = std::shared_ptr<const std::vector<std::filesystem::path>>;
+	// Returns the row of a known file, `nullopt` when it must be probed
+	using RowLookup =
+		sigc::slot<std::optional<Gui::NotebookRowData>(const std::filesystem::path&)>;
+	
+	// rows made and appended between two yields
+	static constexpr size_t BATCH_ROWS = 64;
+	
+	PlaylistLoader(Gui::PlaylistNotebook &notebook, MediaProber &prober,
+		TaskScheduler &scheduler
+	);
+	~PlaylistLoader(void);
+	
+	PlaylistLoader(const PlaylistLoader&) = delete;
+	PlaylistLoader& operator=(const PlaylistLoader&) = delete;
+	
+	/* #Start loading the rows of a page.
+	! Pages are loaded one after the other, in the order they were queued.
+	! @param page: an empty page.
+	! @param paths: the path of each row.
+	! @param lookup: called for each path, on the main loop.
+	*/
+	void load(PageId page, Paths paths, RowLookup lookup);
+	
+	[[nodiscard]] bool is_loading(PageId page) const;
+	
+	// Emitted once every row of a page was appended
+	[[nodiscard]] sigc::signal<void(PageId)> signal_loaded(void);
+	
+private:
+	Gui::PlaylistNotebook &d_notebook;
+	MediaProber &d_prober;
+	TaskScheduler &d_scheduler;
+	std::unordered_set<PageId> m_loading;
+	
+	sigc::signal<void(PageId)> m_signal_loaded;
+	
+	
+	TaskScheduler::Task load_task(PageId page, Paths paths, RowLookup lookup);
+	
+	// Show the progress in the tab label, returns the percentage shown
+	int show_progress(PageId page, const Glib::ustring &title, size_t loaded, size_t total);
+};
+
+#endif /* PLAYLIST_LOADER_H */
@@ -0,0 +1,63 @@
+#ifndef PLAYLIST_OPENER_H
+#define PLAYLIST_OPENER_H
+
+#include <filesystem>
+#include <momuma/sigc.h>
+#include <vector>
+
+#include "DatabaseService.h"
+#include "Gui/PlaylistNotebook.h"
+#include "MediaProber.h"
+#include "MetadataCache.h"
+#include "Pages.h"
+#include "PlaylistLoader.h"
+
+
+/* #Opens the pages of playlists, and fills them with their rows.
+! The paths of a playlist are read by a `DatabaseService`, then its rows are made by a
+`PlaylistLoader`. Durations are taken from a `MetadataCache` when possible, the others are
+probed by a `MediaProber` and added to the cache once known.
+! Keeps the entries of the pages it opens in a `PageMap`, and erases them once their page is
+removed.
+*/
+class PlaylistOpener final : public sigc::trackable
+{
+public:
+	PlaylistOpener(Gui::PlaylistNotebook &notebook, PageMap &pages, DatabaseService &database,
+		MetadataCache &cache, MediaProber &prober, PlaylistLoader &loader
+	);
+	
+	PlaylistOpener(const PlaylistOpener&) = delete;
+	PlaylistOpener& operator=(const PlaylistOpener&) = delete;
+	
+	/* #Add a page for a playlist, and load its rows.
+	! The rows are read in the background, `PlaylistLoader::signal_loaded()` is emitted once
+	they're all in the page. A failure to read them is logged once it's known.
+	*/
+	PageId open(const Glib::ustring &playlist);
+	
+	/* #Read the paths of a page's playlist from the database, then load its rows.
+	! A failure to read the paths is logged once the query finished, the rows read until then
+	are loaded.
+	*/
+	void read(PageId id);
+	
+	// Make the rows of a page from `paths`
+	void load_rows(PageId id, std::vector<std::filesystem::path> &&paths);
+	
+private:
+	Gui::PlaylistNotebook &d_notebook;
+	PageMap &d_pages;
+	DatabaseService &d_database;
+	MetadataCache &d_cache;
+	MediaProber &d_prober;
+	PlaylistLoader &d_loader;
+	
+	
+	// The paths of a closed playlist aren't kept, and its id may be reused by a new page
+	void cb__page_remove(PageId id);
+	
+	void cb__durations_probed(PageId id, const std::vector<MediaProber::Probed> &batch);
+};
+
+#endif /* PLAYLIST_OPENER_H */
@@ -0,0 +1,40 @@
+#ifndef ROW_PLAYER_H
+#define ROW_PLAYER_H
+
+#include "Gui/PlaylistNotebook.h"
+#include "Pages.h"
+#include "PlaybackWindow.h"
+#include "PlayerEventPump.h"
+
+
+/* #Plays the rows of the pages, as activating one does.
+! The page is loaded in the player through a `PlaybackWindow`, unless it's already the one
+playing, and the row marked as the page's playing one. The page becomes the playing one of a
+`PageMap`. The events of the commands are drained by a `PlayerEventPump`.
+*/
+class RowPlayer final
+{
+public:
+	RowPlayer(Gui::PlaylistNotebook &notebook, PageMap &pages, Backend::Player &player,
+		PlaybackWindow &playback, PlayerEventPump &pump
+	);
+	
+	RowPlayer(const RowPlayer&) = delete;
+	RowPlayer& operator=(const RowPlayer&) = delete;
+	
+	/* #Start playing a row of a page, the playing row of the playing page is unmarked.
+	! @param page: the page of the row, one of the `PageMap`.
+	! @param paths: the paths of every row of the page.
+	! @param row: the row to play.
+	*/
+	void play(PageId page, PlaybackWindow::Paths paths, size_t row);
+	
+private:
+	Gui::PlaylistNotebook &d_notebook;
+	PageMap &d_pages;
+	Backend::Player &d_player;
+	PlaybackWindow &d_playback;
+	PlayerEventPump &d_pump;
+};
+
+#endif /* ROW_PLAYER_H */
@@ -0,0 +1,143 @@
+#ifndef SESSION_SNAPSHOT_H
+#define SESSION_SNAPSHOT_H
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+/* #Snapshot of the open pages, to restore them on startup without reading the database.
+! The snapshot is a single binary file which is memory-mapped when it's read. Pages and rows
+are fixed-size records pointing into a pool of strings, so restoring a page only touches its
+own rows.
+! Snapshots are made with a `SessionSnapshot::Builder`, which writes the file atomically.
+*/
+class SessionSnapshot final
+{
+private:
+	struct PageRecord;
+	struct RowRecord;
+	
+public:
+	struct Page
+	{
+		std::string_view name;
+		size_t rows;
+		// first row in view
+		std::optional<size_t> topRow;
+	};
+	
+	struct Row
+	{
+		std::string_view path;
+		std::string_view name;
+		// negative when unknown
+		std::chrono::seconds duration;
+	};
+	
+	// Collects pages and their rows, in the order they're shown
+	class Builder
+	{
+	public:
+		Builder(void);
+		~Builder(void);
+		
+		Builder(Builder&&);
+		Builder& operator=(Builder&&);
+		
+		// Start a new page, the rows added next belong to it.
+		void add_page(std::string_view name, std::optional<size_t> topRow);
+		
+		void add_row(std::string_view path, std::string_view name,
+			std::chrono::seconds duration
+		);
+		
+		// Add a page of another snapshot, with its rows.
+		void copy_page(const SessionSnapshot &snapshot, size_t page);
+		
+		// Mark the last page added as the one shown.
+		void mark_current(void);
+		
+		// Mark a row of the last page added as the one playing.
+		void mark_playing(size_t row);
+		
+		void set_volume(double volume);
+		
+		// Number of pages added.
+		[[nodiscard]] size_t pages(void) const;
+		
+		/* #Write the snapshot, replacing `file` atomically.
+		! Doesn't touch anything but the builder, so it may run on another thread.
+		! @return: false when writing the file failed.
+		*/
+		bool write(const std::filesystem::path &file) const;
+		
+	private:
+		std::vector<PageRecord> m_pages;
+		std::vector<RowRecord> m_rows;
+		std::string m_strings;
+		std::optional<size_t> m_current;
+		std::optional<std::pair<size_t, size_t>> m_playing;
+		std::optional<double> m_volume;
+		
+		
+		[[nodiscard]] std::pair<uint32_t, uint32_t> add_string(std::string_view s);
+	};
+	
+	
+	// Map the snapshot file into memory, a missing or invalid file is an empty snapshot.
+	explicit SessionSnapshot(std::filesystem::path file);
+	~SessionSnapshot(void);
+	
+	SessionSnapshot(const SessionSnapshot&) = delete;
+	SessionSnapshot& operator=(const SessionSnapshot&) = delete;
+	
+	// Whether there's no snapshot mapped.
+	[[nodiscard]] bool empty(void) const;
+	
+	[[nodiscard]] const std::filesystem::path& file(void) const;
+	
+	// Number of pages in the snapshot.
+	[[nodiscard]] size_t page_count(void) const;
+	
+	// Get a page, `page` must be less than `page_count()`.
+	[[nodiscard]] Page page(size_t page) const;
+	
+	// Get a row of a page, `row` must be less than the page's number of rows.
+	[[nodiscard]] Row row(size_t page, size_t row) const;
+	
+	// The page that was shown.
+	[[nodiscard]] std::optional<size_t> current_page(void) const;
+	
+	// The page and row that were playing.
+	[[nodiscard]] std::optional<std::pair<size_t, size_t>> playing(void) const;
+	
+	[[nodiscard]] std::optional<double> volume(void) const;
+	
+	// Unmap the file, once nothing is read from it anymore.
+	void close(void);
+	
+private:
+	std::filesystem::path m_file;
+	
+	// the memory-mapped file, empty when there's none
+	std::span<const std::byte> m_map;
+	std::span<const PageRecord> m_pages;
+	std::span<const RowRecord> m_rows;
+	std::span<const char> m_strings;
+	std::optional<size_t> m_current;
+	std::optional<std::pair<size_t, size_t>> m_playing;
+	std::optional<double> m_volume;
+	
+	
+	bool map_file(void);
+	
+	[[nodiscard]] std::string_view string(uint32_t offset, uint32_t length) const;
+};
+
+#endif /* SESSION_SNAPSHOT_H */
@@ -0,0 +1,37 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <chrono>
+
+
+/* #Times the startup, to keep track of how long it takes to get a usable window.
+! Each phase is logged with the time since `Startup::begin()` once it's first reached. The
+window is interactive once both the backend is ready and the first frame was drawn, at which
+point every phase is logged on a single line.
+! Only used from the main thread.
+*/
+namespace Startup
+{
+
+using Clock = std::chrono::steady_clock;
+
+enum class Phase
+{
+	INIT, // `Momuma::init()` returned
+	BACKEND, // the player and database are ready
+	FIRST_FRAME, // the window was drawn
+	INTERACTIVE, // both of the above
+	COUNT
+};
+
+// Start timing, first thing in `main()`.
+void begin(void);
+
+// Mark a phase as reached, only the first time counts.
+void reach(Phase phase);
+
+[[nodiscard]] bool has_reached(Phase phase);
+
+}
+
+#endif /* STARTUP_H */
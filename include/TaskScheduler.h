@@ -0,0 +1,170 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <gtkmm/widget.h>
+#include <memory>
+#include <momuma/sigc.h>
+#include <unordered_map>
+
+#include "Pages.h"
+
+
+/* #Spreads work across frames, from the main loop.
+! Tasks are coroutines returning `TaskScheduler::Task`. They run until they `co_await` a
+`TaskScheduler::Yield`, which only suspends them once the time budget of the current frame is
+spent. The rest of the task is resumed on the next frame.
+! Tasks run from an idle callback, below the redraws. The time spent running them is counted per
+frame of the widget's `Gdk::FrameClock`: once a frame's budget is spent, they wait for the next
+frame, however many times the main loop is idle meanwhile. A run also ends before the next frame
+is due. While the widget isn't shown, there are no frames and every run gets the whole budget.
+! Higher priority tasks run first, tasks of the same priority run one after the other in the
+order they were spawned.
+! A cancelled task is destroyed at its next suspension point instead of being resumed, its
+locals are destroyed as usual.
+*/
+class TaskScheduler final
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	
+	enum class Priority : size_t { HIGH, DEFAULT, LOW, COUNT };
+	
+	// time spent running tasks per frame, at most
+	static constexpr std::chrono::milliseconds FRAME_BUDGET { 4 };
+	// time spent running tasks per frame, at least, so they always progress
+	static constexpr std::chrono::microseconds MIN_BUDGET { 500 };
+	
+	
+	// `co_await Yield{}` lets the scheduler suspend the task, when its budget is spent
+	struct Yield {};
+	
+	/* #Shared by tasks that must stop together.
+	! A default constructed token is never cancelled.
+	*/
+	class CancelToken
+	{
+	public:
+		CancelToken(void);
+		
+		[[nodiscard]] bool is_cancelled(void) const;
+		
+		void cancel(void);
+		
+	private:
+		std::shared_ptr<bool> m_cancelled;
+	};
+	
+	// The return type of a task's coroutine.
+	class Task
+	{
+	public:
+		struct promise_type
+		{
+			TaskScheduler *scheduler = nullptr;
+			
+			Task get_return_object(void);
+			std::suspend_always initial_suspend(void) noexcept { return {}; }
+			std::suspend_always final_suspend(void) noexcept { return {}; }
+			void return_void(void) {}
+			void unhandled_exception(void);
+			
+			struct YieldAwaiter
+			{
+				const TaskScheduler *scheduler;
+				
+				[[nodiscard]] bool await_ready(void) const;
+				void await_suspend(std::coroutine_handle<>) const {}
+				void await_resume(void) const {}
+			};
+			[[nodiscard]] YieldAwaiter await_transform(Yield) const;
+		};
+		using Handle = std::coroutine_handle<promise_type>;
+		
+		Task(Task &&other);
+		Task& operator=(Task &&other);
+		~Task(void);
+		
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+		
+	private:
+		friend TaskScheduler;
+		Handle m_handle;
+		
+		explicit Task(Handle handle);
+	};
+	
+	
+	explicit TaskScheduler(Gtk::Widget &widget);
+	~TaskScheduler(void);
+	
+	TaskScheduler(const TaskScheduler&) = delete;
+	TaskScheduler& operator=(const TaskScheduler&) = delete;
+	
+	/* #Queue a task, it starts running on the next frame.
+	! @param task: a task that hasn't started yet.
+	! @param priority: the queue of the task.
+	! @param token: the task is dropped once it's cancelled.
+	*/
+	void spawn(Task task, Priority priority = Priority::DEFAULT, CancelToken token = {});
+	
+	/* #The token of the tasks working on a page.
+	! The same token is returned until `cancel_page()` is called for that page.
+	*/
+	[[nodiscard]] CancelToken page_token(PageId page);
+	
+	// Cancel the token of a page, and with it every task working on that page.
+	void cancel_page(PageId page);
+	
+	// Number of tasks that didn't finish yet.
+	[[nodiscard]] size_t pending(void) const;
+	
+	// Whether the budget of the current run is spent, tasks must yield when it is.
+	[[nodiscard]] bool budget_spent(void) const;
+	
+private:
+	struct Entry
+	{
+		Task task;
+		CancelToken token;
+	};
+	
+	Gtk::Widget &d_widget;
+	std::array<std::deque<Entry>, static_cast<size_t>(Priority::COUNT)> m_queues;
+	std::unordered_map<PageId, CancelToken> m_pageTokens;
+	sigc::connection m_source;
+	guint m_tick; // the wait for the next frame, once the budget of one is spent
+	sigc::connection m_unmap;
+	Clock::time_point m_deadline;
+	gint64 m_frame; // counter of the frame the budget is spent on
+	Clock::duration m_spent; // time spent running tasks during `m_frame`
+	bool m_running; // whether a task is being resumed
+	
+	
+	// Run the tasks when the main loop is idle, unless they wait for the next frame
+	void schedule(void);
+	
+	bool cb__run(void);
+	
+	bool cb__next_frame(const Glib::RefPtr<Gdk::FrameClock> &frameClock);
+	
+	// A hidden widget has no frames, the tasks waiting for one run right away
+	void cb__unmap(void);
+	
+	/* #When the running tasks must yield, from the frame clock when there's one.
+	! @param budget: what's left of the budget of the current frame.
+	*/
+	[[nodiscard]] Clock::time_point compute_deadline(Clock::duration budget) const;
+	
+	// Destroy the cancelled tasks, none may be running
+	void drop_cancelled(void);
+	
+	// The first task to run, `nullptr` when there's none
+	[[nodiscard]] std::deque<Entry>* next_queue(void);
+};
+
+#endif /* TASK_SCHEDULER_H */
@@ -0,0 +1,78 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <filesystem>
+
+
+/* #Spans of time spent in parts of the application, to see where the frame time goes.
+! `TRACE_SPAN("name")` times the rest of the enclosing scope. Spans are written to a ring buffer
+of the calling thread, which overwrites the oldest ones once it's full, so the cost of a span
+is two clock reads and a few stores. The name must be a string literal.
+! The macros compile to nothing unless the `tracing` build option is enabled. The trace is
+written on exit, once the threads are joined, as a Chrome trace-event file which Perfetto
+(https://ui.perfetto.dev) and `chrome://tracing` can open, when `FILE_ENV` names a file.
+*/
+namespace Trace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// environment variable naming the file the trace is written to on exit
+constexpr char FILE_ENV[] = "MOMUMA_GTK_TRACE";
+// spans kept per thread, the oldest are overwritten
+constexpr size_t BUFFER_SPANS = 1 << 16;
+
+// Record a span of the calling thread, `name` must outlive the trace.
+void record(const char *name, Clock::time_point begin, Clock::time_point end);
+
+// Name the calling thread in the trace.
+void set_thread_name(const char *name);
+
+/* #Write the trace as Chrome trace-event JSON.
+! The spans are read without synchronizing with the threads recording them, so every other
+thread that records spans must be joined first.
+! @return: false when the file couldn't be written.
+*/
+bool write_chrome_json(const std::filesystem::path &file);
+
+// Write the trace to the file named by `FILE_ENV`, when it's set, see `write_chrome_json()`.
+void write_from_env(void);
+
+// Times a scope, see `TRACE_SPAN()`
+class Span final
+{
+public:
+	explicit Span(const char *name) :
+		m_name { name }, m_begin { Clock::now() }
+	{
+	}
+	
+	~Span(void)
+	{
+		record(m_name, m_begin, Clock::now());
+	}
+	
+	Span(const Span&) = delete;
+	Span& operator=(const Span&) = delete;
+	
+private:
+	const char *m_name;
+	Clock::time_point m_begin;
+};
+
+}
+
+
+#define TRACE__CONCAT_IMPL(a, b) a##b
+#define TRACE__CONCAT(a, b) TRACE__CONCAT_IMPL(a, b)
+
+#if MOMUMA_GTK_TRACING
+	#define TRACE_SPAN(name) const Trace::Span TRACE__CONCAT(traceSpan_, __LINE__) { name }
+	#define TRACE_THREAD_NAME(name) Trace::set_thread_name(name)
+#else
+	#define TRACE_SPAN(name) ((void)0)
+	#define TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif /* TRACE_H */
@@ -5,6 +5,7 @@
 #include <filesystem>
 #include <gtkmm/widget.h>
 #include <pangomm/attrlist.h>
+#include <span>
 
 
 namespace Utils
@@ -18,6 +19,12 @@ contains 0 hours, otherwise it's equivalent to `"%d:%02d:%0d2"` (hours:minutes:s
 [[nodiscard]]
 std::string time_to_ui_string(std::chrono::seconds time);
 
+/* #Allocation-free version of `time_to_ui_string()`, writing into `buffer`.
+! The string is truncated to fit and is always NUL-terminated (`buffer` mustn't be empty).
+! @return: the length of the written string.
+*/
+size_t time_to_ui_string(std::chrono::seconds time, std::span<char> buffer);
+
 /* #Convenience function for creating `Pango::AttrList` s.
 ! The attributes are inserted from first to last using `Pango::AttrList::insert()`.
 ! @param attrs: list of attributes to create an `AttrList` from.
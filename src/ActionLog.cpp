@@ -0,0 +1,380 @@
+#include <algorithm>
+#include <charconv>
+#include <glibmm/main.h>
+#include <glibmm/miscutils.h>
+#include <momuma/spdlog.h>
+
+#include "ActionLog.h"
+#include "Trace.h"
+
+
+namespace ActionLog
+{
+
+// first line of a log, logs of another version aren't read
+constexpr std::string_view LOG_HEADER = "# momuma-gtk actions 1";
+
+constexpr std::array<const char*, static_cast<size_t>(Kind::COUNT)> KIND_NAMES {
+	"open", "placeholder", "focus", "next", "prev", "new", "close", "move", "activate", "drag",
+	"drop", "scroll"
+};
+
+
+template <typename T>
+[[nodiscard]] static bool parse_number(const std::string_view text, T &value)
+{
+	const char *const end = text.data() + text.size();
+	const auto [ptr, error] = std::from_chars(text.data(), end, value);
+	return error == std::errc() && ptr == end;
+}
+
+// Take the word up to the next space off `text`
+[[nodiscard]] static std::string_view take_word(std::string_view &text)
+{
+	const size_t space = std::min(text.find(' '), text.size());
+	const std::string_view word = text.substr(0, space);
+	text.remove_prefix(std::min(space + 1, text.size()));
+	return word;
+}
+
+[[nodiscard]] static inline double to_ms(const LatencyHistogram::Duration d)
+{
+	return chrono::duration<double, std::milli>(d).count();
+}
+
+[[nodiscard]] static inline double to_ms(const Clock::duration d)
+{
+	return chrono::duration<double, std::milli>(d).count();
+}
+
+const char* kind_name(const Kind kind)
+{
+	return KIND_NAMES.at(static_cast<size_t>(kind));
+}
+
+std::string format(const Action &action)
+{
+	std::string line = fmt::format("{:d} {:s}", action.delay.count(), kind_name(action.kind));
+	switch (action.kind)
+	{
+	case Kind::OPEN:
+	case Kind::PLACEHOLDER:
+		line += ' ';
+		line += action.playlist;
+		break;
+	case Kind::FOCUS:
+		line += fmt::format(" {:d}", action.page);
+		break;
+	case Kind::MOVE:
+	case Kind::ACTIVATE:
+		line += fmt::format(" {:d} {:d}", action.page, action.value);
+		break;
+	case Kind::DROP:
+	case Kind::SCROLL:
+		line += fmt::format(" {:d}", action.value);
+		break;
+	default:
+		break;
+	}
+	return line;
+}
+
+std::optional<Action> parse(std::string_view line)
+{
+	Action action { };
+	chrono::milliseconds::rep delay = 0;
+	if (!parse_number(take_word(line), delay) || delay < 0) { return std::nullopt; }
+	action.delay = chrono::milliseconds(delay);
+	
+	const std::string_view name = take_word(line);
+	const auto it = std::find(KIND_NAMES.begin(), KIND_NAMES.end(), name);
+	if (it == KIND_NAMES.end()) { return std::nullopt; }
+	action.kind = static_cast<Kind>(it - KIND_NAMES.begin());
+	
+	bool valid = true;
+	switch (action.kind)
+	{
+	case Kind::OPEN:
+	case Kind::PLACEHOLDER:
+		// the name is the rest of the line, spaces included
+		action.playlist = std::string(line);
+		line = { };
+		valid = !action.playlist.empty();
+		break;
+	case Kind::FOCUS:
+		valid = parse_number(take_word(line), action.page);
+		break;
+	case Kind::MOVE:
+	case Kind::ACTIVATE:
+		valid = parse_number(take_word(line), action.page)
+			&& parse_number(take_word(line), action.value);
+		break;
+	case Kind::DROP:
+	case Kind::SCROLL:
+		valid = parse_number(take_word(line), action.value);
+		break;
+	default:
+		break;
+	}
+	if (!valid || !line.empty()) { return std::nullopt; }
+	return action;
+}
+
+std::optional<std::vector<Action>> read(const fs::path &file)
+{
+	std::ifstream in(file);
+	std::string line;
+	if (!std::getline(in, line) || line != LOG_HEADER) {
+		SPDLOG_ERROR("'{:s}' isn't a log of actions", file.string());
+		return std::nullopt;
+	}
+	
+	std::vector<Action> actions;
+	for (size_t number = 2; std::getline(in, line); ++number) {
+		if (line.empty() || line.front() == '#') { continue; }
+		
+		std::optional<Action> action = parse(line);
+		if (!action.has_value()) {
+			SPDLOG_WARN("Ignoring invalid action '{:s}' at {:s}:{:d}",
+				line, file.string(), number
+			);
+			continue;
+		}
+		actions.push_back(std::move(action.value()));
+	}
+	SPDLOG_INFO("Read {:d} actions from '{:s}'", actions.size(), file.string());
+	return actions;
+}
+
+double speed_from_env(void)
+{
+	const std::string value = Glib::getenv(SPEED_ENV);
+	if (value.empty()) { return 1.0; }
+	
+	double speed = 1.0;
+	if (!parse_number(std::string_view(value), speed) || !(speed >= 0.0)) {
+		SPDLOG_WARN("Ignoring invalid {:s}='{:s}'", SPEED_ENV, value);
+		return 1.0;
+	}
+	return speed;
+}
+
+
+
+// Recorder
+// ==================================================
+
+Recorder::Recorder(const fs::path &file) :
+	m_out { file, std::ios::trunc }, m_last { Clock::now() }
+{
+	m_out << LOG_HEADER << '\n';
+	if (!m_out.flush()) {
+		SPDLOG_ERROR("Failed to open '{:s}', the actions aren't recorded", file.string());
+		return;
+	}
+	SPDLOG_INFO("Recording the actions to '{:s}'", file.string());
+}
+
+bool Recorder::is_open(void) const
+{
+	return m_out.good();
+}
+
+void Recorder::record(const Kind kind, const size_t page, const size_t value,
+	const std::string_view playlist
+) {
+	if (!this->is_open()) { return; }
+	if (playlist.find('\n') != std::string_view::npos) {
+		SPDLOG_WARN("Not recording a playlist with a newline in its name");
+		return;
+	}
+	
+	const Clock::time_point now = Clock::now();
+	const Action action { chrono::duration_cast<chrono::milliseconds>(now - m_last), kind,
+		page, value, std::string(playlist)
+	};
+	m_last = now;
+	// flushed right away, the log must be complete if the application crashes
+	m_out << format(action) << std::endl;
+}
+
+
+
+// Replayer - public
+// ==================================================
+
+Replayer::Replayer(std::vector<Action> actions, const double speed, Gtk::Widget &widget) :
+	m_actions { std::move(actions) }, m_speed { speed }, d_widget { widget },
+	m_ready { }, m_perform { },
+	m_next { 0 }, m_skipped { 0 },
+	m_lastRun { }, m_waitBegin { }, m_begin { }, m_end { },
+	m_responses { },
+	m_timer { }, m_afterPaint { }, m_tickId { 0 }, m_signal_finished { }
+{
+}
+
+Replayer::~Replayer(void)
+{
+	m_timer.disconnect();
+	m_afterPaint.disconnect();
+	if (m_tickId != 0) { d_widget.remove_tick_callback(m_tickId); }
+}
+
+void Replayer::start(ReadySlot ready, PerformSlot perform)
+{
+	m_ready = std::move(ready);
+	m_perform = std::move(perform);
+	
+	SPDLOG_INFO("Replaying {:d} actions at {:g}x", m_actions.size(), m_speed);
+	m_begin = m_lastRun = Clock::now();
+	this->schedule_next();
+}
+
+bool Replayer::is_finished(void) const
+{
+	return m_next >= m_actions.size() && m_tickId == 0 && !m_afterPaint.connected();
+}
+
+size_t Replayer::skipped(void) const
+{
+	return m_skipped;
+}
+
+const LatencyHistogram& Replayer::responses(const Kind kind) const
+{
+	return m_responses.at(static_cast<size_t>(kind));
+}
+
+void Replayer::log_report(void) const
+{
+	Clock::duration recorded { 0 };
+	for (const Action &action : m_actions) { recorded += action.delay; }
+	SPDLOG_INFO("Replayed {:d} actions in {:.1f} s ({:.1f} s recorded), {:d} skipped",
+		m_actions.size() - m_skipped, to_ms(m_end - m_begin) / 1000.0,
+		to_ms(recorded) / 1000.0, m_skipped
+	);
+	
+	SPDLOG_INFO("Response times (ms):");
+	for (size_t i = 0; i < m_responses.size(); ++i) {
+		const LatencyHistogram &h = m_responses[i];
+		if (h.count() == 0) { continue; }
+		SPDLOG_INFO("  {:<12s} n={:<6d} p50={:<8.3f} p90={:<8.3f} p99={:<8.3f} max={:.3f}",
+			KIND_NAMES[i], h.count(), to_ms(h.percentile(50)), to_ms(h.percentile(90)),
+			to_ms(h.percentile(99)), to_ms(h.max())
+		);
+	}
+}
+
+bool Replayer::write_report(const fs::path &file) const
+{
+	// the format of the benchmarks' results, so `benchmarks/compare.py` compares replays too
+	std::string json = fmt::format("{{\n\t\"benchmark\": \"replay\",\n\t\"unit\": \"ms\",\n"
+		"\t\"duration\": {:.3f},\n\t\"skipped\": {:d},\n\t\"results\": [\n",
+		to_ms(m_end - m_begin), m_skipped
+	);
+	const char *separator = "";
+	for (size_t i = 0; i < m_responses.size(); ++i) {
+		const LatencyHistogram &h = m_responses[i];
+		if (h.count() == 0) { continue; }
+		json += fmt::format("{:s}\t\t{{ \"name\": \"{:s}\", \"rows\": 0, "
+			"\"median\": {:.6f}, \"p99\": {:.6f}, \"max\": {:.6f}, \"count\": {:d} }}",
+			separator, KIND_NAMES[i], to_ms(h.percentile(50)), to_ms(h.percentile(99)),
+			to_ms(h.max()), h.count()
+		);
+		separator = ",\n";
+	}
+	json += "\n\t]\n}\n";
+	
+	std::ofstream out(file, std::ios::trunc);
+	out << json;
+	if (!out.flush()) {
+		SPDLOG_ERROR("Failed to write '{:s}'", file.string());
+		return false;
+	}
+	return true;
+}
+
+sigc::signal<void()> Replayer::signal_finished(void)
+{
+	return m_signal_finished;
+}
+
+
+
+// Replayer - private
+// ==================================================
+
+void Replayer::schedule_next(void)
+{
+	if (m_next >= m_actions.size()) {
+		m_end = Clock::now();
+		m_signal_finished.emit();
+		return;
+	}
+	
+	// the delay is counted from when the previous action ran, drawing it included
+	const chrono::duration<double, std::milli> delay =
+		m_speed > 0.0 ? m_actions[m_next].delay / m_speed : chrono::milliseconds(0);
+	const Clock::duration wait = std::max(Clock::duration(0),
+		m_lastRun + chrono::duration_cast<Clock::duration>(delay) - Clock::now()
+	);
+	m_waitBegin = Clock::time_point();
+	m_timer = Glib::signal_timeout().connect(sigc::mem_fun(*this, &Replayer::cb__due),
+		static_cast<unsigned int>(chrono::ceil<chrono::milliseconds>(wait).count())
+	);
+}
+
+bool Replayer::cb__due(void)
+{
+	TRACE_SPAN("Replayer::cb__due");
+	const Action &action = m_actions[m_next];
+	if (!m_ready(action)) {
+		const Clock::time_point now = Clock::now();
+		if (m_waitBegin == Clock::time_point()) { m_waitBegin = now; }
+		if (now - m_waitBegin < READY_TIMEOUT) {
+			// polled until it's ready, the timer is made again to poll more often
+			m_timer = Glib::signal_timeout().connect(
+				sigc::mem_fun(*this, &Replayer::cb__due),
+				static_cast<unsigned int>(READY_POLL.count())
+			);
+			return false;
+		}
+		
+		SPDLOG_WARN("Skipping action {:d} '{:s}', it wasn't ready after {:d} s",
+			m_next + 1, format(action), READY_TIMEOUT.count()
+		);
+		++m_skipped;
+		++m_next;
+		this->schedule_next();
+		return false;
+	}
+	
+	SPDLOG_DEBUG("Replaying action {:d}: '{:s}'", m_next + 1, format(action));
+	m_lastRun = Clock::now();
+	m_perform(action);
+	m_tickId = d_widget.add_tick_callback(sigc::mem_fun(*this, &Replayer::cb__tick));
+	return false;
+}
+
+bool Replayer::cb__tick(const Glib::RefPtr<Gdk::FrameClock> &clock)
+{
+	// the frame of the tick is painted next, the action shows up once it's done
+	m_tickId = 0;
+	m_afterPaint = clock->signal_after_paint().connect(
+		sigc::mem_fun(*this, &Replayer::cb__after_paint)
+	);
+	return false;
+}
+
+void Replayer::cb__after_paint(void)
+{
+	m_afterPaint.disconnect();
+	const Action &action = m_actions[m_next];
+	m_responses[static_cast<size_t>(action.kind)].record(
+		chrono::duration_cast<LatencyHistogram::Duration>(Clock::now() - m_lastRun)
+	);
+	++m_next;
+	this->schedule_next();
+}
+
+}
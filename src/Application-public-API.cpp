@@ -1,32 +1,39 @@
+#include <cassert>
 #include <momuma/spdlog.h>
 
 #include "Application.h"
+#include "LoopMonitor.h"
 
 
-bool Application::add_playlist_to_view(const Glib::ustring &playlistName)
+void Application::add_playlist_to_view(const Glib::ustring &playlistName)
+{
+	MONITOR_CALLBACK("Application::add_playlist_to_view");
+	(void)m_opener.open(playlistName);
+}
+
+PageId Application::add_playlist_placeholder(const Glib::ustring &playlistName)
 {
 	Gui::PlaylistNotebook &notebook = m_window._notebook;
-	const PageId id = notebook.page_create(playlistName);
-	m_pages[id] = PageData { playlistName, false };
-	
-	const int items = m_backend.get_database().get_media_paths(playlistName,
-		[&notebook, id](fs::path p) -> Momuma::Database::IterFlag
-		{
-			auto duration = chrono::duration_cast<chrono::seconds>(
-				Momuma::MpvPlayer::query_duration(p)
-			);
-			notebook.get_page(id).append_row({ p.filename().string(), duration });
-			return Momuma::Database::IterFlag::NEXT;
-		}
-	);
+	Pango::AttrList attrs;
+	const PageId id = notebook.page_create_placeholder(playlistName, attrs);
+	m_pages[id] = PageData { playlistName, false, nullptr, { }, 0, std::nullopt,
+		std::nullopt
+	};
 	
-	if (items < 0) {
-		SPDLOG_ERROR("Failed to get all media paths");
+	// the first page of a notebook is shown as soon as it's added
+	if (notebook.current_page_id() == id) {
+		this->cb__page_focused(id);
 	}
-	return !(items < 0);
+	return id;
+}
+
+Backend &Application::get_backend(void)
+{
+	assert(m_backend);
+	return *m_backend;
 }
 
-Momuma::Momuma &Application::get_backend(void)
+bool Application::is_backend_ready(void) const
 {
-	return m_backend;
+	return m_backend != nullptr;
 }
@@ -1,15 +1,30 @@
+#include <algorithm>
+#include <csignal>
+#include <glib-unix.h>
 #include <glibmm/miscutils.h>
 #include <glibmm/main.h>
 #include <momuma/bitset.h>
 #include <momuma/spdlog.h>
 
+#include "ActionLog.h"
 #include "Application.h"
+#include "LoopMonitor.h"
+#include "MediaDuration.h"
+#include "MomumaBackend.h"
+#include "Startup.h"
+#include "Trace.h"
 #include "misc.h"
 
 #include "build-config.h"
 
 
 constexpr char APP_ACTION_PREFIX[] = "app.";
+// how often the pages are checked against the memory budget
+constexpr chrono::seconds EVICTION_INTERVAL { 30 };
+// how often the session is saved, besides when quitting
+constexpr chrono::minutes SESSION_SAVE_INTERVAL { 5 };
+// rows added to the session's snapshot between two yields
+constexpr size_t SESSION_CHUNK_ROWS = 1024;
 
 
 static void change_slider_times(Gui::Slider &slider,
@@ -42,88 +57,99 @@ static void update_controls_state(Gui::PlayerControls &ctrls, const PlayerState
 	ctrls._stop.set_sensitive(b);
 }
 
-static void update_slider_using_player(Gui::Slider &slider, Momuma::MpvPlayer &player)
+[[nodiscard]] static
+std::optional<Gui::Slider::PlaybackTime> read_playback_time(Backend::Player &player)
 {
-	//SPDLOG_CRITICAL("blockPlayerUpdate: {}", m_blockPlayerUpdate);
-	const PlayerState state = player.get_state();
-	if (state != PlayerState::PLAY) { return; }
+	if (player.get_state() == PlayerState::STOP) { return std::nullopt; }
 	
 	mpv_error errPos, errDur;
 	const chrono::microseconds position = player.get_position(errPos);
 	const chrono::microseconds duration = player.get_duration(errDur);
 	
 	if (errPos == MPV_ERROR_PROPERTY_UNAVAILABLE && errDur == MPV_ERROR_PROPERTY_UNAVAILABLE) {
-		return;
+		return std::nullopt;
 	}
 	else if (errPos != MPV_ERROR_SUCCESS || errDur != MPV_ERROR_SUCCESS) {
 		SPDLOG_ERROR("Position error: {} | Duration error: {}", errPos, errDur);
-		return;
+		return std::nullopt;
 	}
 	
-	change_slider_times(slider,
+	return Gui::Slider::PlaybackTime {
 		chrono::duration_cast<chrono::milliseconds>(position),
 		chrono::duration_cast<chrono::milliseconds>(duration)
-	);
-}
-
-static void connect_timeout_signals(Momuma::MpvPlayer &player,
-	Gui::Slider &playerSlider, const volatile bool &letSliderUpdate
-) {
-	Glib::signal_timeout().connect(
-		[&letSliderUpdate, &playerSlider, &player](void) -> bool
-		{
-			if (letSliderUpdate) { update_slider_using_player(playerSlider, player); }
-			return true;
-		}, chrono::milliseconds(150).count()
-	);
-	
-	Glib::signal_timeout().connect(
-		[&player](void) -> bool
-		{
-			player.wait_event(chrono::seconds(0));
-			return true;
-		}, chrono::milliseconds(20).count(), Glib::PRIORITY_DEFAULT_IDLE
-	);
+	};
 }
 
 [[nodiscard]] static inline
 std::optional<Glib::ustring> get_playlist_choice_from_user(
-	Gtk::Window &parent, Momuma::Database::Sqlite3 &database
+	Gtk::Window &parent, DatabaseService &database
 ) {
 	Gui::ListChooserDialog dialog(_("Choose playlist"), parent);
-	const auto cb = [&dialog](Glib::ustring playlist) -> Momuma::Database::IterFlag
-	{
-		dialog.append_value(std::move(playlist));
-		return Momuma::Database::IterFlag::NEXT;
-	};
+	bool failed = false;
+	// the dialog is shown right away and filled as the playlists are read
+	DatabaseService::Request query = database.get_playlists(
+		[&dialog](std::vector<Glib::ustring> &&playlists) -> void
+		{
+			for (const Glib::ustring &playlist : playlists) {
+				dialog.append_value(playlist);
+			}
+		},
+		[&dialog, &failed](const bool success) -> void
+		{
+			if (success) { return; }
+			failed = true;
+			dialog.get_top_widget().response(Gtk::RESPONSE_REJECT);
+		}
+	);
 	
-	if (database.get_playlists(cb) < 0) {
+	const Gtk::ResponseType response = dialog.run();
+	// the callbacks refer to the dialog
+	query.cancel();
+	
+	if (failed) {
 		Gui::display_msg_box(parent, _("Failed to retrieve playlists"));
 		return std::optional<Glib::ustring>();
 	}
-	return dialog.run() == Gtk::RESPONSE_ACCEPT ?
+	return response == Gtk::RESPONSE_ACCEPT ?
 		dialog.get_selected_value() : std::optional<Glib::ustring>();
 }
 
+// Position of a page in the notebook, the action logs refer to pages by it
+[[nodiscard]] static size_t page_position(const Gui::PlaylistNotebook &notebook, const PageId id)
+{
+	const std::vector<PageId> ids = notebook.page_ids();
+	return static_cast<size_t>(std::find(ids.begin(), ids.end(), id) - ids.begin());
+}
+
 // Called when the PLAY button is clicked
-static void cb__play(Momuma::MpvPlayer &player)
+static void cb__play(Backend::Player &player, PlayerEventPump &pump)
 {
 	SPDLOG_TRACE("Triggered {:s}()", SPDLOG_FUNCTION);
 	player.set_play(true);
+	pump.kick();
 }
 
 // Called when the PAUSE button is clicked
-static void cb__pause(Momuma::MpvPlayer &player)
+static void cb__pause(Backend::Player &player, PlayerEventPump &pump)
 {
 	SPDLOG_TRACE("Triggered {:s}()", SPDLOG_FUNCTION);
 	player.set_play(false);
+	pump.kick();
 }
 
 // Called when the STOP button is clicked
-static void cb__stop(Momuma::MpvPlayer &player)
+static void cb__stop(Backend::Player &player, PlayerEventPump &pump)
 {
 	SPDLOG_TRACE("Triggered {:s}()", SPDLOG_FUNCTION);
 	player.stop_playback();
+	pump.kick();
+}
+
+// Called when the volume is changed
+static void cb__volume(const double volume, Backend::Player &player, PlayerEventPump &pump)
+{
+	player.set_volume(volume);
+	pump.kick();
 }
 
 
@@ -133,39 +159,55 @@ static void cb__stop(Momuma::MpvPlayer &player)
 Application::Application(void) :
 	Gtk::Application { APPLICATION_ID },
 	_title { APPLICATION_TITLE },
-	m_backend { Utils::get_appdata_folder() / MOMUMA_GTK__NAME },
+	m_fakeBackend { FakeBackend::config_from_env() },
+	m_backend { nullptr }, m_database { },
 	m_menubar { Gio::Menu::create() }, m_window { },
-	m_pages { }, m_letSliderUpdate { false }
+	m_pages { },
+	m_metadataCache { Utils::get_appdata_folder() / MOMUMA_GTK__NAME / "metadata-cache.bin" },
+	m_prober { m_fakeBackend.has_value() ? FakeBackend::make_probe(m_fakeBackend.value())
+		: Backend::ProbeFunc(Media::query_duration)
+	},
+	m_scheduler { m_window },
+	m_loader { m_window._notebook, m_prober, m_scheduler },
+	m_opener { m_window._notebook, m_pages, m_database, m_metadataCache, m_prober, m_loader },
+	m_pageLru { PageLru::budget_from_env() },
+	m_session { Utils::get_appdata_folder() / MOMUMA_GTK__NAME / "session.bin" },
+	m_sessionSave { }, m_sessionWriter { },
+	m_eventPump { }, m_playback { }, m_rowPlayer { }, m_activationTime { }, m_firstFrame { },
+	m_watchdog { LoopMonitor::threshold_from_env() }, m_latencySignal { 0 },
+	m_recorder { }, m_recordedPages { }, m_keyAction { false }, m_replayer { },
+	m_backendReady { 1 }, m_backendThread { }
 {
-	if (!m_backend) {
-		throw std::runtime_error("Failed to initialize Momuma backend");
-	}
-	
 	Glib::set_application_name(_title);
 	
-	auto &player = m_backend.get_player();
-	player.signal_streamStarted.connect(
-		sigc::mem_fun(*this, &Application::cb__audioStreamStarted)
-	);
-	player.signal_streamEnded.connect(
-		sigc::mem_fun(*this, &Application::cb__audioStreamEnded)
-	);
-	player.signal_stateChanged.connect(
-		sigc::mem_fun(*this, &Application::cb__audioStateChanged)
-	);
-	
+	// the window is shown while the player and database are created, the controls need them
 	Gui::PlayerControls &ctrls = m_window._controls;
 	update_controls_state(ctrls, PlayerState::STOP);
-	ctrls.signal_clicked_play().connect(sigc::bind(&cb__play, sigc::ref(player)));
-	ctrls.signal_clicked_pause().connect(sigc::bind(&cb__pause, sigc::ref(player)));
-	ctrls.signal_clicked_stop().connect(sigc::bind(&cb__stop, sigc::ref(player)));
-	ctrls.signal_volume_value_changed().connect(
-		sigc::mem_fun(player, &Momuma::MpvPlayer::set_volume)
+	ctrls._volume.set_value(Gui::VolumeButton::VOL_MAX);
+	ctrls.w_.set_sensitive(false);
+	m_backendReady.connect(sigc::mem_fun(*this, &Application::cb__backend_ready));
+	m_backendThread = std::jthread(
+		[this, folder = Utils::get_appdata_folder() / MOMUMA_GTK__NAME](void) -> void
+		{
+			TRACE_THREAD_NAME("backend");
+			TRACE_SPAN("Backend");
+			const auto begin = chrono::steady_clock::now();
+			std::unique_ptr<Backend> backend;
+			if (m_fakeBackend.has_value()) {
+				backend = std::make_unique<FakeBackend>(m_fakeBackend.value());
+			}
+			else {
+				backend = std::make_unique<MomumaBackend>(folder);
+			}
+			const chrono::duration<double, std::milli> elapsed =
+				chrono::steady_clock::now() - begin;
+			SPDLOG_INFO("Created the backend in {:.1f} ms", elapsed.count());
+			m_backendReady.push(std::move(backend));
+		}
 	);
-	ctrls._slider.signal_drag().connect(
-		sigc::mem_fun(*this, &Application::cb__slider_update)
+	m_firstFrame = m_window.signal_draw().connect(
+		sigc::mem_fun(*this, &Application::cb__first_frame), false
 	);
-	ctrls._volume.set_value(Gui::VolumeButton::VOL_MAX);
 	
 	m_window.signal_key_press_event().connect(
 		sigc::mem_fun(*this, &Application::cb__window_keypress), sigc::BEFORE
@@ -178,7 +220,52 @@ Application::Application(void) :
 	m_pages.connect_row_activated(m_window._notebook);
 	m_pages.connect_page_destroyed(m_window._notebook);
 	
-	connect_timeout_signals(player, ctrls._slider, m_letSliderUpdate);
+	m_window._notebook.signal_page_remove().connect(
+		sigc::mem_fun(m_prober, &MediaProber::cancel)
+	);
+	m_loader.signal_loaded().connect(
+		sigc::mem_fun(*this, &Application::cb__playlist_loaded)
+	);
+	// stops the tasks working on the page, e.g. loading it
+	m_window._notebook.signal_page_remove().connect(
+		sigc::mem_fun(m_scheduler, &TaskScheduler::cancel_page)
+	);
+	m_window._notebook.signal_page_remove().connect(
+		[this](const PageId id) -> void
+		{
+			m_pageLru.forget(id);
+			std::erase(m_recordedPages, id);
+			m_sessionSave.cancel();
+		}
+	);
+	m_window._notebook.signal_page_focused().connect(
+		sigc::mem_fun(*this, &Application::cb__page_focused)
+	);
+	m_window._notebook.signal_page_focused().connect(
+		sigc::mem_fun(*this, &Application::cb__record_focus)
+	);
+	m_window._notebook.signal_page_reordered().connect(
+		sigc::mem_fun(*this, &Application::cb__record_move)
+	);
+	m_window._notebook.signal_page_created().connect(
+		[this](PageId) -> void
+		{
+			if (m_recorder) { m_recordedPages = m_window._notebook.page_ids(); }
+		}
+	);
+	Glib::signal_timeout().connect_seconds(
+		sigc::bind_return(sigc::mem_fun(*this, &Application::evict_pages), true),
+		static_cast<unsigned int>(EVICTION_INTERVAL.count())
+	);
+	SPDLOG_DEBUG("Pages are evicted past {:d} MiB", m_pageLru.budget() >> 20);
+	Glib::signal_timeout().connect_seconds(
+		sigc::bind_return(sigc::mem_fun(*this, &Application::cb__save_session), true),
+		static_cast<unsigned int>(chrono::seconds(SESSION_SAVE_INTERVAL).count())
+	);
+	
+	m_window.signal_window_state_event().connect_notify(
+		sigc::mem_fun(*this, &Application::cb__window_state_changed)
+	);
 	m_window.show_all_children(true);
 }
 
@@ -200,13 +287,34 @@ void Application::on_startup(void)
 	
 	m_menubar->append_submenu(_("File"), this->create_menu_File());
 	this->set_menubar(m_menubar);
+	
+	// the main loop runs from here on
+	m_watchdog.start();
+	m_latencySignal = g_unix_signal_add(SIGUSR1,
+		[](gpointer) -> gboolean
+		{
+			LoopMonitor::log_histograms();
+			return G_SOURCE_CONTINUE;
+		},
+		nullptr
+	);
 }
 
 void Application::on_activate(void)
 {
 	try {
 		this->add_window(m_window);
+		// a replay starts from an empty notebook, so it runs the same every time
+		const bool replay = !Glib::getenv(ActionLog::REPLAY_ENV).empty();
+		if (!replay) { this->restore_session(); }
 		m_window.present();
+		
+		if (!replay) {
+			this->start_recording();
+		}
+		else if (!this->start_replay()) {
+			this->on_action_quit();
+		}
 	}
 	catch (const Glib::Error &ex) {
 		SPDLOG_CRITICAL(ex.what());
@@ -216,6 +324,33 @@ void Application::on_activate(void)
 	}
 }
 
+void Application::on_shutdown(void)
+{
+	m_metadataCache.save();
+	
+	// every way of quitting ends here, the session is saved in one go
+	m_sessionSave.cancel();
+	if (m_sessionWriter.joinable()) { m_sessionWriter.join(); }
+	// a replay mustn't replace the session of the user
+	if (!m_replayer.has_value()) {
+		SessionSnapshot::Builder session;
+		for (const PageId id : m_window._notebook.page_ids()) {
+			this->snapshot_rows(session, id, 0, this->snapshot_page(session, id));
+		}
+		session.set_volume(m_window._controls._volume.get_value());
+		(void)session.write(m_session.file());
+	}
+	
+	m_watchdog.stop();
+	if (m_latencySignal != 0) {
+		g_source_remove(m_latencySignal);
+		m_latencySignal = 0;
+	}
+	LoopMonitor::log_histograms();
+	
+	Gtk::Application::on_shutdown(); // mandatory - do NOT remove
+}
+
 void Application::create_keyboard_only_shortcuts(void)
 {
 	/*this->add_action("new-tab", "<Primary>N", [this](void) -> void {
@@ -282,6 +417,420 @@ void Application::prefix_title(Glib::ustring prefix)
 	Glib::set_application_name(prefix + " - " + _title);
 }
 
+void Application::load_page(const PageId id)
+{
+	if (m_pages.at(id).sessionPage.has_value()) {
+		this->restore_page(id);
+		return;
+	}
+	m_opener.read(id);
+}
+
+void Application::restore_session(void)
+{
+	Gui::PlaylistNotebook &notebook = m_window._notebook;
+	// the application may be activated again, e.g when launched twice
+	if (m_session.empty() || notebook.size() > 0) { return; }
+	
+	const auto begin = chrono::steady_clock::now();
+	std::vector<PageId> ids;
+	ids.reserve(m_session.page_count());
+	for (size_t i = 0; i < m_session.page_count(); ++i) {
+		const SessionSnapshot::Page page = m_session.page(i);
+		const Glib::ustring name { std::string(page.name) };
+		Pango::AttrList attrs;
+		const PageId id = notebook.page_create_placeholder(name, attrs);
+		// placeholders are added after the focused page, this keeps them in order
+		notebook.page_focus(id);
+		
+		// only the shown page is restored now, the others once they're first shown
+		PageData data { name, false, nullptr, { }, 0, std::nullopt, i };
+		if (page.rows == 0) {
+			// saved while it wasn't loaded, it's read from the database instead
+			data.sessionPage.reset();
+			data.view = Gui::PageViewState { page.topRow, { } };
+		}
+		m_pages[id] = std::move(data);
+		ids.push_back(id);
+	}
+	
+	const std::optional<double> volume = m_session.volume();
+	if (volume.has_value()) {
+		m_window._controls._volume.set_value(volume.value());
+	}
+	// the playing row is only marked, the playback starts again once it's activated
+	const std::optional<std::pair<size_t, size_t>> playing = m_session.playing();
+	if (playing.has_value()) {
+		m_pages.set_playing(ids[playing->first]);
+	}
+	
+	if (!ids.empty()) {
+		const PageId current = ids[m_session.current_page().value_or(0)];
+		notebook.page_focus(current);
+		// the signal isn't emitted when the page was already focused
+		this->cb__page_focused(current);
+	}
+	
+	const chrono::duration<double, std::milli> elapsed = chrono::steady_clock::now() - begin;
+	SPDLOG_INFO("Restored the session ({:d} pages) in {:.1f} ms", ids.size(), elapsed.count());
+}
+
+void Application::restore_page(const PageId id)
+{
+	MONITOR_CALLBACK("Application::restore_page");
+	PageData &data = m_pages.at(id);
+	const size_t sessionPage = data.sessionPage.value();
+	data.sessionPage.reset();
+	
+	const SessionSnapshot::Page page = m_session.page(sessionPage);
+	std::vector<Gui::NotebookRowData> rows;
+	std::vector<fs::path> paths;
+	rows.reserve(page.rows);
+	paths.reserve(page.rows);
+	for (size_t i = 0; i < page.rows; ++i) {
+		const SessionSnapshot::Row row = m_session.row(sessionPage, i);
+		paths.emplace_back(row.path);
+		rows.push_back({ Glib::ustring(std::string(row.name)), row.duration });
+	}
+	data.pathsMemory = paths_memory(paths);
+	data.paths = std::make_shared<const std::vector<fs::path>>(std::move(paths));
+	
+	Gui::PlaylistNotebook &notebook = m_window._notebook;
+	notebook.get_page(id).append_rows(rows);
+	notebook.page_restore_view_state(id, Gui::PageViewState { page.topRow, { } });
+	const std::optional<std::pair<size_t, size_t>> playing = m_session.playing();
+	if (playing.has_value() && playing->first == sessionPage) {
+		notebook.get_page(id).set_playing_row(playing->second);
+	}
+	
+	// nothing reads the snapshot anymore once every page is restored
+	const bool restoring = std::any_of(m_pages.begin(), m_pages.end(),
+		[](const auto &entry) -> bool { return entry.second.sessionPage.has_value(); }
+	);
+	if (!restoring) { m_session.close(); }
+	
+	// the playlist may have changed since the snapshot, e.g by another instance
+	auto current = std::make_shared<std::vector<fs::path>>();
+	data.query = m_database.get_media_paths(data.name,
+		[current](std::vector<fs::path> &&chunk) -> void
+		{
+			current->insert(current->end(), std::make_move_iterator(chunk.begin()),
+				std::make_move_iterator(chunk.end())
+			);
+		},
+		[this, id, current](const bool success) -> void
+		{
+			PageData &restored = m_pages.at(id);
+			if (!success) {
+				SPDLOG_WARN("Failed to check '{:s}', it's kept as it was restored",
+					restored.name
+				);
+				return;
+			}
+			
+			const std::vector<fs::path> &saved = *restored.paths;
+			const Gui::NotebookPageProxy proxy = m_window._notebook.get_page(id);
+			if (*current == saved) {
+				// rows that weren't probed before quitting
+				std::vector<MediaProber::Request> requests;
+				proxy.read_rows(0, saved.size(),
+					[&requests, &saved](const size_t row, const char*,
+						const chrono::seconds duration
+					) -> void
+					{
+						if (duration >= chrono::seconds(0)) { return; }
+						requests.push_back({ row, saved[row] });
+					}
+				);
+				m_prober.probe(id, std::move(requests));
+				return;
+			}
+			
+			SPDLOG_INFO("'{:s}' changed since the last session, loading it again",
+				restored.name
+			);
+			m_sessionSave.cancel();
+			if (m_playback && id == m_playback->page()) {
+				m_backend->get_player().stop_playback();
+				m_eventPump->kick();
+				m_playback->reset();
+			}
+			proxy.clear();
+			m_opener.load_rows(id, std::move(*current));
+		}
+	);
+}
+
+size_t Application::snapshot_page(SessionSnapshot::Builder &builder, const PageId id)
+{
+	const auto iter = m_pages.find(id);
+	// pages that aren't playlists only exist in their view
+	if (iter == m_pages.end() || iter->second.unsaved) { return 0; }
+	
+	const PageData &data = iter->second;
+	Gui::PlaylistNotebook &notebook = m_window._notebook;
+	const Gui::NotebookPageProxy page = notebook.get_page(id);
+	size_t rows = 0;
+	if (data.sessionPage.has_value()) {
+		// never shown since it was restored, it's still as it was in the snapshot
+		builder.copy_page(m_session, data.sessionPage.value());
+		const std::optional<std::pair<size_t, size_t>> playing = m_session.playing();
+		if (playing.has_value() && playing->first == data.sessionPage.value()) {
+			builder.mark_playing(playing->second);
+		}
+	}
+	else if (data.paths && !m_loader.is_loading(id) && page.size() == data.paths->size()) {
+		builder.add_page(data.name.raw(), notebook.page_get_view_state(id).topRow);
+		rows = data.paths->size();
+		const std::optional<size_t> playing = page.get_playing_row();
+		if (playing.has_value()) { builder.mark_playing(playing.value()); }
+	}
+	else {
+		// evicted or being loaded, it's read from the database once restored
+		builder.add_page(data.name.raw(),
+			data.view.has_value() ? data.view->topRow : std::nullopt
+		);
+	}
+	
+	if (id == notebook.current_page_id()) { builder.mark_current(); }
+	return rows;
+}
+
+void Application::snapshot_rows(SessionSnapshot::Builder &builder, const PageId id,
+	const size_t first, const size_t count
+) {
+	if (count == 0) { return; }
+	
+	const std::vector<fs::path> &paths = *m_pages.at(id).paths;
+	m_window._notebook.get_page(id).read_rows(first, count,
+		[&builder, &paths](const size_t row, const char *name,
+			const chrono::seconds duration
+		) -> void
+		{
+			builder.add_row(paths[row].native(), name, duration);
+		}
+	);
+}
+
+TaskScheduler::Task Application::save_session_task(void)
+{
+	SessionSnapshot::Builder builder;
+	for (const PageId id : m_window._notebook.page_ids()) {
+		co_await TaskScheduler::Yield{};
+		const size_t rows = this->snapshot_page(builder, id);
+		for (size_t first = 0; first < rows; first += SESSION_CHUNK_ROWS) {
+			co_await TaskScheduler::Yield{};
+			this->snapshot_rows(builder, id, first, SESSION_CHUNK_ROWS);
+		}
+	}
+	builder.set_volume(m_window._controls._volume.get_value());
+	
+	// written on another thread, once the previous snapshot was
+	if (m_sessionWriter.joinable()) { m_sessionWriter.join(); }
+	m_sessionWriter = std::jthread(
+		[builder = std::move(builder), file = m_session.file()](void) -> void
+		{
+			(void)builder.write(file);
+		}
+	);
+}
+
+bool Application::is_evictable(const PageId id)
+{
+	const auto iter = m_pages.find(id);
+	// pages that aren't playlists only exist in their view
+	if (iter == m_pages.end() || iter->second.unsaved) { return false; }
+	
+	const Gui::PlaylistNotebook &notebook = m_window._notebook;
+	return notebook.page_has_view(id) && id != notebook.current_page_id()
+		&& !iter->second.query.is_pending() && !m_loader.is_loading(id)
+		&& id != m_pages.get_playing() && (!m_playback || id != m_playback->page());
+}
+
+void Application::evict_pages(void)
+{
+	Gui::PlaylistNotebook &notebook = m_window._notebook;
+	const std::vector<PageId> victims = m_pageLru.select_victims(
+		[this, &notebook](const PageId id) -> size_t
+		{
+			const auto iter = m_pages.find(id);
+			const size_t paths = (iter == m_pages.end()) ? 0 : iter->second.pathsMemory;
+			return notebook.get_page(id).memory_usage() + paths;
+		},
+		sigc::mem_fun(*this, &Application::is_evictable)
+	);
+	
+	for (const PageId id : victims) {
+		PageData &data = m_pages.at(id);
+		SPDLOG_INFO("Evicting '{:s}', it wasn't shown for a while", data.name);
+		
+		m_prober.cancel(id);
+		// the rows of a page being saved must stay until it's saved
+		m_sessionSave.cancel();
+		data.view = notebook.page_drop_view(id);
+		data.paths.reset();
+		data.pathsMemory = 0;
+	}
+}
+
+void Application::new_untitled_page(void)
+{
+	Pango::AttrList attrList = Utils::create_attr_list({
+		Pango::Attribute::create_attr_style(Pango::STYLE_ITALIC)
+	});
+	m_window._notebook.page_create(_("untitled"), attrList);
+}
+
+void Application::close_current_page(void)
+{
+	Gui::PlaylistNotebook &notebook = m_window._notebook;
+	if (notebook.size() == 0) { return; }
+	
+	const PageId current = notebook.current_page_id();
+	if (m_backend && current == m_pages.get_playing()) {
+		m_backend->get_player().stop_playback();
+		m_eventPump->kick();
+	}
+	if (m_playback && current == m_playback->page()) {
+		m_playback->reset();
+	}
+	notebook.page_remove(current);
+}
+
+void Application::start_recording(void)
+{
+	const std::string file = Glib::getenv(ActionLog::RECORD_ENV);
+	if (file.empty() || m_recorder.has_value()) { return; }
+	
+	m_recorder.emplace(file);
+	// the log starts from the pages open, they're loaded once shown like those of the session
+	Gui::PlaylistNotebook &notebook = m_window._notebook;
+	for (const PageId id : notebook.page_ids()) {
+		const auto it = m_pages.find(id);
+		if (it != m_pages.end()) {
+			const std::string &name = it->second.name.raw();
+			m_recorder->record(ActionLog::Kind::PLACEHOLDER, 0, 0, name);
+		}
+		else {
+			m_recorder->record(ActionLog::Kind::NEW_PAGE);
+		}
+	}
+	if (notebook.size() > 0) {
+		m_recorder->record(ActionLog::Kind::FOCUS,
+			page_position(notebook, notebook.current_page_id())
+		);
+	}
+	m_recordedPages = notebook.page_ids();
+}
+
+bool Application::start_replay(void)
+{
+	if (m_replayer.has_value()) { return true; }
+	
+	const fs::path file = Glib::getenv(ActionLog::REPLAY_ENV);
+	std::optional<std::vector<ActionLog::Action>> actions = ActionLog::read(file);
+	if (!actions.has_value()) {
+		SPDLOG_CRITICAL("Failed to read the actions to replay from '{:s}'", file.string());
+		return false;
+	}
+	
+	m_replayer.emplace(std::move(actions.value()), ActionLog::speed_from_env(), m_window);
+	m_replayer->signal_finished().connect(
+		sigc::mem_fun(*this, &Application::cb__replay_finished)
+	);
+	m_replayer->start(sigc::mem_fun(*this, &Application::is_replay_ready),
+		sigc::mem_fun(*this, &Application::replay_action)
+	);
+	return true;
+}
+
+bool Application::is_replay_ready(const ActionLog::Action &action)
+{
+	Gui::PlaylistNotebook &notebook = m_window._notebook;
+	const auto pages = static_cast<size_t>(notebook.size());
+	switch (action.kind)
+	{
+	case ActionLog::Kind::FOCUS:
+		return action.page < pages;
+	case ActionLog::Kind::MOVE:
+		return action.page < pages && action.value < pages;
+	case ActionLog::Kind::ACTIVATE:
+	{
+		if (!m_backend || action.page >= pages) { return false; }
+		// the playlist of the page must be read up to the row
+		const PageId id = notebook.page_ids()[action.page];
+		return notebook.page_has_view(id) && notebook.get_page(id).size() > action.value;
+	}
+	case ActionLog::Kind::SCROLL:
+		return notebook.size() > 0 && notebook.page_has_view(notebook.current_page_id())
+			&& notebook.get_current_page().size() > action.value;
+	case ActionLog::Kind::DRAG:
+	case ActionLog::Kind::DROP:
+		// the slider can only be dragged while there's something playing
+		return m_backend && m_backend->get_player().get_state() != PlayerState::STOP;
+	default:
+		return true;
+	}
+}
+
+void Application::replay_action(const ActionLog::Action &action)
+{
+	MONITOR_CALLBACK("Application::replay_action");
+	Gui::PlaylistNotebook &notebook = m_window._notebook;
+	Gui::Slider &slider = m_window._controls._slider;
+	switch (action.kind)
+	{
+	case ActionLog::Kind::OPEN:
+		this->add_playlist_to_view(action.playlist);
+		break;
+	case ActionLog::Kind::PLACEHOLDER:
+		(void)this->add_playlist_placeholder(action.playlist);
+		break;
+	case ActionLog::Kind::FOCUS:
+		notebook.page_focus(notebook.page_ids()[action.page]);
+		break;
+	case ActionLog::Kind::NEXT_PAGE:
+		notebook.page_focus_right();
+		break;
+	case ActionLog::Kind::PREV_PAGE:
+		notebook.page_focus_left();
+		break;
+	case ActionLog::Kind::NEW_PAGE:
+		this->new_untitled_page();
+		break;
+	case ActionLog::Kind::CLOSE_PAGE:
+		this->close_current_page();
+		break;
+	case ActionLog::Kind::MOVE:
+		notebook.page_move(notebook.page_ids()[action.page], action.value);
+		break;
+	case ActionLog::Kind::ACTIVATE:
+	{
+		// emitted like a double-click, so every handler of the activation runs
+		const PageId id = notebook.page_ids()[action.page];
+		const auto row = static_cast<long>(action.value);
+		notebook.signal_row_activated().emit(id, static_cast<int>(row),
+			notebook.get_page(id).get_rows(row, 1).front()
+		);
+		break;
+	}
+	case ActionLog::Kind::DRAG:
+		slider.signal_drag().emit(Gui::Slider::DragPhase::BEGIN);
+		break;
+	case ActionLog::Kind::DROP:
+		slider.set_time(chrono::milliseconds(action.value));
+		slider.signal_drag().emit(Gui::Slider::DragPhase::END);
+		break;
+	case ActionLog::Kind::SCROLL:
+		notebook.page_restore_view_state(notebook.current_page_id(),
+			Gui::PageViewState { action.value, { } }
+		);
+		break;
+	default:
+		break;
+	}
+}
+
 
 
 // actions
@@ -325,13 +874,24 @@ bool Application::cb__window_keypress(const GdkEventKey *const event)
 	const guint keyval = Gui::translate_keysm(event->keyval);
 	
 	SPDLOG_TRACE("Key pressed = 0x{:X} | 0x{:X}", keyval, event->keyval);
+	m_keyAction = true;
+	
+	// the actions are recorded before they run, a log is in the order they were dispatched
+	const auto record = [this](const ActionLog::Kind kind, const Glib::ustring &playlist = { })
+		-> void
+	{
+		if (m_recorder) { m_recorder->record(kind, 0, 0, playlist.raw()); }
+	};
 	
 	Gui::PlaylistNotebook &notebook = m_window._notebook;
 	if (keyval == GDK_KEY_Tab) {
+		MONITOR_CALLBACK("Application::cb__window_keypress(Tab)");
 		if (keyShift) {
+			record(ActionLog::Kind::PREV_PAGE);
 			notebook.page_focus_left();
 		}
 		else {
+			record(ActionLog::Kind::NEXT_PAGE);
 			notebook.page_focus_right();
 		}
 		//return !sigc::PROPAGATE;
@@ -342,19 +902,22 @@ bool Application::cb__window_keypress(const GdkEventKey *const event)
 		case GDK_KEY_n:
 		case GDK_KEY_N:
 		{
-			Pango::AttrList attrList = Utils::create_attr_list({
-				Pango::Attribute::create_attr_style(Pango::STYLE_ITALIC)
-			});
-			notebook.page_create(_("untitled"), attrList);
+			MONITOR_CALLBACK("Application::cb__window_keypress(N)");
+			record(ActionLog::Kind::NEW_PAGE);
+			this->new_untitled_page();
 			break;
 		}
 		case GDK_KEY_p:
 		case GDK_KEY_P:
 		{
-			auto &db = m_backend.get_database();
-			std::optional<Glib::ustring> playlistName = get_playlist_choice_from_user(m_window, db);
+			// not monitored, the dialog runs a main loop of its own until it's closed,
+			// the page it opens is monitored by `add_playlist_to_view()`
+			std::optional<Glib::ustring> playlistName =
+				get_playlist_choice_from_user(m_window, m_database);
 			
+			// the time spent in the dialog is part of the action's delay
 			if (playlistName.has_value()) {
+				record(ActionLog::Kind::OPEN, playlistName.value());
 				this->add_playlist_to_view(playlistName.value());
 			}
 			break;
@@ -363,62 +926,178 @@ bool Application::cb__window_keypress(const GdkEventKey *const event)
 		case GDK_KEY_W:
 		{
 			if (notebook.size() == 0) { break; }
-			
-			const PageId current = notebook.current_page_id();
-			if (current == m_pages.get_playing()) {
-				m_backend.get_player().stop_playback();
-			}
-			notebook.page_remove(current);
+			MONITOR_CALLBACK("Application::cb__window_keypress(W)");
+			record(ActionLog::Kind::CLOSE_PAGE);
+			this->close_current_page();
 			break;
 		}
 		case GDK_KEY_v:
 		case GDK_KEY_V:
+		{
+			MONITOR_CALLBACK("Application::cb__window_keypress(V)");
 			m_window._controls._volume.get_widget_popup().popup();
 			break;
 		}
+		}
 	}
+	m_keyAction = false;
 	return sigc::PROPAGATE;
 }
 
 void Application::cb__row_activated(const PageId id, const int rowIndex, Gui::NotebookRowProxy row)
 {
+	MONITOR_CALLBACK("Application::cb__row_activated");
+	if (!m_backend) {
+		SPDLOG_WARN("Row {:d} activated before the player is ready", rowIndex);
+		return;
+	}
+	const auto page = m_pages.find(id);
+	if (page == m_pages.end() || !page->second.paths) {
+		SPDLOG_WARN("Row {:d} activated on a page without paths", rowIndex);
+		return;
+	}
+	if (m_recorder) {
+		m_recorder->record(ActionLog::Kind::ACTIVATE,
+			page_position(m_window._notebook, id), static_cast<size_t>(rowIndex)
+		);
+	}
+	m_activationTime = chrono::steady_clock::now();
 	SPDLOG_INFO("Clicked {:d}: '{:s}' [{}]", rowIndex, row.get_name(), row.get_duration());
 	
-	// unmark all the rows in the page containing the previously played song
-	if (m_pages.has_playing_page()) {
-		m_window._notebook
-			.get_page(m_pages.get_playing())
-			.mark_rows(Gui::NotebookColBit::None);
+	m_rowPlayer->play(id, page->second.paths, static_cast<size_t>(rowIndex));
+}
+
+void Application::cb__backend_ready(const std::span<std::unique_ptr<Backend>> backend)
+{
+	MONITOR_CALLBACK("Application::cb__backend_ready");
+	m_backend = std::move(backend.front());
+	if (!m_backend->is_valid()) {
+		SPDLOG_CRITICAL("Failed to initialize Momuma backend");
+		m_backend.reset();
+		Gui::display_msg_box(m_window, _("Failed to initialize the player"));
+		this->quit();
+		return;
 	}
+	m_database.attach(m_backend->get_database());
 	
-	auto &player = m_backend.get_player();
-	if (id != m_pages.get_playing() || player.playlist_empty()) {
-		using IterFlag = Momuma::Database::IterFlag;
-		spdlog::trace("1) Row activated");
-		
-		player.stop_playback();
-		m_backend.get_database().get_media_paths(m_pages[id].name,
-			[&player](fs::path p) -> IterFlag
-			{
-				mpv_error err = player.append_media(std::move(p));
-				if (err == MPV_ERROR_SUCCESS) { return IterFlag::NEXT; }
-				
-				SPDLOG_ERROR("Failed to append mpv media: ({:d}) {:s}",
-					err, mpv_error_string(err)
-				);
-				return IterFlag::STOP;
-			}
-		);
+	auto &player = m_backend->get_player();
+	m_eventPump.emplace(player);
+	m_playback.emplace(player);
+	m_rowPlayer.emplace(m_window._notebook, m_pages, player, *m_playback, *m_eventPump);
+	player.signal_streamStarted.connect(
+		sigc::mem_fun(*this, &Application::cb__audioStreamStarted)
+	);
+	player.signal_streamEnded.connect(
+		sigc::mem_fun(*this, &Application::cb__audioStreamEnded)
+	);
+	player.signal_stateChanged.connect(
+		sigc::mem_fun(*this, &Application::cb__audioStateChanged)
+	);
+	
+	Gui::PlayerControls &ctrls = m_window._controls;
+	ctrls.signal_clicked_play().connect(
+		sigc::bind(&cb__play, sigc::ref(player), sigc::ref(*m_eventPump))
+	);
+	ctrls.signal_clicked_pause().connect(
+		sigc::bind(&cb__pause, sigc::ref(player), sigc::ref(*m_eventPump))
+	);
+	ctrls.signal_clicked_stop().connect(
+		sigc::bind(&cb__stop, sigc::ref(player), sigc::ref(*m_eventPump))
+	);
+	ctrls.signal_clicked_next_song().connect(
+		sigc::bind(sigc::mem_fun(*this, &Application::cb__skip_song), 1)
+	);
+	ctrls.signal_clicked_prev_song().connect(
+		sigc::bind(sigc::mem_fun(*this, &Application::cb__skip_song), -1)
+	);
+	ctrls.signal_volume_value_changed().connect(
+		sigc::bind(&cb__volume, sigc::ref(player), sigc::ref(*m_eventPump))
+	);
+	ctrls._slider.signal_drag().connect(
+		sigc::mem_fun(*this, &Application::cb__slider_update)
+	);
+	ctrls._slider.set_playback_source(sigc::bind(&read_playback_time, sigc::ref(player)));
+	// the volume may have been restored from the session already
+	player.set_volume(ctrls._volume.get_value());
+	ctrls.w_.set_sensitive(true);
+	
+	Startup::reach(Startup::Phase::BACKEND);
+}
+
+bool Application::cb__first_frame(const Cairo::RefPtr<Cairo::Context>&)
+{
+	m_firstFrame.disconnect();
+	Startup::reach(Startup::Phase::FIRST_FRAME);
+	return false;
+}
+
+void Application::cb__playlist_loaded(const PageId id)
+{
+	MONITOR_CALLBACK("Application::cb__playlist_loaded");
+	const MetadataCache::Stats stats = m_metadataCache.take_stats();
+	const auto it = m_pages.find(id);
+	if (it == m_pages.end()) { return; }
+	
+	PageData &data = it->second;
+	SPDLOG_INFO("Metadata cache of '{:s}': {:d} hits, {:d} misses",
+		data.name, stats.hits, stats.misses
+	);
+	
+	// the page was evicted before, it's shown as it was left
+	if (data.view.has_value()) {
+		m_window._notebook.page_restore_view_state(id, data.view.value());
+		data.view.reset();
 	}
+	this->evict_pages();
+}
+
+void Application::cb__page_focused(const PageId id)
+{
+	MONITOR_CALLBACK("Application::cb__page_focused");
+	m_pageLru.touch(id);
 	
-	player.set_index(rowIndex);
-	player.set_play(true);
-	row.set_marked(Gui::NotebookColBit::NAME);
+	// only placeholders are loaded, pages that were never shown or evicted since
+	Gui::PlaylistNotebook &notebook = m_window._notebook;
+	if (!m_pages.contains(id) || notebook.page_has_view(id)) { return; }
+	
+	notebook.page_create_view(id);
+	this->load_page(id);
+}
+
+void Application::cb__record_focus(const PageId id)
+{
+	if (!m_recorder || m_keyAction) { return; }
+	m_recorder->record(ActionLog::Kind::FOCUS, page_position(m_window._notebook, id));
+}
+
+void Application::cb__record_move(const PageId id, const size_t position)
+{
+	if (!m_recorder) { return; }
+	
+	// GTK only tells where the page went, where it was is known from the previous order
+	const auto it = std::find(m_recordedPages.begin(), m_recordedPages.end(), id);
+	if (it != m_recordedPages.end()) {
+		const auto from = static_cast<size_t>(it - m_recordedPages.begin());
+		m_recorder->record(ActionLog::Kind::MOVE, from, position);
+	}
+	m_recordedPages = m_window._notebook.page_ids();
+}
+
+void Application::cb__save_session(void)
+{
+	MONITOR_CALLBACK("Application::cb__save_session");
+	// a replay mustn't replace the session of the user
+	if (m_replayer.has_value()) { return; }
+	
+	// a save that didn't finish since the last one is outdated
+	m_sessionSave.cancel();
+	m_sessionSave = TaskScheduler::CancelToken();
+	m_scheduler.spawn(this->save_session_task(), TaskScheduler::Priority::LOW, m_sessionSave);
 }
 
 void Application::cb__slider_update(const Gui::Slider::DragPhase phase)
 {
-	auto &player = this->m_backend.get_player();
+	auto &player = this->m_backend->get_player();
 	const PlayerState state = player.get_state();
 	if (state == PlayerState::STOP) {
 		SPDLOG_WARN("The slider shouldn't be updated when the player is stopped");
@@ -427,59 +1106,107 @@ void Application::cb__slider_update(const Gui::Slider::DragPhase phase)
 	
 	static PlayerState oldState;
 	
+	auto &slider = m_window._controls._slider;
 	if (phase == Gui::Slider::DragPhase::BEGIN) {
+		if (m_recorder) { m_recorder->record(ActionLog::Kind::DRAG); }
 		(void)player.set_play(false);
 	}
 	else {
-		auto &slider = m_window._controls._slider;
-		(void)player.set_position(slider.get_time());
+		const chrono::milliseconds position = slider.get_time();
+		if (m_recorder) {
+			const auto ms = std::max<chrono::milliseconds::rep>(position.count(), 0);
+			m_recorder->record(ActionLog::Kind::DROP, 0, static_cast<size_t>(ms));
+		}
+		(void)player.set_position(position);
+		slider.resync();
 		
 		if (oldState == PlayerState::PLAY) {
 			(void)player.set_play(true);
 		}
 	}
+	m_eventPump->kick();
 	
 	oldState = state;
 }
 
-void Application::cb__audioStreamStarted(Momuma::MpvPlayer &src)
+void Application::cb__replay_finished(void)
+{
+	m_replayer->log_report();
+	SPDLOG_INFO("The main loop stalled {:d} times during the replay", m_watchdog.stalls());
+	const std::string report = Glib::getenv(ActionLog::REPORT_ENV);
+	if (!report.empty()) {
+		(void)m_replayer->write_report(report);
+	}
+	this->on_action_quit();
+}
+
+void Application::cb__audioStreamStarted(Backend::Player &src)
 {
+	if (m_activationTime.has_value()) {
+		const chrono::duration<double, std::milli> latency =
+			chrono::steady_clock::now() - m_activationTime.value();
+		SPDLOG_INFO("Time to first audio: {:.1f} ms", latency.count());
+		m_activationTime.reset();
+	}
+	
 	mpv_error e;
 	m_window._controls._slider.set_time_limit(
 		chrono::duration_cast<chrono::milliseconds>(src.get_duration(e))
 	);
+	m_window._controls._slider.resync();
 	SPDLOG_TRACE("{:s}: ({:d}) {:s}", SPDLOG_FUNCTION, e, mpv_error_string(e));
 }
 
-void Application::cb__audioStreamEnded(Momuma::MpvPlayer &src)
+void Application::cb__audioStreamEnded(Backend::Player &src)
 {
+	MONITOR_CALLBACK("Application::cb__audioStreamEnded");
 	SPDLOG_TRACE(SPDLOG_FUNCTION);
-	if (m_pages.get_playing() == PageId::Null) { return; }
+	// the row is of the page loaded in the player, which the playing page may not be anymore
+	if (!m_playback || m_playback->page() == PageId::Null) { return; }
 	
-	std::vector proxies = m_window._notebook.get_page(m_pages.get_playing()).get_rows();
-	if (proxies.size() == 0) { return; }
+	const Gui::NotebookPageProxy page = m_window._notebook.get_page(m_playback->page());
+	if (page.empty()) { return; }
 	
-	const int64_t index = src.get_index();
-	const auto songs = static_cast<size_t>(src.playlist_size());
-	if (index < 0) {
-		proxies.back().set_marked(Gui::NotebookColBit::None);
-		return;
-	}
+	// the player's playlist only holds a window of the page, `nullopt` once it ended
+	const std::optional<size_t> row = m_playback->index_to_row(src.get_index());
+	page.set_playing_row(row);
+	m_playback->advance();
+}
+
+void Application::cb__skip_song(const int offset)
+{
+	MONITOR_CALLBACK("Application::cb__skip_song");
+	auto &player = m_backend->get_player();
+	const std::optional<size_t> row = m_playback->current_row();
+	if (!row.has_value()) { return; }
 	
-	const auto uIndex = static_cast<size_t>(index);
-	proxies.at(uIndex).set_marked(Gui::NotebookColBit::NAME);
-	if (proxies.size() > 1) {
-		proxies.at((uIndex - 1) % songs).set_marked(Gui::NotebookColBit::None);
-	}
+	const int64_t target = static_cast<int64_t>(row.value()) + offset;
+	if (target < 0 || static_cast<size_t>(target) >= m_playback->rows()) { return; }
+	
+	const auto targetRow = static_cast<size_t>(target);
+	const Gui::NotebookPageProxy page = m_window._notebook.get_page(m_playback->page());
+	page.set_playing_row(m_playback->jump(targetRow) ? std::optional(targetRow) : std::nullopt);
+	player.set_play(true);
+	m_eventPump->kick();
 }
 
-void Application::cb__audioStateChanged(Momuma::MpvPlayer&,
+void Application::cb__audioStateChanged(Backend::Player&,
 	[[maybe_unused]] const PlayerState prevState,
 	const PlayerState newState
 ) {
+	MONITOR_CALLBACK("Application::cb__audioStateChanged");
 	SPDLOG_TRACE("{:s}: {:d} => {:d}", SPDLOG_FUNCTION,
 		static_cast<int>(prevState), static_cast<int>(newState)
 	);
 	update_controls_state(m_window._controls, newState);
-	m_letSliderUpdate = (newState == PlayerState::PLAY);
+	m_window._controls._slider.set_playing(newState == PlayerState::PLAY);
+}
+
+void Application::cb__window_state_changed(const GdkEventWindowState *const event)
+{
+	// don't move the slider when nobody can see it
+	const Momuma::Bitset state(event->new_window_state);
+	const bool hidden = state.contains(GDK_WINDOW_STATE_ICONIFIED)
+		|| state.contains(GDK_WINDOW_STATE_WITHDRAWN);
+	m_window._controls._slider.set_suspended(hidden);
 }
@@ -0,0 +1,200 @@
+#include <cassert>
+#include <momuma/spdlog.h>
+
+#include "DatabaseService.h"
+#include "LoopMonitor.h"
+#include "Trace.h"
+
+
+// chunks and completions waiting for the main loop
+constexpr size_t DELIVERIES_CAPACITY = 256;
+
+
+// DatabaseService::Request
+// ==================================================
+
+DatabaseService::Request::Request(void) :
+	m_state { }
+{
+}
+
+void DatabaseService::Request::cancel(void)
+{
+	if (m_state) {
+		m_state->cancelled.store(true, std::memory_order_relaxed);
+	}
+}
+
+bool DatabaseService::Request::is_pending(void) const
+{
+	return m_state && !m_state->done && !m_state->cancelled.load(std::memory_order_relaxed);
+}
+
+
+
+// DatabaseService - public
+// ==================================================
+
+DatabaseService::DatabaseService(void) :
+	d_database { nullptr },
+	m_jobs { }, m_deliveries { DELIVERIES_CAPACITY }
+{
+	m_deliveries.connect(sigc::mem_fun(*this, &DatabaseService::cb__deliver));
+	m_thread = std::jthread(std::bind_front(&DatabaseService::thread_loop, this));
+}
+
+DatabaseService::~DatabaseService(void)
+{
+	m_thread.request_stop();
+	m_jobsCv.notify_all();
+	m_thread.join();
+}
+
+void DatabaseService::attach(Database &database)
+{
+	{
+		const std::lock_guard lock(m_jobsMutex);
+		assert(d_database == nullptr);
+		d_database = &database;
+	}
+	m_jobsCv.notify_one();
+}
+
+auto DatabaseService::get_playlists(RowsSlot<Glib::ustring> onRows, DoneSlot onDone) -> Request
+{
+	return this->submit<Glib::ustring>(
+		[](Database &db, const std::function<IterFlag(Glib::ustring)> &cb) -> int
+		{
+			return db.get_playlists(cb);
+		},
+		std::move(onRows), std::move(onDone)
+	);
+}
+
+auto DatabaseService::get_media_paths(const Glib::ustring &playlist,
+	RowsSlot<std::filesystem::path> onRows, DoneSlot onDone
+) -> Request {
+	return this->submit<std::filesystem::path>(
+		[playlist](Database &db, const std::function<IterFlag(std::filesystem::path)> &cb)
+			-> int
+		{
+			return db.get_media_paths(playlist, cb);
+		},
+		std::move(onRows), std::move(onDone)
+	);
+}
+
+
+
+// DatabaseService - private
+// ==================================================
+
+template <typename Row>
+auto DatabaseService::submit(Query<Row> query, RowsSlot<Row> onRows, DoneSlot onDone)
+	-> Request
+{
+	// the slots are only touched on the main loop, the service thread only passes them along
+	struct Callbacks
+	{
+		RowsSlot<Row> onRows;
+		DoneSlot onDone;
+	};
+	auto callbacks = std::make_shared<Callbacks>(
+		Callbacks { std::move(onRows), std::move(onDone) }
+	);
+	
+	Request request;
+	request.m_state = std::make_shared<Request::State>();
+	
+	Job job = [this, state = request.m_state, callbacks = std::move(callbacks),
+		query = std::move(query)
+	](Database &database, const std::stop_token &stop) mutable -> void
+	{
+		TRACE_SPAN("DatabaseService query");
+		std::vector<Row> chunk;
+		// returns false when the service is stopping
+		const auto flush = [this, &state, &callbacks, &chunk, &stop](void) -> bool
+		{
+			if (chunk.empty()) { return true; }
+			Delivery delivery = [state, callbacks, rows = std::move(chunk)]
+				(void) mutable -> void
+			{
+				if (!state->cancelled) { callbacks->onRows(std::move(rows)); }
+			};
+			chunk = std::vector<Row>();
+			return this->deliver(std::move(delivery), stop);
+		};
+		
+		// a query cancelled while waiting still completes, to hand the callbacks back
+		const int result = state->cancelled ? 0 : query(database,
+			[&state, &chunk, &flush](Row row) -> IterFlag
+			{
+				if (state->cancelled.load(std::memory_order_relaxed)) {
+					return IterFlag::STOP;
+				}
+				
+				chunk.push_back(std::move(row));
+				if (chunk.size() < CHUNK_ROWS || flush()) { return IterFlag::NEXT; }
+				return IterFlag::STOP;
+			}
+		);
+		(void)flush();
+		
+		// moved, so the callbacks are released on the main loop
+		Delivery done = [state = std::move(state), callbacks = std::move(callbacks), result]
+			(void) -> void
+		{
+			state->done = true;
+			if (!state->cancelled) { callbacks->onDone(result >= 0); }
+		};
+		(void)this->deliver(std::move(done), stop);
+	};
+	
+	{
+		const std::lock_guard lock(m_jobsMutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_jobsCv.notify_one();
+	return request;
+}
+
+void DatabaseService::thread_loop(const std::stop_token stop)
+{
+	TRACE_THREAD_NAME("database");
+	while (true) {
+		Job job;
+		Database *database;
+		{
+			std::unique_lock lock(m_jobsMutex);
+			// queries wait for the database
+			const bool ready = m_jobsCv.wait(lock, stop,
+				[this](void) -> bool
+				{
+					return d_database != nullptr && !m_jobs.empty();
+				}
+			);
+			if (!ready) { return; }
+			
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+			database = d_database;
+		}
+		job(*database, stop);
+	}
+}
+
+bool DatabaseService::deliver(Delivery &&delivery, const std::stop_token &stop)
+{
+	// the main loop isn't running anymore when the service is being destroyed
+	return m_deliveries.push(std::move(delivery), stop);
+}
+
+void DatabaseService::cb__deliver(const std::span<Delivery> deliveries)
+{
+	MONITOR_CALLBACK("DatabaseService::cb__deliver");
+	for (Delivery &delivery : deliveries) {
+		delivery();
+		// the slots it holds must be destroyed on the main loop
+		delivery = nullptr;
+	}
+}
@@ -0,0 +1,497 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <glibmm/main.h>
+#include <glibmm/miscutils.h>
+#include <momuma/spdlog.h>
+#include <string_view>
+#include <thread>
+
+#include "FakeBackend.h"
+
+
+using PlayerState = Backend::Player::State;
+using IterFlag = Backend::Database::IterFlag;
+
+// durations of the generated tracks, in seconds
+constexpr uint64_t MIN_DURATION = 90;
+constexpr uint64_t MAX_DURATION = 600;
+
+
+template <typename T>
+[[nodiscard]] static bool parse_number(const std::string_view text, T &value)
+{
+	const char *const end = text.data() + text.size();
+	const auto [ptr, error] = std::from_chars(text.data(), end, value);
+	return error == std::errc() && ptr == end;
+}
+
+// Parse colon-separated sizes
+[[nodiscard]] static bool parse_sizes(std::string_view text, std::vector<size_t> &sizes)
+{
+	sizes.clear();
+	while (!text.empty()) {
+		const size_t colon = std::min(text.find(':'), text.size());
+		size_t size = 0;
+		if (!parse_number(text.substr(0, colon), size)) { return false; }
+		sizes.push_back(size);
+		text.remove_prefix(std::min(colon + 1, text.size()));
+	}
+	return !sizes.empty();
+}
+
+[[nodiscard]] static bool parse_setting(FakeBackend::Config &config,
+	const std::string_view key, const std::string_view value
+) {
+	uint64_t us = 0;
+	if (key == "playlists") { return parse_sizes(value, config.playlists); }
+	if (key == "probe_us" && parse_number(value, us)) {
+		config.probeLatency = chrono::microseconds(us);
+		return true;
+	}
+	if (key == "seek_us" && parse_number(value, us)) {
+		config.seekLatency = chrono::microseconds(us);
+		return true;
+	}
+	if (key == "speed") { return parse_number(value, config.speed) && config.speed > 0.0; }
+	return false;
+}
+
+// FNV-1a, stable between runs and builds unlike `std::hash`
+[[nodiscard]] static uint64_t stable_hash(const std::string_view text)
+{
+	uint64_t hash = 0xCBF29CE484222325;
+	for (const char c : text) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3;
+	}
+	return hash;
+}
+
+
+
+// FakeBackend::VirtualPlayer
+// ==================================================
+
+/* #Plays a playlist on a virtual clock.
+! The clock is only read when the player is, everything it missed is caught up then. Events
+are queued as they happen and emitted one at a time by `handle_event()`.
+! With a wakeup set, a timer also reads the clock when the current stream should start or end,
+so those events are queued on time like the real player's.
+*/
+class FakeBackend::VirtualPlayer final : public Backend::Player
+{
+public:
+	explicit VirtualPlayer(const Config &config) :
+		m_seekLatency { static_cast<int64_t>(
+			static_cast<double>(config.seekLatency.count()) * config.speed
+		) },
+		m_speed { config.speed },
+		m_epoch { Clock::now() },
+		m_playlist { }, m_index { -1 }, m_state { PlayerState::STOP }, m_volume { 100.0 },
+		m_position { 0 }, m_duration { 0 }, m_readyAt { 0 }, m_lastUpdate { 0 },
+		m_started { false }, m_events { },
+		m_wakeup { }, m_timer { }, m_wakeAt { }
+	{
+	}
+	
+	~VirtualPlayer(void) override
+	{
+		m_timer.disconnect();
+	}
+	
+	void handle_event(void) override
+	{
+		this->update();
+		if (m_events.empty()) { return; }
+		
+		const Event event = m_events.front();
+		m_events.pop_front();
+		switch (event.type)
+		{
+		case Event::STARTED: signal_streamStarted.emit(*this); break;
+		case Event::ENDED: signal_streamEnded.emit(*this); break;
+		case Event::STATE: signal_stateChanged.emit(*this, event.prevState, event.newState);
+			break;
+		}
+	}
+	
+	bool set_wakeup(WakeupFunc wakeup) override
+	{
+		m_wakeup = std::move(wakeup);
+		m_timer.disconnect();
+		m_wakeAt.reset();
+		if (m_wakeup) {
+			// the events already queued need their wakeups too
+			for (size_t i = 0; i < m_events.size(); ++i) { m_wakeup(); }
+			this->arm_timer();
+		}
+		return true;
+	}
+	
+	State get_state(void) override
+	{
+		this->update();
+		return m_state;
+	}
+	
+	chrono::microseconds get_position(mpv_error &error) override
+	{
+		this->update();
+		error = m_started ? MPV_ERROR_SUCCESS : MPV_ERROR_PROPERTY_UNAVAILABLE;
+		return m_started ? m_position : chrono::microseconds(0);
+	}
+	
+	chrono::microseconds get_duration(mpv_error &error) override
+	{
+		this->update();
+		error = m_started ? MPV_ERROR_SUCCESS : MPV_ERROR_PROPERTY_UNAVAILABLE;
+		return m_started ? m_duration : chrono::microseconds(0);
+	}
+	
+	void set_play(const bool play) override
+	{
+		this->update();
+		if (!play) {
+			if (m_state == PlayerState::PLAY) {
+				this->change_state(PlayerState::PAUSE);
+				this->arm_timer();
+			}
+			return;
+		}
+		
+		if (m_playlist.empty()) { return; }
+		if (m_index < 0) { this->load(0); }
+		this->change_state(PlayerState::PLAY);
+		this->arm_timer();
+	}
+	
+	void set_position(const chrono::milliseconds position) override
+	{
+		this->update();
+		if (m_index < 0) { return; }
+		
+		m_position = std::clamp<chrono::microseconds>(position, chrono::microseconds(0),
+			m_duration
+		);
+		m_readyAt = this->now() + m_seekLatency;
+		this->arm_timer();
+	}
+	
+	void set_volume(const double volume) override
+	{
+		m_volume = volume;
+	}
+	
+	void stop_playback(void) override
+	{
+		this->update();
+		m_playlist.clear();
+		m_index = -1;
+		m_started = false;
+		this->change_state(PlayerState::STOP);
+		this->arm_timer();
+	}
+	
+	mpv_error append_media(const fs::path &path) override
+	{
+		m_playlist.push_back(path);
+		return MPV_ERROR_SUCCESS;
+	}
+	
+	bool remove_media(const int index) override
+	{
+		this->update();
+		if (index < 0 || index == m_index
+			|| static_cast<size_t>(index) >= m_playlist.size()
+		) {
+			return false;
+		}
+		(void)m_playlist.erase(m_playlist.begin() + index);
+		if (index < m_index) { --m_index; }
+		return true;
+	}
+	
+	bool playlist_empty(void) override
+	{
+		return m_playlist.empty();
+	}
+	
+	int64_t get_index(void) override
+	{
+		this->update();
+		return m_index;
+	}
+	
+	void set_index(const int index) override
+	{
+		this->update();
+		if (index < 0 || static_cast<size_t>(index) >= m_playlist.size()) { return; }
+		this->load(index);
+		this->arm_timer();
+	}
+	
+private:
+	using Clock = chrono::steady_clock;
+	
+	struct Event
+	{
+		enum Type { STARTED, ENDED, STATE } type;
+		State prevState;
+		State newState;
+	};
+	
+	// on the virtual clock
+	const chrono::microseconds m_seekLatency;
+	const double m_speed;
+	const Clock::time_point m_epoch;
+	
+	std::vector<fs::path> m_playlist;
+	int64_t m_index;
+	State m_state;
+	double m_volume;
+	
+	// of the current stream, and on the virtual clock
+	chrono::microseconds m_position;
+	chrono::microseconds m_duration;
+	// the stream doesn't play until then, while it's loaded or seeked
+	chrono::microseconds m_readyAt;
+	chrono::microseconds m_lastUpdate;
+	// whether the start of the current stream was queued
+	bool m_started;
+	
+	std::deque<Event> m_events;
+	
+	WakeupFunc m_wakeup;
+	sigc::connection m_timer;
+	// when `m_timer` fires, on the virtual clock
+	std::optional<chrono::microseconds> m_wakeAt;
+	
+	
+	// Time on the virtual clock
+	[[nodiscard]] chrono::microseconds now(void) const
+	{
+		const chrono::duration<double, std::micro> real = Clock::now() - m_epoch;
+		return chrono::microseconds(static_cast<int64_t>(real.count() * m_speed));
+	}
+	
+	void load(const int64_t index)
+	{
+		m_index = index;
+		m_position = chrono::microseconds(0);
+		m_duration = track_duration(m_playlist[static_cast<size_t>(index)]);
+		m_readyAt = this->now() + m_seekLatency;
+		m_started = false;
+	}
+	
+	void change_state(const State state)
+	{
+		if (state == m_state) { return; }
+		this->queue({ Event::STATE, m_state, state });
+		m_state = state;
+	}
+	
+	void queue(const Event &event)
+	{
+		m_events.push_back(event);
+		if (m_wakeup) { m_wakeup(); }
+	}
+	
+	// Arm the timer for the next start or end of a stream, when there's a wakeup to call
+	void arm_timer(void)
+	{
+		if (!m_wakeup) { return; }
+		
+		std::optional<chrono::microseconds> at;
+		if (m_state == PlayerState::PLAY && m_index >= 0) {
+			// a stream that started only plays once it's ready again, after a seek
+			at = !m_started ? m_readyAt
+				: std::max(m_readyAt, m_lastUpdate) + (m_duration - m_position);
+		}
+		if (at == m_wakeAt) { return; }
+		
+		m_timer.disconnect();
+		m_wakeAt = at;
+		if (!at.has_value()) { return; }
+		
+		const double delay = static_cast<double>((at.value() - this->now()).count())
+			/ m_speed / 1000.0;
+		m_timer = Glib::signal_timeout().connect(
+			[this](void) -> bool
+			{
+				m_wakeAt.reset();
+				this->update(); // queues the events, and arms the next wakeup
+				return false;
+			},
+			static_cast<unsigned int>(std::max(std::ceil(delay), 0.0))
+		);
+	}
+	
+	// Catch up with the virtual clock
+	void update(void)
+	{
+		this->catch_up();
+		this->arm_timer();
+	}
+	
+	void catch_up(void)
+	{
+		const chrono::microseconds now = this->now();
+		chrono::microseconds from = std::max(m_lastUpdate, m_readyAt);
+		m_lastUpdate = now;
+		
+		// several streams may have ended since the last update
+		while (m_state == PlayerState::PLAY && m_index >= 0 && now >= m_readyAt) {
+			if (!m_started) {
+				m_started = true;
+				this->queue({ Event::STARTED, m_state, m_state });
+			}
+			
+			const chrono::microseconds left = m_duration - m_position;
+			if (now - from < left) {
+				m_position += now - from;
+				return;
+			}
+			
+			this->queue({ Event::ENDED, m_state, m_state });
+			if (static_cast<size_t>(m_index) + 1 >= m_playlist.size()) {
+				// the player idles at the end of its playlist
+				m_index = -1;
+				m_started = false;
+				this->change_state(PlayerState::STOP);
+				return;
+			}
+			from += left;
+			this->load(m_index + 1);
+			// the next stream was loading while the clock ran
+			m_readyAt = from + m_seekLatency;
+			from = m_readyAt;
+		}
+	}
+};
+
+
+
+// FakeBackend::Generator
+// ==================================================
+
+// Generates the playlists of the configuration
+class FakeBackend::Generator final : public Backend::Database
+{
+public:
+	explicit Generator(const std::vector<size_t> &playlists) :
+		m_playlists { playlists }
+	{
+	}
+	
+	int get_playlists(const std::function<IterFlag(Glib::ustring)> &callback) override
+	{
+		for (size_t i = 0; i < m_playlists.size(); ++i) {
+			if (callback(playlist_name(i, m_playlists[i])) == IterFlag::STOP) { break; }
+		}
+		return static_cast<int>(m_playlists.size());
+	}
+	
+	int get_media_paths(const Glib::ustring &playlist,
+		const std::function<IterFlag(fs::path)> &callback
+	) override {
+		for (size_t i = 0; i < m_playlists.size(); ++i) {
+			if (playlist != playlist_name(i, m_playlists[i])) { continue; }
+			
+			for (size_t track = 0; track < m_playlists[i]; ++track) {
+				if (callback(track_path(i, track)) == IterFlag::STOP) { break; }
+			}
+			return static_cast<int>(std::min<size_t>(m_playlists[i], INT32_MAX));
+		}
+		SPDLOG_ERROR("No generated playlist named '{:s}'", playlist.raw());
+		return -1;
+	}
+	
+private:
+	const std::vector<size_t> m_playlists;
+};
+
+
+
+// FakeBackend
+// ==================================================
+
+auto FakeBackend::config_from_env(void) -> std::optional<Config>
+{
+	bool found = false;
+	const std::string value = Glib::getenv(CONFIG_ENV, found);
+	if (!found) { return std::nullopt; }
+	
+	Config config;
+	std::string_view settings = value;
+	while (!settings.empty()) {
+		const size_t comma = std::min(settings.find(','), settings.size());
+		const std::string_view setting = settings.substr(0, comma);
+		settings.remove_prefix(std::min(comma + 1, settings.size()));
+		
+		const size_t equal = std::min(setting.find('='), setting.size());
+		const std::string_view key = setting.substr(0, equal);
+		const std::string_view val = setting.substr(std::min(equal + 1, setting.size()));
+		if (equal == setting.size() || !parse_setting(config, key, val)) {
+			SPDLOG_WARN("Ignoring invalid setting '{:s}' of {:s}", setting, CONFIG_ENV);
+		}
+	}
+	return config;
+}
+
+std::string FakeBackend::playlist_name(const size_t playlist, const size_t tracks)
+{
+	return fmt::format("Generated {:d} ({:d} tracks)", playlist + 1, tracks);
+}
+
+fs::path FakeBackend::track_path(const size_t playlist, const size_t track)
+{
+	return fmt::format("/generated/{:d}/{:07d} - Artist {:03d} - Title {:d}.flac",
+		playlist + 1, track, track % 997, track
+	);
+}
+
+chrono::seconds FakeBackend::track_duration(const fs::path &path)
+{
+	const uint64_t hash = stable_hash(path.native());
+	return chrono::seconds(MIN_DURATION + hash % (MAX_DURATION - MIN_DURATION + 1));
+}
+
+auto FakeBackend::make_probe(const Config &config) -> ProbeFunc
+{
+	return [latency = config.probeLatency](const fs::path &path) -> chrono::microseconds
+	{
+		std::this_thread::sleep_for(latency);
+		return track_duration(path);
+	};
+}
+
+FakeBackend::FakeBackend(Config config) :
+	m_config { std::move(config) },
+	m_player { std::make_unique<VirtualPlayer>(m_config) },
+	m_database { std::make_unique<Generator>(m_config.playlists) }
+{
+	size_t tracks = 0;
+	for (const size_t size : m_config.playlists) { tracks += size; }
+	SPDLOG_WARN("Using a fake backend: {:d} generated playlists ({:d} tracks), probes take "
+		"{:d} µs, seeks {:d} µs, the clock runs {:g}x",
+		m_config.playlists.size(), tracks, m_config.probeLatency.count(),
+		m_config.seekLatency.count(), m_config.speed
+	);
+}
+
+FakeBackend::~FakeBackend(void) = default;
+
+bool FakeBackend::is_valid(void) const
+{
+	return true;
+}
+
+auto FakeBackend::get_player(void) -> Player&
+{
+	return *m_player;
+}
+
+auto FakeBackend::get_database(void) -> Database&
+{
+	return *m_database;
+}
@@ -0,0 +1,376 @@
+#include <cstring>
+#include <momuma/spdlog.h>
+
+#include "Gui/PlaylistModel.h"
+
+
+[[nodiscard]] static inline
+int32_t duration_to_storage(const chrono::seconds duration)
+{
+	if (duration < chrono::seconds(0)) { return -1; }
+	return static_cast<int32_t>(std::min<chrono::seconds::rep>(duration.count(), INT32_MAX));
+}
+
+// A stamp no model used before, so handles to the rows of one never match another. Models only
+// live on the main loop.
+[[nodiscard]] static
+int next_stamp(void)
+{
+	static int s_stamp = 0;
+	return ++s_stamp;
+}
+
+
+namespace Gui
+{
+
+// public
+// ==================================================
+
+Glib::RefPtr<PlaylistModel> PlaylistModel::create(void)
+{
+	return Glib::RefPtr<PlaylistModel>(new PlaylistModel());
+}
+
+size_t PlaylistModel::size(void) const
+{
+	return m_durations.size();
+}
+
+bool PlaylistModel::empty(void) const
+{
+	return m_durations.empty();
+}
+
+bool PlaylistModel::append(const NotebookRowData &data)
+{
+	if (!this->push_row(data)) { return false; }
+	
+	const size_t row = this->size() - 1;
+	this->row_inserted(Path(1, static_cast<int>(row)), this->index_to_iter(row));
+	return true;
+}
+
+void PlaylistModel::append(const std::span<const NotebookRowData> rows)
+{
+	if (rows.empty()) { return; }
+	
+	m_signal_reset.emit(ResetPhase::BEGIN);
+	
+	const size_t size = this->size() + rows.size();
+	m_marked.reserve(size);
+	m_nameOffsets.reserve(size);
+	m_durations.reserve(size);
+	for (const NotebookRowData &data : rows) {
+		if (!this->push_row(data)) { break; }
+	}
+	
+	m_signal_reset.emit(ResetPhase::END);
+}
+
+void PlaylistModel::extend(const std::span<const NotebookRowData> rows)
+{
+	// one by one as listeners expect the model to only hold the rows they've been told about,
+	// and without reserving so the storage still grows geometrically when fed small batches
+	for (const NotebookRowData &data : rows) {
+		if (!this->append(data)) { break; }
+	}
+}
+
+void PlaylistModel::clear(void)
+{
+	m_signal_reset.emit(ResetPhase::BEGIN);
+	
+	m_stamp = next_stamp();
+	m_playingRow.reset();
+	// swap with empty vectors to actually release the memory
+	std::vector<uint8_t>().swap(m_marked);
+	std::vector<uint32_t>().swap(m_nameOffsets);
+	std::vector<int32_t>().swap(m_durations);
+	std::vector<char>().swap(m_names);
+	
+	m_signal_reset.emit(ResetPhase::END);
+}
+
+void PlaylistModel::truncate(const size_t size)
+{
+	if (size >= this->size()) { return; }
+	
+	m_stamp = next_stamp();
+	if (m_playingRow.has_value() && m_playingRow.value() >= size) {
+		m_playingRow.reset();
+	}
+	// last row first, so each `row-deleted` describes the model as it is when it's emitted
+	for (size_t row = this->size(); row-- > size;) {
+		m_marked.pop_back();
+		m_nameOffsets.pop_back();
+		m_durations.pop_back();
+		this->row_deleted(Path(1, static_cast<int>(row)));
+	}
+	
+	if (this->empty()) {
+		// renamed rows leave their names anywhere in the arena, it's released as a whole
+		std::vector<uint8_t>().swap(m_marked);
+		std::vector<uint32_t>().swap(m_nameOffsets);
+		std::vector<int32_t>().swap(m_durations);
+		std::vector<char>().swap(m_names);
+	}
+}
+
+NotebookColBit PlaylistModel::get_marked(const size_t row) const
+{
+	return static_cast<NotebookColBit>(m_marked.at(row));
+}
+
+void PlaylistModel::set_marked(const size_t row, const NotebookColBit marked)
+{
+	if (row >= m_marked.size()) { return; }
+	
+	m_marked[row] = static_cast<uint8_t>(marked);
+	this->emit_row_changed(row);
+}
+
+const char* PlaylistModel::get_name(const size_t row) const
+{
+	return m_names.data() + m_nameOffsets.at(row);
+}
+
+void PlaylistModel::set_name(const size_t row, const Glib::ustring &name)
+{
+	if (!this->name_fits(name.bytes())) {
+		SPDLOG_ERROR("No room left for the name of row {:d}: '{:s}'", row, name.raw());
+		return;
+	}
+	
+	// the old name is left in the arena, it's released when the model is cleared
+	m_nameOffsets.at(row) = static_cast<uint32_t>(m_names.size());
+	m_names.insert(m_names.end(), name.raw().begin(), name.raw().end());
+	m_names.push_back('\0');
+	this->emit_row_changed(row);
+}
+
+chrono::seconds PlaylistModel::get_duration(const size_t row) const
+{
+	const int32_t duration = m_durations.at(row);
+	return duration < 0 ? NotebookRowData::UNKNOWN_DURATION : chrono::seconds(duration);
+}
+
+void PlaylistModel::set_duration(const size_t row, const chrono::seconds duration)
+{
+	m_durations.at(row) = duration_to_storage(duration);
+	this->emit_row_changed(row);
+}
+
+void PlaylistModel::set_playing_row(
+	const std::optional<size_t> row, const NotebookColBit marked
+) {
+	if (m_playingRow.has_value() && m_playingRow != row) {
+		this->set_marked(m_playingRow.value(), NotebookColBit::None);
+	}
+	m_playingRow = row;
+	if (row.has_value()) {
+		this->set_marked(row.value(), marked);
+	}
+}
+
+std::optional<size_t> PlaylistModel::get_playing_row(void) const
+{
+	return m_playingRow;
+}
+
+size_t PlaylistModel::iter_to_index(const Gtk::TreeIter &iter)
+{
+	return GPOINTER_TO_SIZE(iter.gobj()->user_data);
+}
+
+Gtk::TreeIter PlaylistModel::index_to_iter(const size_t row)
+{
+	Gtk::TreeIter iter(this);
+	this->set_iter(iter, row);
+	return iter;
+}
+
+int PlaylistModel::generation(void) const
+{
+	return m_stamp;
+}
+
+size_t PlaylistModel::memory_usage(void) const
+{
+	return m_marked.capacity() * sizeof(uint8_t)
+		+ m_nameOffsets.capacity() * sizeof(uint32_t)
+		+ m_durations.capacity() * sizeof(int32_t)
+		+ m_names.capacity() * sizeof(char);
+}
+
+auto PlaylistModel::signal_reset(void) -> sigc::signal<void(ResetPhase)>
+{
+	return m_signal_reset;
+}
+
+
+
+// protected
+// ==================================================
+
+PlaylistModel::PlaylistModel(void) :
+	Glib::ObjectBase { typeid(PlaylistModel) }, // registers a custom GType
+	Glib::Object { },
+	m_stamp { next_stamp() }, m_playingRow { }
+{
+}
+
+Gtk::TreeModelFlags PlaylistModel::get_flags_vfunc(void) const
+{
+	return Gtk::TREE_MODEL_LIST_ONLY;
+}
+
+int PlaylistModel::get_n_columns_vfunc(void) const
+{
+	return N_COLUMNS;
+}
+
+GType PlaylistModel::get_column_type_vfunc(const int index) const
+{
+	switch (index)
+	{
+	case MARKED: return G_TYPE_UINT;
+	case NAME: return G_TYPE_STRING;
+	case DURATION: return G_TYPE_INT;
+	}
+	return G_TYPE_INVALID;
+}
+
+void PlaylistModel::get_value_vfunc(
+	const iterator &iter, const int column, Glib::ValueBase &value
+) const {
+	if (!this->is_valid(iter)) { return; }
+	
+	const size_t row = iter_to_index(iter);
+	value.init(this->get_column_type_vfunc(column));
+	switch (column)
+	{
+	case MARKED:
+		g_value_set_uint(value.gobj(), m_marked[row]);
+		break;
+	case NAME:
+		g_value_set_string(value.gobj(), this->get_name(row));
+		break;
+	case DURATION:
+		g_value_set_int(value.gobj(), m_durations[row]);
+		break;
+	}
+}
+
+bool PlaylistModel::iter_next_vfunc(const iterator &iter, iterator &iterNext) const
+{
+	if (!this->is_valid(iter)) {
+		return this->set_iter(iterNext, SIZE_MAX);
+	}
+	return this->set_iter(iterNext, iter_to_index(iter) + 1);
+}
+
+bool PlaylistModel::iter_children_vfunc(const iterator&, iterator &iter) const
+{
+	return this->set_iter(iter, SIZE_MAX); // rows never have children
+}
+
+bool PlaylistModel::iter_has_child_vfunc(const iterator&) const
+{
+	return false;
+}
+
+int PlaylistModel::iter_n_children_vfunc(const iterator&) const
+{
+	return 0;
+}
+
+int PlaylistModel::iter_n_root_children_vfunc(void) const
+{
+	return static_cast<int>(this->size());
+}
+
+bool PlaylistModel::iter_nth_child_vfunc(const iterator&, int, iterator &iter) const
+{
+	return this->set_iter(iter, SIZE_MAX);
+}
+
+bool PlaylistModel::iter_nth_root_child_vfunc(const int n, iterator &iter) const
+{
+	return this->set_iter(iter, n < 0 ? SIZE_MAX : static_cast<size_t>(n));
+}
+
+bool PlaylistModel::iter_parent_vfunc(const iterator&, iterator &iter) const
+{
+	return this->set_iter(iter, SIZE_MAX);
+}
+
+Gtk::TreeModel::Path PlaylistModel::get_path_vfunc(const iterator &iter) const
+{
+	if (!this->is_valid(iter)) { return Path(); }
+	return Path(1, static_cast<int>(iter_to_index(iter)));
+}
+
+bool PlaylistModel::get_iter_vfunc(const Path &path, iterator &iter) const
+{
+	if (path.size() != 1 || path[0] < 0) {
+		return this->set_iter(iter, SIZE_MAX);
+	}
+	return this->set_iter(iter, static_cast<size_t>(path[0]));
+}
+
+
+
+// private
+// ==================================================
+
+bool PlaylistModel::name_fits(const size_t size) const
+{
+	// the offset of the name after it must fit too, past its NUL
+	return size < UINT32_MAX && m_names.size() < UINT32_MAX - size;
+}
+
+bool PlaylistModel::push_row(const NotebookRowData &data)
+{
+	const std::string &name = data.mediaName.raw();
+	if (!this->name_fits(name.size())) {
+		SPDLOG_ERROR("No room left for the name of row {:d}: '{:s}'", this->size(), name);
+		return false;
+	}
+	
+	m_marked.push_back(static_cast<uint8_t>(NotebookColBit::None));
+	m_nameOffsets.push_back(static_cast<uint32_t>(m_names.size()));
+	m_durations.push_back(duration_to_storage(data.mediaDuration));
+	
+	m_names.insert(m_names.end(), name.begin(), name.end());
+	m_names.push_back('\0');
+	return true;
+}
+
+bool PlaylistModel::set_iter(iterator &iter, const size_t row) const
+{
+	GtkTreeIter *const raw = iter.gobj();
+	if (row >= this->size()) {
+		iter.set_stamp(0);
+		raw->user_data = nullptr;
+		return false;
+	}
+	
+	iter.set_stamp(m_stamp);
+	raw->user_data = GSIZE_TO_POINTER(row);
+	raw->user_data2 = nullptr;
+	raw->user_data3 = nullptr;
+	return true;
+}
+
+bool PlaylistModel::is_valid(const iterator &iter) const
+{
+	return iter.get_stamp() == m_stamp && iter_to_index(iter) < this->size();
+}
+
+void PlaylistModel::emit_row_changed(const size_t row)
+{
+	this->row_changed(Path(1, static_cast<int>(row)), this->index_to_iter(row));
+}
+
+}
@@ -1,24 +1,25 @@
-#include <gtkmm/liststore.h>
-#include <momuma/bitset.h>
+#include <glibmm/main.h>
 #include <momuma/momuma.h>
 #include <momuma/spdlog.h>
 
 #include "Gui/PlaylistNotebook.h"
-#include "misc.h"
+#include "Gui/PlaylistTreeView.h"
 
 
 // Type of the container used inside a Gtk::Notebook page
 using Container = Gtk::ScrolledWindow;
 
+// approximate size of what a view keeps for each row, a node of its red-black tree
+constexpr size_t VIEW_ROW_BYTES = 64;
+
 namespace CreateManaged
 {
 
-/* #Creates an abstract `Gtk::Container` (e.g `Gtk::ScrolledWindow`).
-! The container has a PlaylistTreeView added directly to it.
-! @return: pointer to a dynamically allocated `Gtk::Container`, marked as managed.
+/* #Creates the container of a page, without a view.
+! @return: pointer to a dynamically allocated `Container`, marked as managed.
 */
 [[nodiscard]] static
-Gtk::Container* treeViewContainer(void);
+Container* pageContainer(void);
 
 /* #Creates a managed `Gtk::Label`.
 ! Use as a convenience function for creating a `Gtk::Label` that can use Pango attributes.
@@ -40,146 +41,18 @@ Gtk::Label* pangoLabel(const Glib::ustring &text, Pango::AttrList &attributes)
 }
 
 [[nodiscard]] static inline
-std::vector<int> path_to_indices(Gtk::TreePath path)
+int path_to_line_index(const Gtk::TreePath &path)
 {
 	gint len = 0;
-	const gint *indices = gtk_tree_path_get_indices_with_depth(path.gobj(), &len);
-	assert(indices != nullptr);
-	return std::vector<int>(&indices[0], &indices[len]);
-}
-
-[[nodiscard]] static inline
-int path_to_line_index(Gtk::TreePath path)
-{
-	const std::vector<int> indices = path_to_indices(std::move(path));
-	assert(indices.size() == 1);
-	return indices.at(0);
-}
-
-[[nodiscard]] static
-Gtk::TreeRow row_from_ref(Gtk::TreeRowReference &ref)
-{
-	return *ref.get_model()->get_iter(ref.get_path());
+	const gint *indices = gtk_tree_path_get_indices_with_depth(
+		const_cast<GtkTreePath*>(path.gobj()), &len
+	);
+	assert(indices != nullptr && len == 1);
+	return indices[0];
 }
 
 
 
-class ColumnRecord : public Gtk::TreeModel::ColumnRecord
-{
-public:
-	[[nodiscard]] static inline
-	const ColumnRecord& get(void)
-	{
-		static const ColumnRecord instance;
-		return instance;
-	}
-	
-	Gtk::TreeModelColumn<Gui::NotebookColBit> markedColumns;
-	Gtk::TreeModelColumn<Glib::ustring> name;
-	Gtk::TreeModelColumn<chrono::seconds> duration;
-	
-private:
-	ColumnRecord(void)
-	{
-		this->add(markedColumns);
-		this->add(name);
-		this->add(duration);
-	}
-};
-
-class PlaylistTreeView : public Gtk::TreeView
-{
-public:
-	PlaylistTreeView(void) :
-		Gtk::TreeView { Gtk::ListStore::create(ColumnRecord::get()) }
-	{
-		this->set_headers_visible(false);
-		this->set_grid_lines(Gtk::TREE_VIEW_GRID_LINES_NONE);
-		Gtk::TreeViewColumn *column = nullptr;
-		Gtk::CellRendererText *cell = nullptr;
-		
-		column = Gtk::make_managed<Gtk::TreeViewColumn>();
-		cell = Gtk::make_managed<Gtk::CellRendererText>();
-		this->column_pack_start(*column, *cell, &this->cb__render_line);
-		this->append_column(*column);
-		
-		column = Gtk::make_managed<Gtk::TreeViewColumn>();
-		cell = Gtk::make_managed<Gtk::CellRendererText>();
-		this->column_pack_start(*column, *cell, &this->cb__render_name);
-		this->append_column(*column);
-		
-		column = Gtk::make_managed<Gtk::TreeViewColumn>();
-		cell = Gtk::make_managed<Gtk::CellRendererText>();
-		this->column_pack_start(*column, *cell, &this->cb__render_duration);
-		this->append_column(*column);
-	}
-	
-private:
-	using ColumnBit = Gui::NotebookColBit;
-	
-	[[nodiscard]] static inline
-	Pango::AttrList attributes_for_cell(const Gtk::TreeIter &iter, ColumnBit column)
-	{
-		const ColumnBit marked = iter->get_value(ColumnRecord::get().markedColumns);
-		
-		Pango::AttrList attrs;
-		if (Momuma::Bitset(marked).contains(column)) {
-			Pango::AttrInt attr = Pango::Attribute::create_attr_weight(Pango::WEIGHT_HEAVY);
-			attrs.insert(attr);
-		}
-		return attrs;
-	}
-	
-	static inline void column_pack_start(
-		Gtk::TreeViewColumn &column, Gtk::CellRenderer &renderer,
-		Gtk::TreeViewColumn::SlotTreeCellData dataFunc
-	) {
-		column.pack_start(renderer, true);
-		column.set_cell_data_func(renderer, dataFunc);
-	}
-	
-	static void cb__render_line(
-		Gtk::CellRenderer *const cellRenderer, const Gtk::TreeIter &iter
-	) {
-		if (!iter) { SPDLOG_CRITICAL("{} iter is not valid!", SPDLOG_FUNCTION); return; }
-		auto &renderer = *dynamic_cast<Gtk::CellRendererText*>(cellRenderer);
-		
-		const Pango::AttrList attrs = attributes_for_cell(iter, ColumnBit::LINE);
-		renderer.property_attributes().set_value(attrs);
-		
-		const int line = path_to_line_index(Gtk::TreePath(iter)) + 1;
-		renderer.property_text().set_value(std::to_string(line));
-	}
-	
-	static void cb__render_name(
-		Gtk::CellRenderer *const cellRenderer, const Gtk::TreeIter &iter
-	) {
-		if (!iter) { SPDLOG_CRITICAL("{} iter is not valid!", SPDLOG_FUNCTION); return; }
-		auto &renderer = *dynamic_cast<Gtk::CellRendererText*>(cellRenderer);
-		
-		const Pango::AttrList attrs = attributes_for_cell(iter, ColumnBit::NAME);
-		renderer.property_attributes().set_value(attrs);
-		
-		renderer.property_text().set_value(iter->get_value(ColumnRecord::get().name));
-	}
-	
-	static void cb__render_duration(
-		Gtk::CellRenderer *const cellRenderer, const Gtk::TreeIter &iter
-	) {
-		if (!iter) { SPDLOG_CRITICAL("{} iter is not valid!", SPDLOG_FUNCTION); return; }
-		auto &renderer = *dynamic_cast<Gtk::CellRendererText*>(cellRenderer);
-		
-		const Pango::AttrList attrs = attributes_for_cell(iter, ColumnBit::DURATION);
-		renderer.property_attributes().set_value(attrs);
-		
-		// get the value from the model and show it aligned in the view
-		const chrono::seconds val = iter->get_value(ColumnRecord::get().duration);
-		renderer.property_text().set_value("    " + Utils::time_to_ui_string(val));
-	}
-};
-
-
-
 namespace Gui
 {
 
@@ -199,14 +72,39 @@ PageId _container_to_page_id(const Container *container)
 	return static_cast<PageId>(reinterpret_cast<std::uintptr_t>(container));
 }
 
+// Returns `nullptr` when the page is a placeholder
+[[nodiscard]] static
+PlaylistTreeView* _container_find_view(const Container &container)
+{
+	return dynamic_cast<PlaylistTreeView*>(const_cast<Gtk::Widget*>(container.get_child()));
+}
+
+// Returns `nullptr` when the page is a placeholder
 [[nodiscard]] static
-Gtk::TreeView& _container_to_tree_view(Container &container)
+PlaylistModel* _container_find_model(const Container &container)
 {
-	auto *x = dynamic_cast<Gtk::TreeView*>(container.get_child());
+	PlaylistTreeView *const x = _container_find_view(container);
+	return x == nullptr ? nullptr : &x->get_playlist_model();
+}
+
+[[nodiscard]] static
+PlaylistModel& _container_to_model(Container &container)
+{
+	PlaylistModel *const x = _container_find_model(container);
 	assert(x != nullptr);
 	return *x;
 }
 
+// Returns a null pointer when the page is a placeholder
+[[nodiscard]] static
+Glib::RefPtr<PlaylistModel> _container_to_model_ref(Container &container)
+{
+	PlaylistModel *const model = _container_find_model(container);
+	if (model == nullptr) { return Glib::RefPtr<PlaylistModel>(); }
+	model->reference();
+	return Glib::RefPtr<PlaylistModel>(model);
+}
+
 
 
 // PlaylistNotebook - public
@@ -216,11 +114,20 @@ void PlaylistNotebook::reset_widget_text(void)
 {
 }
 
-PlaylistNotebook::PlaylistNotebook(void)
+PlaylistNotebook::PlaylistNotebook(void) :
+	m_closing { }, m_teardown { }
 {
 	this->initialize_gui();
 }
 
+PlaylistNotebook::~PlaylistNotebook(void)
+{
+	m_teardown.disconnect();
+	for (const Closing &closing : m_closing) {
+		closing.widget->unreference();
+	}
+}
+
 int PlaylistNotebook::size(void)
 {
 	return w_.get_n_pages();
@@ -241,6 +148,43 @@ PageId PlaylistNotebook::current_page_id(void) const
 	return _container_to_page_id(this->current_page_get_container());
 }
 
+std::vector<PageId> PlaylistNotebook::page_ids(void) const
+{
+	std::vector<PageId> ids;
+	ids.reserve(static_cast<size_t>(w_.get_n_pages()));
+	for (int i = 0; i < w_.get_n_pages(); ++i) {
+		const auto *const container = dynamic_cast<const Container*>(w_.get_nth_page(i));
+		ids.push_back(_container_to_page_id(container));
+	}
+	return ids;
+}
+
+bool PlaylistNotebook::has_page(const PageId page) const
+{
+	// the ids are compared, a removed page's container may not exist anymore
+	for (int i = 0; i < w_.get_n_pages(); ++i) {
+		const auto *const container = dynamic_cast<const Container*>(w_.get_nth_page(i));
+		if (_container_to_page_id(container) == page) { return true; }
+	}
+	return false;
+}
+
+void PlaylistNotebook::page_focus(const PageId page)
+{
+	Container *const container = _container_from_page_id(page);
+	assert(container != nullptr);
+	
+	w_.set_current_page(w_.page_num(*container));
+}
+
+void PlaylistNotebook::page_move(const PageId page, const size_t position)
+{
+	Container *const container = _container_from_page_id(page);
+	assert(container != nullptr);
+	
+	w_.reorder_child(*container, static_cast<int>(position));
+}
+
 void PlaylistNotebook::page_focus_right(void)
 {
 	const int i = w_.get_current_page() + 1;
@@ -263,36 +207,117 @@ void PlaylistNotebook::page_focus_left(void)
 
 PageId PlaylistNotebook::page_create(const Glib::ustring &title, Pango::AttrList &titleAttributes)
 {
-	auto *container = dynamic_cast<Container*>(CreateManaged::treeViewContainer());
-	assert(container != nullptr);
+	Container *const container = CreateManaged::pageContainer();
+	const PageId id = _container_to_page_id(container);
+	// before the page is inserted, which may already show it
+	this->page_create_view(id);
+	this->insert_page(*container, title, titleAttributes);
+	w_.next_page();
 	
-	PageId id = _container_to_page_id(container);
-	{
-		const int pos = w_.get_current_page() + 1;
-		auto &label = *CreateManaged::pangoLabel(title, titleAttributes);
-		w_.insert_page(*container, label, pos);
-		w_.set_tab_reorderable(*container, true);
-		w_.next_page();
-		
-		Gtk::TreeView &treeView = _container_to_tree_view(*container);
-		treeView.set_activate_on_single_click(false);
-		treeView.signal_row_activated().connect_notify(
-			sigc::bind(sigc::mem_fun(*this, &PlaylistNotebook::cb__row_activated), id)
-		);
-	}
+	m_signal_pageCreated.emit(id);
+	return id;
+}
+
+PageId PlaylistNotebook::page_create_placeholder(const Glib::ustring &title,
+	Pango::AttrList &titleAttributes
+) {
+	Container *const container = CreateManaged::pageContainer();
+	const PageId id = _container_to_page_id(container);
+	this->insert_page(*container, title, titleAttributes);
 	
 	m_signal_pageCreated.emit(id);
 	return id;
 }
 
+bool PlaylistNotebook::page_has_view(const PageId page) const
+{
+	const Container *const container = _container_from_page_id(page);
+	assert(container != nullptr);
+	
+	return _container_find_view(*container) != nullptr;
+}
+
+void PlaylistNotebook::page_create_view(const PageId page)
+{
+	Container *const container = _container_from_page_id(page);
+	assert(container != nullptr);
+	if (_container_find_view(*container) != nullptr) { return; }
+	
+	auto &view = *Gtk::make_managed<PlaylistTreeView>();
+	view.set_activate_on_single_click(false);
+	view.signal_row_activated().connect_notify(
+		sigc::bind(sigc::mem_fun(*this, &PlaylistNotebook::cb__row_activated), page)
+	);
+	container->add(view);
+	view.show();
+}
+
+PageViewState PlaylistNotebook::page_get_view_state(const PageId page) const
+{
+	const Container *const container = _container_from_page_id(page);
+	assert(container != nullptr);
+	PlaylistTreeView *const view = _container_find_view(*container);
+	if (view == nullptr) { return PageViewState(); }
+	
+	PageViewState state;
+	Gtk::TreePath first, last;
+	if (view->get_visible_range(first, last)) {
+		state.topRow = static_cast<size_t>(path_to_line_index(first));
+	}
+	for (const Gtk::TreePath &path : view->get_selection()->get_selected_rows()) {
+		state.selectedRows.push_back(static_cast<size_t>(path_to_line_index(path)));
+	}
+	return state;
+}
+
+PageViewState PlaylistNotebook::page_drop_view(const PageId page)
+{
+	Container *const container = _container_from_page_id(page);
+	assert(container != nullptr);
+	PlaylistTreeView *const view = _container_find_view(*container);
+	if (view == nullptr) { return PageViewState(); }
+	
+	const PageViewState state = this->page_get_view_state(page);
+	// the rows are released in the background like those of a removed page
+	view->reference();
+	Glib::RefPtr<PlaylistModel> model = _container_to_model_ref(*container);
+	container->remove();
+	this->close_later({ view, std::move(model), PageId::Null });
+	return state;
+}
+
+void PlaylistNotebook::page_restore_view_state(const PageId page, const PageViewState &state)
+{
+	Container *const container = _container_from_page_id(page);
+	assert(container != nullptr);
+	PlaylistTreeView *const view = _container_find_view(*container);
+	if (view == nullptr) { return; }
+	
+	const size_t size = view->get_playlist_model().size();
+	const Glib::RefPtr<Gtk::TreeSelection> selection = view->get_selection();
+	selection->unselect_all();
+	for (const size_t row : state.selectedRows) {
+		if (row >= size) { continue; }
+		selection->select(Gtk::TreePath(1, static_cast<int>(row)));
+	}
+	
+	if (state.topRow.has_value() && state.topRow.value() < size) {
+		// delayed by GTK until the view is allocated, when it isn't yet
+		view->scroll_to_row(Gtk::TreePath(1, static_cast<int>(state.topRow.value())), 0.0F);
+	}
+}
+
 void PlaylistNotebook::page_remove(const PageId page)
 {
 	Container *const container = _container_from_page_id(page);
 	assert(container != nullptr);
 	
 	m_signal_pageRemove.emit(page);
+	// destroying a large page takes a while, the notebook only lets go of it
+	container->reference();
+	Glib::RefPtr<PlaylistModel> model = _container_to_model_ref(*container);
 	w_.remove_page(*container);
-	m_signal_pageDestroyed.emit(page);
+	this->close_later({ container, std::move(model), page });
 }
 
 void PlaylistNotebook::page_rename(const PageId page,
@@ -320,7 +345,18 @@ auto PlaylistNotebook::signal_page_destroyed(void) -> sigc::signal<void(PageId)>
 	return m_signal_pageDestroyed;
 }
 
-auto PlaylistNotebook::signal_row_activated(void) -> sigc::signal<void(PageId, int, NotebookRowProxy)>
+auto PlaylistNotebook::signal_page_focused(void) -> sigc::signal<void(PageId)>
+{
+	return m_signal_pageFocused;
+}
+
+auto PlaylistNotebook::signal_page_reordered(void) -> sigc::signal<void(PageId, size_t)>
+{
+	return m_signal_pageReordered;
+}
+
+auto PlaylistNotebook::signal_row_activated(void)
+	-> sigc::signal<void(PageId, int, NotebookRowProxy)>
 {
 	return m_signal_rowActivated;
 }
@@ -333,15 +369,74 @@ auto PlaylistNotebook::signal_row_activated(void) -> sigc::signal<void(PageId, i
 void PlaylistNotebook::initialize_gui(void)
 {
 	w_.set_scrollable(true);
+	w_.signal_switch_page().connect(
+		[this](Gtk::Widget *page, guint) -> void
+		{
+			const auto *const container = dynamic_cast<Container*>(page);
+			m_signal_pageFocused.emit(_container_to_page_id(container));
+		}
+	);
+	w_.signal_page_reordered().connect(
+		[this](Gtk::Widget *page, const guint position) -> void
+		{
+			const auto *const container = dynamic_cast<Container*>(page);
+			m_signal_pageReordered.emit(_container_to_page_id(container), position);
+		}
+	);
 	w_.show_all_children(true);
 }
 
+void PlaylistNotebook::insert_page(Container &container,
+	const Glib::ustring &title, Pango::AttrList &titleAttributes
+) {
+	const int pos = w_.get_current_page() + 1;
+	auto &label = *CreateManaged::pangoLabel(title, titleAttributes);
+	w_.insert_page(container, label, pos);
+	w_.set_tab_reorderable(container, true);
+}
+
+void PlaylistNotebook::close_later(Closing &&closing)
+{
+	m_closing.push_back(std::move(closing));
+	if (!m_teardown.connected()) {
+		m_teardown = Glib::signal_idle().connect(
+			sigc::mem_fun(*this, &PlaylistNotebook::cb__teardown), Glib::PRIORITY_LOW
+		);
+	}
+}
+
+bool PlaylistNotebook::cb__teardown(void)
+{
+	const auto deadline = chrono::steady_clock::now() + TEARDOWN_BUDGET;
+	while (!m_closing.empty()) {
+		Closing &closing = m_closing.front();
+		if (closing.model) {
+			// the view stays attached and drops the rows one by one, detaching it
+			// from a large model would free all of them at once
+			const size_t size = closing.model->size();
+			closing.model->truncate(size - std::min(size, TEARDOWN_ROWS));
+		}
+		
+		if (!closing.model || closing.model->empty()) {
+			Gtk::Widget *const widget = closing.widget;
+			const PageId page = closing.page;
+			m_closing.pop_front();
+			// the last reference, destroys the widgets and the model
+			widget->unreference();
+			if (page != PageId::Null) { m_signal_pageDestroyed.emit(page); }
+		}
+		
+		if (chrono::steady_clock::now() >= deadline) { break; }
+	}
+	return !m_closing.empty();
+}
+
 void PlaylistNotebook::cb__row_activated(
-	const Gtk::TreePath &pathToRow, Gtk::TreeView::Column *tvc, PageId id
+	const Gtk::TreePath &pathToRow, Gtk::TreeView::Column* /*tvc*/, PageId id
 ) {
-	m_signal_rowActivated.emit(id,
-		path_to_line_index(pathToRow),
-		NotebookRowProxy(tvc->get_tree_view()->get_model(), pathToRow)
+	const int rowIndex = path_to_line_index(pathToRow);
+	m_signal_rowActivated.emit(id, rowIndex,
+		NotebookRowProxy(*this, id, static_cast<size_t>(rowIndex))
 	);
 }
 
@@ -377,9 +472,8 @@ size_t NotebookPageProxy::size(void) const
 	auto *const container = _container_from_page_id(_id);
 	assert(container != nullptr);
 	
-	Gtk::TreeView &treeView = _container_to_tree_view(*container);
-	Glib::RefPtr listStore = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeView.get_model());
-	return listStore->children().size();
+	const PlaylistModel *const model = _container_find_model(*container);
+	return model == nullptr ? 0 : model->size();
 }
 
 bool NotebookPageProxy::empty(void) const
@@ -387,9 +481,18 @@ bool NotebookPageProxy::empty(void) const
 	auto *const container = _container_from_page_id(_id);
 	assert(container != nullptr);
 	
-	Gtk::TreeView &treeView = _container_to_tree_view(*container);
-	Glib::RefPtr listStore = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeView.get_model());
-	return listStore->children().empty();
+	const PlaylistModel *const model = _container_find_model(*container);
+	return model == nullptr || model->empty();
+}
+
+size_t NotebookPageProxy::memory_usage(void) const
+{
+	auto *const container = _container_from_page_id(_id);
+	assert(container != nullptr);
+	
+	const PlaylistModel *const model = _container_find_model(*container);
+	if (model == nullptr) { return 0; }
+	return model->memory_usage() + model->size() * VIEW_ROW_BYTES;
 }
 
 Glib::ustring NotebookPageProxy::get_name(void) const
@@ -413,12 +516,48 @@ void NotebookPageProxy::append_row(const NotebookRowData &data) const
 	auto *const container = _container_from_page_id(_id);
 	assert(container != nullptr);
 	
-	Gtk::TreeView &treeView = _container_to_tree_view(*container);
-	Glib::RefPtr listStore = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeView.get_model());
-	Gtk::TreeRow row = *listStore->append();
+	_container_to_model(*container).append(data);
+}
+
+void NotebookPageProxy::append_rows(const std::span<const NotebookRowData> rows) const
+{
+	auto *const container = _container_from_page_id(_id);
+	assert(container != nullptr);
+	
+	_container_to_model(*container).append(rows);
+}
+
+void NotebookPageProxy::extend_rows(const std::span<const NotebookRowData> rows) const
+{
+	auto *const container = _container_from_page_id(_id);
+	assert(container != nullptr);
 	
-	row[ColumnRecord::get().name] = data.mediaName;
-	row[ColumnRecord::get().duration] = data.mediaDuration;
+	_container_to_model(*container).extend(rows);
+}
+
+void NotebookPageProxy::clear(void) const
+{
+	auto *const container = _container_from_page_id(_id);
+	assert(container != nullptr);
+	
+	_container_to_model(*container).clear();
+}
+
+void NotebookPageProxy::set_durations(
+	const std::vector<std::pair<size_t, chrono::seconds>> &durations
+) const {
+	auto *const container = _container_from_page_id(_id);
+	assert(container != nullptr);
+	
+	// a placeholder has no rows to update
+	PlaylistModel *const model = _container_find_model(*container);
+	if (model == nullptr) { return; }
+	const size_t size = model->size();
+	
+	for (const auto &[index, duration] : durations) {
+		if (index >= size) { continue; }
+		model->set_duration(index, duration);
+	}
 }
 
 void NotebookPageProxy::foreach_row(
@@ -426,44 +565,60 @@ void NotebookPageProxy::foreach_row(
 ) const {
 	auto *const container = _container_from_page_id(_id);
 	assert(container != nullptr);
-	Gtk::TreeView &treeView = _container_to_tree_view(*container);
 	
-	const Glib::RefPtr<Gtk::TreeModel> model = treeView.get_model();
-	const Gtk::TreeModel::Children rows = model->children();
+	const Glib::RefPtr<PlaylistModel> model = _container_to_model_ref(*container);
+	if (!model) { return; }
+	const size_t size = model->size();
 	
-	int lineIndex = 0;
-	Gtk::TreeIter iter = rows.begin();
-	for (const auto end = rows.end(); iter != end; ++iter, ++lineIndex) {
-		const IterFlag res = callback(
-			lineIndex, NotebookRowProxy(model, Gtk::TreePath(iter))
+	for (size_t lineIndex = 0; lineIndex < size; ++lineIndex) {
+		const IterFlag res = callback(static_cast<long>(lineIndex),
+			NotebookRowProxy(_parent, _id, lineIndex)
 		);
 		if (res == IterFlag::STOP) { break; }
 	}
 }
 
+void NotebookPageProxy::read_rows(const size_t first, const size_t count,
+	const sigc::slot<void(size_t row, const char *name, chrono::seconds)> &callback
+) const {
+	auto *const container = _container_from_page_id(_id);
+	assert(container != nullptr);
+	
+	const PlaylistModel *const model = _container_find_model(*container);
+	if (model == nullptr) { return; }
+	
+	const size_t end = std::min(first + count, model->size());
+	for (size_t row = first; row < end; ++row) {
+		callback(row, model->get_name(row), model->get_duration(row));
+	}
+}
+
 std::vector<NotebookRowProxy> NotebookPageProxy::get_rows(long firstLine, long lineCount) const
 {
 	assert(firstLine >= 0);
 	if (lineCount <= 0) { return {}; }
 	
+	auto *const container = _container_from_page_id(_id);
+	assert(container != nullptr);
+	const PlaylistModel *const model = _container_find_model(*container);
+	if (model == nullptr) { return {}; }
+	
+	const size_t first = std::min(static_cast<size_t>(firstLine), model->size());
+	const size_t end = first + std::min(model->size() - first, static_cast<size_t>(lineCount));
+	
 	std::vector<NotebookRowProxy> list;
-	list.reserve(std::min(this->size(), static_cast<decltype(this->size())>(lineCount)));
-	this->foreach_row(
-		[&](const long lineIndex, NotebookRowProxy row) -> IterFlag
-		{
-			if (list.size() == static_cast<size_t>(lineCount)) {
-				return IterFlag::STOP;
-			}
-			
-			if (lineIndex >= firstLine) {
-				list.push_back(std::move(row));
-			}
-			return IterFlag::NEXT;
-		}
-	);
+	list.reserve(end - first);
+	for (size_t row = first; row < end; ++row) {
+		list.emplace_back(_parent, _id, row);
+	}
 	return list;
 }
 
+NotebookRowProxy NotebookPageProxy::row_at(const size_t index) const
+{
+	return NotebookRowProxy(_parent, _id, index);
+}
+
 void NotebookPageProxy::mark_rows(NotebookColBit column) const
 {
 	this->foreach_row(
@@ -475,42 +630,100 @@ void NotebookPageProxy::mark_rows(NotebookColBit column) const
 	);
 }
 
+void NotebookPageProxy::set_playing_row(const std::optional<size_t> row) const
+{
+	auto *const container = _container_from_page_id(_id);
+	assert(container != nullptr);
+	
+	PlaylistModel *const model = _container_find_model(*container);
+	if (model == nullptr) { return; }
+	model->set_playing_row(row);
+}
+
+std::optional<size_t> NotebookPageProxy::get_playing_row(void) const
+{
+	auto *const container = _container_from_page_id(_id);
+	assert(container != nullptr);
+	
+	const PlaylistModel *const model = _container_find_model(*container);
+	return model == nullptr ? std::nullopt : model->get_playing_row();
+}
+
 
 
 // NotebookRowProxy
 // ==================================================
 
+NotebookRowProxy::NotebookRowProxy(const PlaylistNotebook &notebook, const PageId page,
+	const size_t row
+) :
+	_page { page }, _row { row }, d_notebook { &notebook }, m_generation { 0 }
+{
+	auto *const container = _container_from_page_id(_page);
+	assert(container != nullptr);
+	
+	const PlaylistModel *const model = _container_find_model(*container);
+	if (model != nullptr) { m_generation = model->generation(); }
+}
+
+bool NotebookRowProxy::is_valid(void) const
+{
+	return this->resolve() != nullptr;
+}
+
 void NotebookRowProxy::toggle_marked(const NotebookColBit column)
 {
-	const Gtk::TreeRow row = row_from_ref(_ref);
-	Gtk::TreeValueProxy proxy = row[ColumnRecord::get().markedColumns];
-	proxy = proxy | column;
+	PlaylistModel *const model = this->resolve();
+	if (model == nullptr) { return; }
+	model->set_marked(_row, model->get_marked(_row) | column);
 }
 NotebookColBit NotebookRowProxy::get_marked(void)
 {
-	return row_from_ref(_ref).get_value(ColumnRecord::get().markedColumns);
+	const PlaylistModel *const model = this->resolve();
+	return model == nullptr ? NotebookColBit::None : model->get_marked(_row);
 }
 void NotebookRowProxy::set_marked(const NotebookColBit column)
 {
-	row_from_ref(_ref).set_value(ColumnRecord::get().markedColumns, column);
+	PlaylistModel *const model = this->resolve();
+	if (model == nullptr) { return; }
+	model->set_marked(_row, column);
 }
 
 Glib::ustring NotebookRowProxy::get_name(void)
 {
-	return row_from_ref(_ref).get_value(ColumnRecord::get().name);
+	const PlaylistModel *const model = this->resolve();
+	return model == nullptr ? Glib::ustring() : Glib::ustring(model->get_name(_row));
 }
 void NotebookRowProxy::set_name(const Glib::ustring &name)
 {
-	row_from_ref(_ref).set_value(ColumnRecord::get().name, name);
+	PlaylistModel *const model = this->resolve();
+	if (model == nullptr) { return; }
+	model->set_name(_row, name);
 }
 
 chrono::seconds NotebookRowProxy::get_duration(void)
 {
-	return row_from_ref(_ref).get_value(ColumnRecord::get().duration);
+	const PlaylistModel *const model = this->resolve();
+	return model == nullptr ? NotebookRowData::UNKNOWN_DURATION : model->get_duration(_row);
 }
 void NotebookRowProxy::set_duration(const chrono::seconds duration)
 {
-	row_from_ref(_ref).set_value(ColumnRecord::get().duration, duration);
+	PlaylistModel *const model = this->resolve();
+	if (model == nullptr) { return; }
+	model->set_duration(_row, duration);
+}
+
+PlaylistModel* NotebookRowProxy::resolve(void) const
+{
+	// the container of a closed page may be gone
+	if (!d_notebook->has_page(_page)) { return nullptr; }
+	auto *const container = _container_from_page_id(_page);
+	
+	PlaylistModel *const model = _container_find_model(*container);
+	if (model == nullptr || model->generation() != m_generation || _row >= model->size()) {
+		return nullptr;
+	}
+	return model;
 }
 
 }
@@ -520,11 +733,10 @@ void NotebookRowProxy::set_duration(const chrono::seconds duration)
 namespace CreateManaged
 {
 
-Gtk::Container* treeViewContainer(void)
+Container* pageContainer(void)
 {
-	auto *wnd = Gtk::make_managed<Gtk::ScrolledWindow>();
-	wnd->add(*Gtk::make_managed<PlaylistTreeView>());
-	wnd->show_all();
+	auto *wnd = Gtk::make_managed<Container>();
+	wnd->show();
 	return wnd;
 }
 
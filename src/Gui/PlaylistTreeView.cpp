@@ -0,0 +1,233 @@
+#include <charconv>
+#include <momuma/bitset.h>
+#include <momuma/sigc.h>
+#include <momuma/spdlog.h>
+#include <pangomm/attrlist.h>
+
+#include "Gui/PlaylistTreeView.h"
+#include "Trace.h"
+#include "misc.h"
+
+
+// Attribute lists shared by every cell, built once
+[[nodiscard]] static
+PangoAttrList* heavy_attributes(void)
+{
+	static const Pango::AttrList attrs = Utils::create_attr_list({
+		Pango::Attribute::create_attr_weight(Pango::WEIGHT_HEAVY)
+	});
+	return const_cast<PangoAttrList*>(attrs.gobj());
+}
+
+[[nodiscard]] static
+PangoAttrList* normal_attributes(void)
+{
+	static const Pango::AttrList attrs;
+	return const_cast<PangoAttrList*>(attrs.gobj());
+}
+
+/* #Set a property without copying `value`.
+! `g_object_set()` copies boxed types while collecting its arguments, this hands the renderer
+the value itself and lets it take its own reference (or copy, for strings).
+*/
+static void set_static_property(GObject *object, const char *name, const char *value)
+{
+	GValue v = G_VALUE_INIT;
+	g_value_init(&v, G_TYPE_STRING);
+	g_value_set_static_string(&v, value);
+	g_object_set_property(object, name, &v);
+	g_value_unset(&v);
+}
+
+static void set_static_property(GObject *object, const char *name, PangoAttrList *value)
+{
+	GValue v = G_VALUE_INIT;
+	g_value_init(&v, PANGO_TYPE_ATTR_LIST);
+	g_value_set_static_boxed(&v, value);
+	g_object_set_property(object, name, &v);
+	g_value_unset(&v);
+}
+
+
+namespace Gui
+{
+
+// public
+// ==================================================
+
+PlaylistTreeView::PlaylistTreeView(void) :
+	m_model { Model::create() }
+{
+	this->set_model(m_model);
+	m_model->signal_reset().connect(sigc::mem_fun(*this, &PlaylistTreeView::cb__model_reset));
+	
+	this->set_headers_visible(false);
+	this->set_grid_lines(Gtk::TREE_VIEW_GRID_LINES_NONE);
+	
+	m_line = this->append_cell_column(&PlaylistTreeView::cb__render_line);
+	m_name = this->append_cell_column(&PlaylistTreeView::cb__render_name);
+	m_duration = this->append_cell_column(&PlaylistTreeView::cb__render_duration);
+	
+	// every row has the same height, so GTK doesn't measure rows as they're inserted
+	m_line.column->set_fixed_width(this->text_width(m_line, "0000000"));
+	m_name.column->set_fixed_width(this->text_width(m_name, "Artist - Title"));
+	m_name.column->set_expand(true);
+	m_duration.column->set_fixed_width(this->text_width(m_duration, "    00:00:00"));
+	this->set_fixed_height_mode(true);
+}
+
+auto PlaylistTreeView::get_playlist_model(void) -> Model&
+{
+	return *m_model;
+}
+
+std::array<Gtk::TreeViewColumn*, 3> PlaylistTreeView::get_render_columns(void)
+{
+	return { m_line.column, m_name.column, m_duration.column };
+}
+
+
+
+// private
+// ==================================================
+
+void PlaylistTreeView::cb__model_reset(const Model::ResetPhase phase)
+{
+	// a detached view ignores the model, instead of reacting to every row changing
+	switch (phase)
+	{
+	case Model::ResetPhase::BEGIN:
+		this->save_reset_state();
+		this->unset_model();
+		break;
+	case Model::ResetPhase::END:
+		this->set_model(m_model);
+		this->restore_reset_state();
+		break;
+	}
+}
+
+void PlaylistTreeView::save_reset_state(void)
+{
+	m_resetState = PageViewState();
+	m_resetCursor.reset();
+	
+	Gtk::TreePath first, last;
+	if (this->get_visible_range(first, last)) {
+		m_resetState.topRow = static_cast<size_t>(first[0]);
+	}
+	for (const Gtk::TreePath &path : this->get_selection()->get_selected_rows()) {
+		m_resetState.selectedRows.push_back(static_cast<size_t>(path[0]));
+	}
+	Gtk::TreePath cursor;
+	Gtk::TreeViewColumn *column = nullptr;
+	this->get_cursor(cursor, column);
+	if (!cursor.empty()) {
+		m_resetCursor = static_cast<size_t>(cursor[0]);
+	}
+}
+
+void PlaylistTreeView::restore_reset_state(void)
+{
+	const size_t size = m_model->size();
+	const auto row_path = [](const size_t row) -> Gtk::TreePath
+	{
+		return Gtk::TreePath(1, static_cast<int>(row));
+	};
+	
+	// first, as moving the cursor selects its row
+	if (m_resetCursor.has_value() && m_resetCursor.value() < size) {
+		this->set_cursor(row_path(m_resetCursor.value()));
+	}
+	const Glib::RefPtr<Gtk::TreeSelection> selection = this->get_selection();
+	selection->unselect_all();
+	for (const size_t row : m_resetState.selectedRows) {
+		if (row < size) { selection->select(row_path(row)); }
+	}
+	if (m_resetState.topRow.has_value() && m_resetState.topRow.value() < size) {
+		// delayed by GTK until the view is allocated, when it isn't yet
+		this->scroll_to_row(row_path(m_resetState.topRow.value()), 0.0F);
+	}
+}
+
+void PlaylistTreeView::cb__render_line(Gtk::CellRenderer*, const Gtk::TreeIter &iter)
+{
+	TRACE_SPAN("PlaylistTreeView::cb__render_line");
+	if (!iter) { SPDLOG_CRITICAL("{} iter is not valid!", SPDLOG_FUNCTION); return; }
+	const size_t row = Model::iter_to_index(iter);
+	
+	char text[24];
+	const auto res = std::to_chars(text, text + sizeof(text) - 1, row + 1);
+	*res.ptr = '\0';
+	this->set_cell(m_line, text, row, ColumnBit::LINE);
+}
+
+void PlaylistTreeView::cb__render_name(Gtk::CellRenderer*, const Gtk::TreeIter &iter)
+{
+	TRACE_SPAN("PlaylistTreeView::cb__render_name");
+	if (!iter) { SPDLOG_CRITICAL("{} iter is not valid!", SPDLOG_FUNCTION); return; }
+	const size_t row = Model::iter_to_index(iter);
+	
+	this->set_cell(m_name, m_model->get_name(row), row, ColumnBit::NAME);
+}
+
+void PlaylistTreeView::cb__render_duration(Gtk::CellRenderer*, const Gtk::TreeIter &iter)
+{
+	TRACE_SPAN("PlaylistTreeView::cb__render_duration");
+	if (!iter) { SPDLOG_CRITICAL("{} iter is not valid!", SPDLOG_FUNCTION); return; }
+	const size_t row = Model::iter_to_index(iter);
+	
+	// show the duration aligned in the view
+	const chrono::seconds duration = m_model->get_duration(row);
+	if (duration == NotebookRowData::UNKNOWN_DURATION) {
+		this->set_cell(m_duration, "    --:--", row, ColumnBit::DURATION);
+		return;
+	}
+	
+	constexpr std::string_view PADDING = "    ";
+	char text[32];
+	PADDING.copy(text, PADDING.size());
+	(void)Utils::time_to_ui_string(duration,
+		std::span(text + PADDING.size(), sizeof(text) - PADDING.size())
+	);
+	this->set_cell(m_duration, text, row, ColumnBit::DURATION);
+}
+
+auto PlaylistTreeView::append_cell_column(
+	void (PlaylistTreeView::*dataFunc)(Gtk::CellRenderer*, const Gtk::TreeIter&)
+) -> CellColumn {
+	auto *column = Gtk::make_managed<Gtk::TreeViewColumn>();
+	auto *renderer = Gtk::make_managed<Gtk::CellRendererText>();
+	column->pack_start(*renderer, true);
+	column->set_sizing(Gtk::TREE_VIEW_COLUMN_FIXED);
+	column->set_cell_data_func(*renderer, sigc::mem_fun(*this, dataFunc));
+	this->append_column(*column);
+	return { column, renderer, nullptr };
+}
+
+int PlaylistTreeView::text_width(const CellColumn &cell, const char *text)
+{
+	int width = 0, height = 0;
+	this->create_pango_layout(text)->get_pixel_size(width, height);
+	
+	int xpad = 0, ypad = 0;
+	cell.renderer->get_padding(xpad, ypad);
+	return width + 2 * xpad;
+}
+
+void PlaylistTreeView::set_cell(
+	CellColumn &cell, const char *text, const size_t row, const ColumnBit column
+) const {
+	GObject *const object = static_cast<Glib::ObjectBase*>(cell.renderer)->gobj();
+	
+	const bool marked = Momuma::Bitset(m_model->get_marked(row)).contains(column);
+	PangoAttrList *const attrs = marked ? heavy_attributes() : normal_attributes();
+	// most rows aren't marked, so this rarely changes between two cells of a column
+	if (cell.attributes != attrs) {
+		set_static_property(object, "attributes", attrs);
+		cell.attributes = attrs;
+	}
+	set_static_property(object, "text", text);
+}
+
+}
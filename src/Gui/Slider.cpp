@@ -18,6 +18,9 @@ static double calc_scale_upper_limit(const double limit)
 	return std::max(limit, 0.01);
 }
 
+// how often the extrapolated position is corrected with the actual one
+constexpr chrono::seconds RESYNC_INTERVAL(1);
+
 static void set_scale_properties(Gtk::Scale &scale)
 {
 	scale.set_draw_value(false);
@@ -36,7 +39,10 @@ Slider::Slider(void) :
 	TopWidget { false, 5 },
 	_scale { Gtk::ORIENTATION_HORIZONTAL },
 	_mouseHover { _scale },
-	m_lastDragPhase { DragPhase::END }
+	m_lastDragPhase { DragPhase::END },
+	m_playbackSource { }, m_anchor { }, m_anchorTime { 0 },
+	m_shownSecond { -1 }, m_shownPixel { -1 }, m_tickId { 0 },
+	m_playing { false }, m_suspended { false }
 {
 	set_scale_properties(_scale);
 	this->sync_display_to_scale();
@@ -60,6 +66,35 @@ Slider::Slider(void) :
 	w_.pack_start(_timeDisplay, Gtk::PACK_SHRINK);
 }
 
+void Slider::set_playback_source(PlaybackSource source)
+{
+	m_playbackSource = std::move(source);
+	this->update_ticking();
+}
+
+void Slider::set_playing(const bool playing)
+{
+	m_playing = playing;
+	this->update_ticking();
+}
+
+void Slider::set_suspended(const bool suspended)
+{
+	m_suspended = suspended;
+	this->update_ticking();
+}
+
+void Slider::resync(void)
+{
+	const chrono::microseconds now(g_get_monotonic_time());
+	if (!this->resync_at(now)) {
+		m_anchorTime = now; // the time shown is extrapolated from there, not from long ago
+	}
+	// the scale may have been moved from outside, so it's always updated
+	m_shownSecond = m_shownPixel = -1;
+	this->show_time(m_anchor.position);
+}
+
 void Slider::set_time(chrono::milliseconds time)
 {
 	const chrono::duration<double> val(time);
@@ -96,6 +131,63 @@ void Slider::set_sensitive(bool sensitive)
 	}
 }
 
+void Slider::update_ticking(void)
+{
+	const bool tick = m_playing && !m_suspended && m_playbackSource;
+	if (tick && m_tickId == 0) {
+		this->resync();
+		m_tickId = _scale.add_tick_callback(sigc::mem_fun(*this, &Slider::cb__tick));
+	}
+	else if (!tick && m_tickId != 0) {
+		_scale.remove_tick_callback(m_tickId);
+		m_tickId = 0;
+	}
+}
+
+bool Slider::cb__tick(const Glib::RefPtr<Gdk::FrameClock> &clock)
+{
+	// the frame time is on the same clock as `g_get_monotonic_time()`
+	const chrono::microseconds now(clock->get_frame_time());
+	if (now - m_anchorTime >= RESYNC_INTERVAL && !this->resync_at(now)) {
+		// the player is asked again an interval later, not on every frame until it answers
+		const auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - m_anchorTime);
+		m_anchor.position = std::min(m_anchor.position + elapsed, m_anchor.duration);
+		m_anchorTime = now;
+	}
+	
+	const auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - m_anchorTime);
+	this->show_time(std::min(m_anchor.position + elapsed, m_anchor.duration));
+	return true; // keep ticking
+}
+
+bool Slider::resync_at(const chrono::microseconds now)
+{
+	if (!m_playbackSource) { return false; }
+	
+	const std::optional<PlaybackTime> time = m_playbackSource();
+	if (!time.has_value()) { return false; }
+	
+	m_anchor = time.value();
+	m_anchorTime = now;
+	if (m_anchor.duration != this->get_time_limit()) {
+		this->set_time_limit(m_anchor.duration);
+	}
+	return true;
+}
+
+void Slider::show_time(const chrono::milliseconds time)
+{
+	const int64_t second = chrono::duration_cast<chrono::seconds>(time).count();
+	const chrono::milliseconds limit = this->get_time_limit();
+	const int64_t pixel = limit.count() > 0 ?
+		(time.count() * _scale.get_width()) / limit.count() : 0;
+	
+	if (second == m_shownSecond && pixel == m_shownPixel) { return; }
+	m_shownSecond = second;
+	m_shownPixel = pixel;
+	this->set_time(time);
+}
+
 void Slider::sync_display_to_scale(void)
 {
 	_timeDisplay.set_text(time_position_to_string(
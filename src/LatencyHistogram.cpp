@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "LatencyHistogram.h"
+
+
+// public
+// ==================================================
+
+LatencyHistogram::LatencyHistogram(void) :
+	m_counts { }, m_count { 0 }, m_total { 0 }, m_max { 0 }
+{
+}
+
+void LatencyHistogram::record(const Duration duration)
+{
+	const auto value = static_cast<uint64_t>(std::clamp(duration, Duration(0), MAX).count());
+	++m_counts[bucket_of(value)];
+	++m_count;
+	m_total += value;
+	m_max = std::max(m_max, value);
+}
+
+void LatencyHistogram::reset(void)
+{
+	m_counts.fill(0);
+	m_count = 0;
+	m_total = 0;
+	m_max = 0;
+}
+
+uint64_t LatencyHistogram::count(void) const
+{
+	return m_count;
+}
+
+auto LatencyHistogram::percentile(const double percent) const -> Duration
+{
+	if (m_count == 0) { return Duration(0); }
+	
+	// the rank of the duration, from 1
+	const double rank = std::ceil(std::clamp(percent, 0.0, 100.0) / 100.0
+		* static_cast<double>(m_count)
+	);
+	const uint64_t target = std::max<uint64_t>(static_cast<uint64_t>(rank), 1);
+	
+	uint64_t seen = 0;
+	for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+		seen += m_counts[bucket];
+		if (seen >= target) {
+			return Duration(static_cast<Duration::rep>(std::min(bucket_top(bucket), m_max)));
+		}
+	}
+	return this->max();
+}
+
+auto LatencyHistogram::max(void) const -> Duration
+{
+	return Duration(static_cast<Duration::rep>(m_max));
+}
+
+auto LatencyHistogram::mean(void) const -> Duration
+{
+	if (m_count == 0) { return Duration(0); }
+	return Duration(static_cast<Duration::rep>(m_total / m_count));
+}
+
+
+
+// private
+// ==================================================
+
+size_t LatencyHistogram::bucket_of(const uint64_t value)
+{
+	if (value < SUB_BUCKETS) { return static_cast<size_t>(value); }
+	
+	// keep the `SUB_BITS` highest bits, the highest of which is always set
+	const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - SUB_BITS;
+	const auto mantissa = static_cast<size_t>(value >> shift);
+	return SUB_BUCKETS + (shift - 1) * HALF_BUCKETS + (mantissa - HALF_BUCKETS);
+}
+
+uint64_t LatencyHistogram::bucket_top(const size_t bucket)
+{
+	if (bucket < SUB_BUCKETS) { return bucket; }
+	
+	const size_t shift = (bucket - SUB_BUCKETS) / HALF_BUCKETS + 1;
+	const size_t mantissa = (bucket - SUB_BUCKETS) % HALF_BUCKETS + HALF_BUCKETS;
+	return ((uint64_t(mantissa) + 1) << shift) - 1;
+}
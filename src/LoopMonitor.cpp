@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <glibmm/main.h>
+#include <glibmm/miscutils.h>
+#include <map>
+#include <momuma/spdlog.h>
+#include <string_view>
+#include <vector>
+
+#include "LoopMonitor.h"
+
+
+namespace LoopMonitor
+{
+
+// the callbacks running, innermost last, written by the main loop and read by the watchdog
+static std::array<std::atomic<const char*>, MAX_DEPTH> s_running;
+static std::atomic<size_t> s_depth { 0 };
+
+// only touched by the main loop, like the callbacks themselves
+static std::map<std::string_view, LatencyHistogram> s_histograms;
+
+
+[[nodiscard]] static inline double to_ms(const LatencyHistogram::Duration d)
+{
+	return chrono::duration<double, std::milli>(d).count();
+}
+
+[[nodiscard]] static inline double to_ms(const Clock::duration d)
+{
+	return chrono::duration<double, std::milli>(d).count();
+}
+
+// The callbacks running, as "outer > inner".
+[[nodiscard]] static std::string running_callbacks(void)
+{
+	const size_t depth = s_depth.load(std::memory_order_acquire);
+	std::string names;
+	for (size_t i = 0; i < std::min(depth, MAX_DEPTH); ++i) {
+		if (i > 0) { names += " > "; }
+		names += s_running[i].load(std::memory_order_relaxed);
+	}
+	if (depth > MAX_DEPTH) { names += " > ..."; }
+	return names;
+}
+
+chrono::milliseconds threshold_from_env(void)
+{
+	const std::string value = Glib::getenv(THRESHOLD_ENV);
+	if (value.empty()) { return DEFAULT_THRESHOLD; }
+	
+	unsigned int ms = 0;
+	const char *const end = value.data() + value.size();
+	const auto [ptr, error] = std::from_chars(value.data(), end, ms);
+	if (error != std::errc() || ptr != end) {
+		SPDLOG_WARN("Ignoring invalid {:s}='{:s}'", THRESHOLD_ENV, value);
+		return DEFAULT_THRESHOLD;
+	}
+	return chrono::milliseconds(ms);
+}
+
+LatencyHistogram& histogram(const char *const name)
+{
+	return s_histograms[name];
+}
+
+void log_histograms(void)
+{
+	std::vector<std::pair<std::string_view, const LatencyHistogram*>> sorted;
+	for (const auto &[name, histogram] : s_histograms) {
+		if (histogram.count() > 0) { sorted.emplace_back(name, &histogram); }
+	}
+	if (sorted.empty()) {
+		SPDLOG_INFO("Callback latencies: nothing recorded");
+		return;
+	}
+	std::sort(sorted.begin(), sorted.end(),
+		[](const auto &a, const auto &b) -> bool
+		{
+			return a.second->percentile(99) > b.second->percentile(99);
+		}
+	);
+	
+	SPDLOG_INFO("Callback latencies (ms):");
+	for (const auto &[name, h] : sorted) {
+		SPDLOG_INFO("  {:<36s} n={:<8d} p50={:<8.3f} p90={:<8.3f} p99={:<8.3f} "
+			"p99.9={:<8.3f} max={:.3f}",
+			name, h->count(), to_ms(h->percentile(50)), to_ms(h->percentile(90)),
+			to_ms(h->percentile(99)), to_ms(h->percentile(99.9)), to_ms(h->max())
+		);
+	}
+}
+
+
+
+// Scope
+// ==================================================
+
+Scope::Scope(const char *const name, LatencyHistogram &histogram) :
+	d_histogram { histogram }, m_begin { Clock::now() }
+{
+	const size_t depth = s_depth.load(std::memory_order_relaxed);
+	if (depth < MAX_DEPTH) {
+		s_running[depth].store(name, std::memory_order_relaxed);
+	}
+	s_depth.store(depth + 1, std::memory_order_release);
+}
+
+Scope::~Scope(void)
+{
+	s_depth.fetch_sub(1, std::memory_order_release);
+	d_histogram.record(chrono::duration_cast<LatencyHistogram::Duration>(
+		Clock::now() - m_begin
+	));
+}
+
+
+
+// Watchdog - public
+// ==================================================
+
+Watchdog::Watchdog(const chrono::milliseconds threshold) :
+	m_threshold { threshold },
+	m_heartbeat { }, m_lastBeat { 0 }, m_stalled { false }, m_stalls { 0 }
+{
+}
+
+Watchdog::~Watchdog(void)
+{
+	this->stop();
+}
+
+void Watchdog::start(void)
+{
+	if (m_threshold.count() == 0 || m_thread.joinable()) { return; }
+	
+	m_lastBeat = Clock::now().time_since_epoch().count();
+	m_heartbeat = Glib::signal_timeout().connect(
+		sigc::mem_fun(*this, &Watchdog::cb__heartbeat),
+		static_cast<unsigned int>(std::max<chrono::milliseconds::rep>(
+			m_threshold.count() / 2, 1
+		)),
+		Glib::PRIORITY_HIGH
+	);
+	m_thread = std::jthread(std::bind_front(&Watchdog::thread_loop, this));
+	SPDLOG_DEBUG("Watching for main loop stalls longer than {:d} ms", m_threshold.count());
+}
+
+void Watchdog::stop(void)
+{
+	m_heartbeat.disconnect();
+	if (m_thread.joinable()) {
+		m_thread.request_stop();
+		m_thread.join();
+	}
+}
+
+size_t Watchdog::stalls(void) const
+{
+	return m_stalls.load(std::memory_order_relaxed);
+}
+
+
+
+// Watchdog - private
+// ==================================================
+
+bool Watchdog::cb__heartbeat(void)
+{
+	const Clock::rep now = Clock::now().time_since_epoch().count();
+	const Clock::rep last = m_lastBeat.exchange(now, std::memory_order_relaxed);
+	if (m_stalled.exchange(false, std::memory_order_relaxed)) {
+		// the beat was due half a threshold after the last one
+		const Clock::duration stalled = Clock::duration(now - last) - m_threshold / 2;
+		SPDLOG_WARN("Main loop iterates again, after a stall of {:.1f} ms", to_ms(stalled));
+	}
+	return true;
+}
+
+void Watchdog::thread_loop(const std::stop_token stop)
+{
+	const Clock::duration interval = m_threshold / 2;
+	// a beat is late once it didn't come a whole threshold after it was due
+	const Clock::duration late = interval + m_threshold;
+	const Clock::duration period = std::max<Clock::duration>(m_threshold / 4,
+		chrono::milliseconds(5)
+	);
+	
+	std::unique_lock lock(m_mutex);
+	while (!m_cv.wait_for(lock, stop, period, [](void) -> bool { return false; })) {
+		if (stop.stop_requested()) { return; }
+		
+		const Clock::time_point last {
+			Clock::duration(m_lastBeat.load(std::memory_order_relaxed))
+		};
+		const Clock::duration since = Clock::now() - last;
+		if (since <= late || m_stalled.exchange(true, std::memory_order_relaxed)) {
+			continue;
+		}
+		
+		m_stalls.fetch_add(1, std::memory_order_relaxed);
+		const std::string running = running_callbacks();
+		if (running.empty()) {
+			SPDLOG_WARN("Main loop stalled for {:.1f} ms so far, outside of the "
+				"monitored callbacks", to_ms(since)
+			);
+		}
+		else {
+			SPDLOG_WARN("Main loop stalled for {:.1f} ms so far, in {:s}",
+				to_ms(since), running
+			);
+		}
+	}
+}
+
+}
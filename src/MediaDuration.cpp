@@ -0,0 +1,441 @@
+#include <array>
+#include <cstring>
+#include <fcntl.h>
+#include <momuma/momuma.h>
+#include <momuma/spdlog.h>
+#include <span>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MediaDuration.h"
+
+
+using Duration = std::optional<chrono::microseconds>;
+using Bytes = std::span<const uint8_t>;
+
+// Most headers are found in the first few KiB of a file
+constexpr size_t HEAD_SIZE = 4 * 1024;
+
+// An Ogg page is at most 65307 bytes, so the last page always starts inside this window
+constexpr size_t OGG_TAIL_SIZE = 64 * 1024;
+
+
+namespace
+{
+
+// Closes the descriptor when going out of scope
+class File final
+{
+public:
+	explicit File(const fs::path &path) :
+		m_fd { ::open(path.c_str(), O_RDONLY | O_CLOEXEC) }, m_size { 0 }
+	{
+		struct stat st;
+		if (m_fd >= 0 && ::fstat(m_fd, &st) == 0) {
+			m_size = static_cast<uint64_t>(st.st_size);
+		}
+	}
+	
+	~File(void)
+	{
+		if (m_fd >= 0) { ::close(m_fd); }
+	}
+	
+	File(const File&) = delete;
+	File& operator=(const File&) = delete;
+	
+	[[nodiscard]] bool is_open(void) const { return m_fd >= 0; }
+	
+	[[nodiscard]] uint64_t size(void) const { return m_size; }
+	
+	// Returns the bytes that could be read, which may be less than `buffer.size()`
+	[[nodiscard]] Bytes read(const uint64_t offset, const std::span<uint8_t> buffer) const
+	{
+		if (offset >= m_size) { return { }; }
+		
+		const auto off = static_cast<off_t>(offset);
+		const ssize_t n = ::pread(m_fd, buffer.data(), buffer.size(), off);
+		return n <= 0 ? Bytes() : Bytes(buffer.data(), static_cast<size_t>(n));
+	}
+	
+private:
+	int m_fd;
+	uint64_t m_size;
+};
+
+}
+
+
+[[nodiscard]] static uint32_t read_u16_le(const uint8_t *p)
+{
+	return static_cast<uint32_t>(p[0] | (p[1] << 8));
+}
+
+[[nodiscard]] static uint32_t read_u32_le(const uint8_t *p)
+{
+	return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8
+		| static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+[[nodiscard]] static uint64_t read_u64_le(const uint8_t *p)
+{
+	return static_cast<uint64_t>(read_u32_le(p))
+		| static_cast<uint64_t>(read_u32_le(p + 4)) << 32;
+}
+
+[[nodiscard]] static uint32_t read_u32_be(const uint8_t *p)
+{
+	return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16
+		| static_cast<uint32_t>(p[2]) << 8 | static_cast<uint32_t>(p[3]);
+}
+
+[[nodiscard]] static uint64_t read_u64_be(const uint8_t *p)
+{
+	return static_cast<uint64_t>(read_u32_be(p)) << 32
+		| static_cast<uint64_t>(read_u32_be(p + 4));
+}
+
+[[nodiscard]] static bool starts_with(const Bytes data, const std::string_view magic)
+{
+	return data.size() >= magic.size()
+		&& std::memcmp(data.data(), magic.data(), magic.size()) == 0;
+}
+
+[[nodiscard]] static bool has_magic_at(const Bytes data, size_t offset, std::string_view magic)
+{
+	return data.size() >= offset && starts_with(data.subspan(offset), magic);
+}
+
+[[nodiscard]] static Duration make_duration(const uint64_t units, const uint64_t unitsPerSecond)
+{
+	if (unitsPerSecond == 0) { return std::nullopt; }
+	
+	// split to avoid overflowing with large sample counts
+	const uint64_t seconds = units / unitsPerSecond;
+	const uint64_t remainder = units % unitsPerSecond;
+	const uint64_t micros = remainder * 1'000'000 / unitsPerSecond;
+	return chrono::seconds(seconds) + chrono::microseconds(micros);
+}
+
+// Size of an ID3v2 tag at the start of `head`, 0 when there's none
+[[nodiscard]] static uint64_t id3v2_size(const Bytes head)
+{
+	if (!starts_with(head, "ID3") || head.size() < 10) { return 0; }
+	
+	// the size is a 28-bit "syncsafe" integer, excluding the 10-byte header
+	const uint64_t size = static_cast<uint64_t>(head[6] & 0x7f) << 21
+		| static_cast<uint64_t>(head[7] & 0x7f) << 14
+		| static_cast<uint64_t>(head[8] & 0x7f) << 7
+		| static_cast<uint64_t>(head[9] & 0x7f);
+	const bool hasFooter = (head[5] & 0x10) != 0;
+	return 10 + size + (hasFooter ? 10 : 0);
+}
+
+
+
+// FLAC
+// ==================================================
+
+[[nodiscard]] static Duration parse_flac(const Bytes head)
+{
+	// "fLaC", then the STREAMINFO metadata block is mandatory and always comes first
+	constexpr size_t STREAMINFO = 4 + 4;
+	if (head.size() < STREAMINFO + 18 || (head[4] & 0x7f) != 0) { return std::nullopt; }
+	
+	const uint8_t *const info = head.data() + STREAMINFO;
+	const uint32_t sampleRate = static_cast<uint32_t>(info[10]) << 12
+		| static_cast<uint32_t>(info[11]) << 4 | static_cast<uint32_t>(info[12]) >> 4;
+	const uint64_t samples = static_cast<uint64_t>(info[13] & 0x0f) << 32
+		| read_u32_be(info + 14);
+	
+	// a sample count of 0 means "unknown"
+	if (samples == 0) { return std::nullopt; }
+	return make_duration(samples, sampleRate);
+}
+
+
+
+// WAV
+// ==================================================
+
+[[nodiscard]] static Duration parse_wav(const File &file)
+{
+	std::array<uint8_t, 24> buffer;
+	uint32_t byteRate = 0;
+	
+	// walk the chunks after "RIFF" <size> "WAVE"
+	uint64_t offset = 12;
+	while (offset + 8 <= file.size()) {
+		const Bytes chunk = file.read(offset, buffer);
+		if (chunk.size() < 8) { return std::nullopt; }
+		
+		const uint64_t size = read_u32_le(chunk.data() + 4);
+		if (starts_with(chunk, "fmt ")) {
+			if (chunk.size() < 8 + 12) { return std::nullopt; }
+			byteRate = read_u32_le(chunk.data() + 8 + 8);
+		}
+		else if (starts_with(chunk, "data")) {
+			// the size can be bogus for streamed files, so don't trust it past the end
+			const uint64_t available = file.size() - (offset + 8);
+			return make_duration(std::min(size, available), byteRate);
+		}
+		
+		// chunks are padded to an even size
+		offset += 8 + size + (size & 1);
+	}
+	return std::nullopt;
+}
+
+
+
+// MP3
+// ==================================================
+
+struct MpegFrame
+{
+	uint32_t bitrate; // bits per second
+	uint32_t sampleRate;
+	uint32_t samplesPerFrame;
+	uint32_t sideInfoSize;
+};
+
+[[nodiscard]] static std::optional<MpegFrame> parse_mpeg_header(const uint8_t *h)
+{
+	// bitrates in kbit/s, indexed by [version is MPEG-1][layer - 1][bitrate index]
+	static constexpr uint16_t BITRATES[2][3][16] = {
+		{ // MPEG-2 and MPEG-2.5
+			{ 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0 },
+			{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+			{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+		},
+		{ // MPEG-1
+			{ 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 },
+			{ 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 0 },
+			{ 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 },
+		},
+	};
+	static constexpr uint32_t SAMPLE_RATES[3] = { 44100, 48000, 32000 };
+	
+	if (h[0] != 0xff || (h[1] & 0xe0) != 0xe0) { return std::nullopt; }
+	
+	// 0: MPEG-2.5, 1: reserved, 2: MPEG-2, 3: MPEG-1
+	const uint32_t version = (h[1] >> 3) & 0x3;
+	const uint32_t layer = 4 - ((h[1] >> 1) & 0x3); // 4 is reserved
+	const uint32_t bitrateIndex = h[2] >> 4;
+	const uint32_t sampleRateIndex = (h[2] >> 2) & 0x3;
+	const bool mono = (h[3] >> 6) == 0x3;
+	
+	if (version == 1 || layer == 4 || bitrateIndex == 0xf || sampleRateIndex == 0x3) {
+		return std::nullopt;
+	}
+	
+	const bool mpeg1 = (version == 3);
+	MpegFrame frame { };
+	frame.bitrate = BITRATES[mpeg1][layer - 1][bitrateIndex] * 1000U;
+	frame.sampleRate = SAMPLE_RATES[sampleRateIndex] >> (mpeg1 ? 0 : (version == 2 ? 1 : 2));
+	frame.samplesPerFrame = (layer == 1) ? 384 : (layer == 3 && !mpeg1) ? 576 : 1152;
+	frame.sideInfoSize = mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+	return frame;
+}
+
+// `frame` are the first bytes after the ID3v2 tag, which is `tagSize` bytes long
+[[nodiscard]] static Duration parse_mp3(const File &file, const Bytes frame, const uint64_t tagSize)
+{
+	if (frame.size() < 4) { return std::nullopt; }
+	
+	const std::optional header = parse_mpeg_header(frame.data());
+	if (!header.has_value()) { return std::nullopt; }
+	
+	// a VBR file starts with a Xing/Info or a VBRI frame that holds the number of frames
+	const size_t xing = 4 + header->sideInfoSize;
+	if (frame.size() >= xing + 12) {
+		const Bytes tag = frame.subspan(xing);
+		const bool hasFrames = (read_u32_be(tag.data() + 4) & 0x1) != 0;
+		if ((starts_with(tag, "Xing") || starts_with(tag, "Info")) && hasFrames) {
+			const uint64_t frames = read_u32_be(tag.data() + 8);
+			return make_duration(frames * header->samplesPerFrame, header->sampleRate);
+		}
+	}
+	
+	constexpr size_t VBRI = 4 + 32;
+	if (frame.size() >= VBRI + 18 && starts_with(frame.subspan(VBRI), "VBRI")) {
+		const uint64_t frames = read_u32_be(frame.data() + VBRI + 14);
+		return make_duration(frames * header->samplesPerFrame, header->sampleRate);
+	}
+	
+	// assume a constant bitrate, ignoring the ID3v1 tag at the end of the file
+	if (header->bitrate == 0) { return std::nullopt; }
+	
+	uint64_t audioSize = file.size() - tagSize;
+	std::array<uint8_t, 3> id3v1;
+	if (file.size() >= tagSize + 128) {
+		if (starts_with(file.read(file.size() - 128, id3v1), "TAG")) {
+			audioSize -= 128;
+		}
+	}
+	return make_duration(audioSize * 8, header->bitrate);
+}
+
+
+
+// Ogg
+// ==================================================
+
+struct OggStream
+{
+	uint32_t serial;
+	uint64_t rate;
+	uint64_t preSkip;
+};
+
+[[nodiscard]] static std::optional<OggStream> parse_ogg_first_page(const Bytes head)
+{
+	constexpr size_t HEADER = 27;
+	if (head.size() < HEADER) { return std::nullopt; }
+	
+	const size_t segments = head[26];
+	const size_t packet = HEADER + segments;
+	if (head.size() < packet + 19) { return std::nullopt; }
+	
+	const uint32_t serial = read_u32_le(head.data() + 14);
+	const Bytes data = head.subspan(packet);
+	if (starts_with(data, "\x01vorbis")) {
+		return OggStream { serial, read_u32_le(data.data() + 12), 0 };
+	}
+	if (starts_with(data, "OpusHead")) {
+		// Opus granule positions always count 48 kHz samples
+		return OggStream { serial, 48000, read_u16_le(data.data() + 10) };
+	}
+	return std::nullopt;
+}
+
+[[nodiscard]] static Duration parse_ogg(const File &file, const Bytes head)
+{
+	const std::optional stream = parse_ogg_first_page(head);
+	if (!stream.has_value()) { return std::nullopt; }
+	
+	std::array<uint8_t, OGG_TAIL_SIZE> buffer;
+	const uint64_t offset = file.size() > buffer.size() ? file.size() - buffer.size() : 0;
+	const Bytes tail = file.read(offset, buffer);
+	
+	// the granule position of the stream's last page is the total number of samples
+	for (size_t i = tail.size() < 27 ? 0 : tail.size() - 27 + 1; i-- > 0;) {
+		const Bytes page = tail.subspan(i);
+		if (!starts_with(page, "OggS") || read_u32_le(page.data() + 14) != stream->serial) {
+			continue;
+		}
+		
+		const uint64_t granule = read_u64_le(page.data() + 6);
+		if (granule == UINT64_MAX) { continue; } // no packet ends on this page
+		if (granule <= stream->preSkip) { return std::nullopt; }
+		return make_duration(granule - stream->preSkip, stream->rate);
+	}
+	return std::nullopt;
+}
+
+
+
+// MP4
+// ==================================================
+
+/* #Find a box inside the range [`begin`, `end`).
+! @return: the offset and size of the box's contents.
+*/
+[[nodiscard]] static std::optional<std::pair<uint64_t, uint64_t>>
+find_mp4_box(const File &file, uint64_t begin, const uint64_t end, const std::string_view type)
+{
+	std::array<uint8_t, 16> buffer;
+	while (begin + 8 <= end) {
+		const Bytes box = file.read(begin, buffer);
+		if (box.size() < 8) { return std::nullopt; }
+		
+		uint64_t size = read_u32_be(box.data());
+		uint64_t header = 8;
+		if (size == 1) {
+			if (box.size() < 16) { return std::nullopt; }
+			size = read_u64_be(box.data() + 8);
+			header = 16;
+		}
+		else if (size == 0) {
+			size = end - begin; // extends to the end
+		}
+		if (size < header || size > end - begin) { return std::nullopt; }
+		
+		if (std::memcmp(box.data() + 4, type.data(), 4) == 0) {
+			return std::pair { begin + header, size - header };
+		}
+		begin += size;
+	}
+	return std::nullopt;
+}
+
+[[nodiscard]] static Duration parse_mp4(const File &file)
+{
+	const auto moov = find_mp4_box(file, 0, file.size(), "moov");
+	if (!moov.has_value()) { return std::nullopt; }
+	
+	const auto mvhd = find_mp4_box(file, moov->first, moov->first + moov->second, "mvhd");
+	if (!mvhd.has_value()) { return std::nullopt; }
+	
+	std::array<uint8_t, 32> buffer;
+	const Bytes box = file.read(mvhd->first, buffer);
+	if (box.size() < 20) { return std::nullopt; }
+	
+	// version 1 uses 64-bit times
+	if (box[0] == 1) {
+		if (box.size() < 32) { return std::nullopt; }
+		return make_duration(read_u64_be(box.data() + 24), read_u32_be(box.data() + 20));
+	}
+	return make_duration(read_u32_be(box.data() + 16), read_u32_be(box.data() + 12));
+}
+
+
+
+namespace Media
+{
+
+Duration parse_duration(const fs::path &path)
+{
+	const File file(path);
+	if (!file.is_open()) { return std::nullopt; }
+	
+	std::array<uint8_t, HEAD_SIZE> buffer;
+	Bytes head = file.read(0, buffer);
+	
+	if (starts_with(head, "RIFF") && has_magic_at(head, 8, "WAVE")) {
+		return parse_wav(file);
+	}
+	if (starts_with(head, "OggS")) {
+		return parse_ogg(file, head);
+	}
+	if (has_magic_at(head, 4, "ftyp")) {
+		return parse_mp4(file);
+	}
+	
+	// both FLAC and MP3 files may start with an ID3v2 tag
+	const uint64_t tagSize = id3v2_size(head);
+	if (tagSize > 0) {
+		head = file.read(tagSize, buffer);
+	}
+	
+	if (starts_with(head, "fLaC")) {
+		return parse_flac(head);
+	}
+	if (head.size() >= 4 && parse_mpeg_header(head.data()).has_value()) {
+		return parse_mp3(file, head, tagSize);
+	}
+	return std::nullopt;
+}
+
+chrono::microseconds query_duration(const fs::path &path)
+{
+	const Duration duration = parse_duration(path);
+	if (duration.has_value()) {
+		return duration.value();
+	}
+	
+	SPDLOG_DEBUG("Falling back to mpv for the duration of '{:s}'", path.string());
+	return chrono::duration_cast<chrono::microseconds>(Momuma::MpvPlayer::query_duration(path));
+}
+
+}
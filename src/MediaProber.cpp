@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <functional>
+#include <momuma/spdlog.h>
+
+#include "MediaProber.h"
+
+
+[[nodiscard]] static size_t worker_count(void)
+{
+	return std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+
+// public
+// ==================================================
+
+MediaProber::MediaProber(Backend::ProbeFunc probe) :
+	m_probe { std::move(probe) },
+	m_results { RESULTS_CAPACITY }, m_lastTicket { 0 }
+{
+	m_results.connect(sigc::mem_fun(*this, &MediaProber::cb__results_ready));
+	
+	const size_t count = worker_count();
+	m_workers.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		m_workers.emplace_back(std::bind_front(&MediaProber::worker_loop, this));
+	}
+	SPDLOG_DEBUG("Started {:d} media probing threads", count);
+}
+
+MediaProber::~MediaProber(void)
+{
+	{
+		// the queued probes are dropped, the workers don't run them before stopping
+		const std::lock_guard lock(m_jobsMutex);
+		m_jobs.clear();
+	}
+	for (std::jthread &worker : m_workers) {
+		worker.request_stop();
+	}
+	m_jobsCv.notify_all();
+	m_workers.clear(); // joins
+}
+
+void MediaProber::probe(const PageId page, std::vector<Request> requests)
+{
+	if (requests.empty()) { return; }
+	
+	auto [iter, inserted] = m_pending.try_emplace(page, Pending { 0, 0 });
+	if (inserted) {
+		iter->second.ticket = ++m_lastTicket;
+	}
+	iter->second.remaining += requests.size();
+	
+	{
+		const std::lock_guard lock(m_jobsMutex);
+		for (Request &request : requests) {
+			m_jobs.push_back({ page, iter->second.ticket, std::move(request) });
+		}
+	}
+	m_jobsCv.notify_all();
+}
+
+void MediaProber::cancel(const PageId page)
+{
+	const auto iter = m_pending.find(page);
+	if (iter == m_pending.end()) { return; }
+	
+	const uint64_t ticket = iter->second.ticket;
+	m_pending.erase(iter);
+	
+	size_t dropped = 0;
+	{
+		const std::lock_guard lock(m_jobsMutex);
+		dropped = std::erase_if(m_jobs,
+			[ticket](const Job &job) -> bool { return job.ticket == ticket; }
+		);
+	}
+	SPDLOG_DEBUG("Cancelled {:d} pending probes", dropped);
+}
+
+size_t MediaProber::workers(void) const
+{
+	return m_workers.size();
+}
+
+auto MediaProber::signal_probed(void) -> sigc::signal<void(PageId, const std::vector<Probed>&)>
+{
+	return m_signal_probed;
+}
+
+
+
+// private
+// ==================================================
+
+void MediaProber::worker_loop(const std::stop_token stop)
+{
+	while (true) {
+		Job job;
+		{
+			std::unique_lock lock(m_jobsMutex);
+			// returns whether there's a job, which may still be the case once stopped
+			(void)m_jobsCv.wait(lock, stop,
+				[this](void) -> bool { return !m_jobs.empty(); }
+			);
+			if (stop.stop_requested()) { return; }
+			
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+		
+		const auto duration = chrono::duration_cast<chrono::milliseconds>(
+			m_probe(job.request.path)
+		);
+		// the main loop doesn't drain the results anymore once the prober is being destroyed
+		if (stop.stop_requested()) { return; }
+		
+		const bool pushed = m_results.push({ job.page, job.ticket,
+			{ job.request.row, duration, std::move(job.request.path) }
+		}, stop);
+		if (!pushed) { return; }
+	}
+}
+
+void MediaProber::cb__results_ready(const std::span<Result> results)
+{
+	// coalesced, so each page is updated once per batch
+	std::unordered_map<PageId, std::vector<Probed>> batches;
+	for (Result &result : results) {
+		const auto iter = m_pending.find(result.page);
+		if (iter == m_pending.end() || iter->second.ticket != result.ticket) {
+			continue; // the page was cancelled, or its id was reused by a newer page
+		}
+		
+		batches[result.page].push_back(std::move(result.probed));
+		if (--iter->second.remaining == 0) {
+			m_pending.erase(iter);
+		}
+	}
+	
+	for (const auto &[page, batch] : batches) {
+		m_signal_probed.emit(page, batch);
+	}
+}
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <momuma/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "MetadataCache.h"
+
+
+constexpr char FILE_MAGIC[8] = { 'M', 'M', 'G', 'M', 'E', 'T', 'A', '\0' };
+constexpr uint32_t FILE_VERSION = 2;
+
+struct FileHeader
+{
+	char magic[sizeof(FILE_MAGIC)];
+	uint32_t version;
+	uint32_t slotCount; // always a power of 2
+	uint64_t entryCount;
+	uint64_t stringsSize;
+	uint32_t oldestUse; // the `lastUse` of the oldest entry, `UINT32_MAX` when there's none
+	uint32_t reserved;
+};
+
+// An empty slot has a `hash` of 0
+struct MetadataCache::Slot
+{
+	uint64_t hash;
+	uint64_t size;
+	int64_t mtime;
+	int64_t durationMs;
+	uint32_t pathOffset;
+	uint32_t pathLength;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t lastUse; // days since the epoch
+	uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 40);
+
+
+// 64-bit FNV-1a, never 0 so 0 can mark empty slots
+[[nodiscard]] static uint64_t hash_path(const std::string_view path)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (const char c : path) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 0x100000001b3ULL;
+	}
+	return hash == 0 ? 1 : hash;
+}
+
+// Days since the epoch, the unit of the entries' last use
+[[nodiscard]] static uint32_t today(void)
+{
+	const auto days = chrono::floor<chrono::days>(chrono::system_clock::now());
+	return static_cast<uint32_t>(days.time_since_epoch().count());
+}
+
+// Whether an entry last used on `lastUse` is dropped, an entry from the future isn't
+[[nodiscard]] static bool is_expired(const uint32_t lastUse, const uint32_t now)
+{
+	const auto maxIdle = static_cast<uint32_t>(MetadataCache::MAX_IDLE.count());
+	return lastUse < now && now - lastUse > maxIdle;
+}
+
+// Keep the index at most half full, so the probe sequences stay short
+[[nodiscard]] static uint32_t slot_count_for(const size_t entries)
+{
+	return std::bit_ceil(static_cast<uint32_t>(std::max<size_t>(entries * 2, 16)));
+}
+
+
+// public
+// ==================================================
+
+std::optional<MetadataCache::Key> MetadataCache::make_key(fs::path path)
+{
+	struct stat st;
+	if (::stat(path.c_str(), &st) != 0) {
+		return std::nullopt;
+	}
+	
+	const int64_t mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000
+		+ st.st_mtim.tv_nsec;
+	return Key { std::move(path), static_cast<uintmax_t>(st.st_size), mtime };
+}
+
+MetadataCache::MetadataCache(fs::path file) :
+	m_file { std::move(file) }, m_map { }, m_slots { }, m_strings { },
+	m_oldestUse { UINT32_MAX }, m_used { }, m_unsaved { }, m_stats { 0, 0 }
+{
+	this->map_file();
+}
+
+MetadataCache::~MetadataCache(void)
+{
+	this->unmap_file();
+}
+
+std::optional<MetadataCache::Entry> MetadataCache::find(const Key &key)
+{
+	const std::string &path = key.path.native();
+	
+	if (const auto iter = m_unsaved.find(path); iter != m_unsaved.end()) {
+		const Key &cached = iter->second.first;
+		if (cached.size == key.size && cached.mtime == key.mtime) {
+			++m_stats.hits;
+			return iter->second.second;
+		}
+	}
+	else if (const Slot *const slot = this->find_slot(path); slot != nullptr) {
+		if (slot->size == key.size && slot->mtime == key.mtime) {
+			++m_stats.hits;
+			m_used.insert(static_cast<size_t>(slot - m_slots.data()));
+			const std::string_view name = this->slot_string(slot->nameOffset,
+				slot->nameLength
+			);
+			return Entry { chrono::milliseconds(slot->durationMs), std::string(name) };
+		}
+	}
+	
+	++m_stats.misses;
+	return std::nullopt;
+}
+
+void MetadataCache::insert(const Key &key, Entry entry)
+{
+	m_unsaved.insert_or_assign(key.path.native(), std::pair { key, std::move(entry) });
+}
+
+bool MetadataCache::save(void)
+{
+	const uint32_t now = today();
+	const bool used = std::any_of(m_used.begin(), m_used.end(),
+		[this, now](const size_t i) -> bool { return m_slots[i].lastUse != now; }
+	);
+	if (m_unsaved.empty() && !used && !is_expired(m_oldestUse, now)) { return true; }
+	
+	// collect the entries of both the mapped file and the unsaved ones
+	struct Record
+	{
+		std::string_view path;
+		uint64_t size;
+		int64_t mtime;
+		int64_t durationMs;
+		std::string_view name;
+		uint32_t lastUse;
+	};
+	std::vector<Record> records;
+	records.reserve(m_slots.size() / 2 + m_unsaved.size());
+	
+	size_t expired = 0;
+	for (size_t i = 0; i < m_slots.size(); ++i) {
+		const Slot &slot = m_slots[i];
+		if (slot.hash == 0) { continue; }
+		
+		const std::string_view path = this->slot_string(slot.pathOffset, slot.pathLength);
+		if (m_unsaved.contains(std::string(path))) { continue; }
+		
+		const uint32_t lastUse = m_used.contains(i) ? now : slot.lastUse;
+		if (is_expired(lastUse, now)) {
+			++expired;
+			continue;
+		}
+		records.push_back({
+			path, slot.size, slot.mtime, slot.durationMs,
+			this->slot_string(slot.nameOffset, slot.nameLength), lastUse,
+		});
+	}
+	for (const auto &[path, value] : m_unsaved) {
+		const auto &[key, entry] = value;
+		records.push_back({
+			path, key.size, key.mtime, entry.duration.count(),
+			std::string_view(entry.name.raw()), now,
+		});
+	}
+	
+	// build the hash index and the string pool
+	const uint32_t slotCount = slot_count_for(records.size());
+	std::vector<Slot> slots(slotCount, Slot { });
+	std::string strings;
+	
+	const auto append_string = [&strings](std::string_view s) -> std::pair<uint32_t, uint32_t>
+	{
+		const auto offset = static_cast<uint32_t>(strings.size());
+		strings.append(s);
+		return { offset, static_cast<uint32_t>(s.size()) };
+	};
+	
+	for (const Record &record : records) {
+		const uint64_t hash = hash_path(record.path);
+		uint32_t i = static_cast<uint32_t>(hash) & (slotCount - 1);
+		while (slots[i].hash != 0) {
+			i = (i + 1) & (slotCount - 1);
+		}
+		
+		Slot &slot = slots[i];
+		slot.hash = hash;
+		slot.size = record.size;
+		slot.mtime = record.mtime;
+		slot.durationMs = record.durationMs;
+		slot.lastUse = record.lastUse;
+		std::tie(slot.pathOffset, slot.pathLength) = append_string(record.path);
+		std::tie(slot.nameOffset, slot.nameLength) = append_string(record.name);
+	}
+	
+	FileHeader header { };
+	std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+	header.version = FILE_VERSION;
+	header.slotCount = slotCount;
+	header.entryCount = records.size();
+	header.stringsSize = strings.size();
+	header.oldestUse = UINT32_MAX;
+	for (const Record &record : records) {
+		header.oldestUse = std::min(header.oldestUse, record.lastUse);
+	}
+	
+	// write to a temporary file, then replace the old one
+	std::error_code err;
+	fs::create_directories(m_file.parent_path(), err);
+	const fs::path tmpFile = fs::path(m_file).concat(".tmp");
+	{
+		std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(slots.data()),
+			static_cast<std::streamsize>(slots.size() * sizeof(Slot))
+		);
+		out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+		if (!out.flush()) {
+			SPDLOG_ERROR("Failed to write metadata cache '{:s}'", tmpFile.string());
+			fs::remove(tmpFile, err);
+			return false;
+		}
+	}
+	
+	// `records` points into the mapping, so it's only released once the file was written
+	this->unmap_file();
+	fs::rename(tmpFile, m_file, err);
+	if (err) {
+		SPDLOG_ERROR("Failed to replace metadata cache '{:s}': {:s}",
+			m_file.string(), err.message()
+		);
+		fs::remove(tmpFile, err);
+		return false;
+	}
+	
+	SPDLOG_INFO("Saved metadata cache ({:d} entries, {:d} new, {:d} dropped)",
+		records.size(), m_unsaved.size(), expired
+	);
+	m_unsaved.clear();
+	this->map_file();
+	return true;
+}
+
+MetadataCache::Stats MetadataCache::take_stats(void)
+{
+	return std::exchange(m_stats, Stats { 0, 0 });
+}
+
+
+
+// private
+// ==================================================
+
+bool MetadataCache::map_file(void)
+{
+	static_assert(sizeof(Slot) == 56, "the file layout mustn't depend on padding");
+	
+	const int fd = ::open(m_file.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) { return false; }
+	
+	struct stat st;
+	void *addr = MAP_FAILED;
+	if (::fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(FileHeader))) {
+		const auto size = static_cast<size_t>(st.st_size);
+		addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	::close(fd);
+	
+	if (addr == MAP_FAILED) {
+		SPDLOG_WARN("Failed to map metadata cache '{:s}'", m_file.string());
+		return false;
+	}
+	m_map = std::span(static_cast<const std::byte*>(addr), static_cast<size_t>(st.st_size));
+	
+	FileHeader header;
+	std::memcpy(&header, m_map.data(), sizeof(header));
+	
+	const bool valid = std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0
+		&& header.version == FILE_VERSION
+		&& std::has_single_bit(header.slotCount)
+		&& m_map.size() == sizeof(FileHeader)
+			+ header.slotCount * sizeof(Slot) + header.stringsSize;
+	if (!valid) {
+		SPDLOG_WARN("Ignoring invalid metadata cache '{:s}'", m_file.string());
+		this->unmap_file();
+		return false;
+	}
+	
+	const std::byte *const slots = m_map.data() + sizeof(FileHeader);
+	const std::byte *const strings = slots + header.slotCount * sizeof(Slot);
+	m_slots = std::span(reinterpret_cast<const Slot*>(slots), header.slotCount);
+	m_strings = std::span(reinterpret_cast<const char*>(strings), header.stringsSize);
+	m_oldestUse = header.oldestUse;
+	
+	SPDLOG_INFO("Mapped metadata cache '{:s}' ({:d} entries)",
+		m_file.string(), header.entryCount
+	);
+	return true;
+}
+
+void MetadataCache::unmap_file(void)
+{
+	if (m_map.empty()) { return; }
+	
+	::munmap(const_cast<std::byte*>(m_map.data()), m_map.size());
+	m_map = { };
+	m_slots = { };
+	m_strings = { };
+	// the indices are those of the old file
+	m_oldestUse = UINT32_MAX;
+	m_used.clear();
+}
+
+auto MetadataCache::find_slot(const std::string &path) const -> const Slot*
+{
+	if (m_slots.empty()) { return nullptr; }
+	
+	const uint64_t hash = hash_path(path);
+	const size_t mask = m_slots.size() - 1;
+	size_t i = hash & mask;
+	for (size_t probes = 0; probes < m_slots.size(); ++probes, i = (i + 1) & mask) {
+		const Slot &slot = m_slots[i];
+		if (slot.hash == 0) { break; }
+		
+		if (slot.hash != hash) { continue; }
+		if (this->slot_string(slot.pathOffset, slot.pathLength) == path) {
+			return &slot;
+		}
+	}
+	return nullptr;
+}
+
+std::string_view MetadataCache::slot_string(const uint32_t offset, const uint32_t length) const
+{
+	// a corrupted file must never make us read outside of the mapping
+	if (static_cast<size_t>(offset) + length > m_strings.size()) {
+		return { };
+	}
+	return std::string_view(m_strings.data() + offset, length);
+}
@@ -0,0 +1,168 @@
+#include <cassert>
+#include <momuma/spdlog.h>
+
+#include "MomumaBackend.h"
+
+
+// Forwards to a `Momuma::MpvPlayer`, and its signals back
+class MomumaBackend::MpvPlayer final : public Backend::Player
+{
+public:
+	explicit MpvPlayer(Momuma::MpvPlayer &player) :
+		d_player { player }
+	{
+		d_player.signal_streamStarted.connect(
+			[this](Momuma::MpvPlayer&) -> void
+			{
+				this->signal_streamStarted.emit(*this);
+			}
+		);
+		d_player.signal_streamEnded.connect(
+			[this](Momuma::MpvPlayer&) -> void
+			{
+				this->signal_streamEnded.emit(*this);
+			}
+		);
+		d_player.signal_stateChanged.connect(
+			[this](Momuma::MpvPlayer&, const State prevState, const State newState)
+				-> void
+			{
+				this->signal_stateChanged.emit(*this, prevState, newState);
+			}
+		);
+	}
+	
+	void handle_event(void) override
+	{
+		d_player.wait_event(std::chrono::seconds(0));
+	}
+	
+	bool set_wakeup(WakeupFunc) override
+	{
+		// `Momuma::MpvPlayer` keeps its mpv handle to itself, so there's no wakeup callback
+		return false;
+	}
+	
+	State get_state(void) override
+	{
+		return d_player.get_state();
+	}
+	
+	std::chrono::microseconds get_position(mpv_error &error) override
+	{
+		return d_player.get_position(error);
+	}
+	
+	std::chrono::microseconds get_duration(mpv_error &error) override
+	{
+		return d_player.get_duration(error);
+	}
+	
+	void set_play(const bool play) override
+	{
+		(void)d_player.set_play(play);
+	}
+	
+	void set_position(const std::chrono::milliseconds position) override
+	{
+		(void)d_player.set_position(position);
+	}
+	
+	void set_volume(const double volume) override
+	{
+		d_player.set_volume(volume);
+	}
+	
+	void stop_playback(void) override
+	{
+		d_player.stop_playback();
+	}
+	
+	mpv_error append_media(const std::filesystem::path &path) override
+	{
+		return d_player.append_media(path);
+	}
+	
+	bool remove_media(int) override
+	{
+		// `Momuma::MpvPlayer` has no command to remove a single entry of its playlist
+		return false;
+	}
+	
+	bool playlist_empty(void) override
+	{
+		return d_player.playlist_empty();
+	}
+	
+	int64_t get_index(void) override
+	{
+		return static_cast<int64_t>(d_player.get_index());
+	}
+	
+	void set_index(const int index) override
+	{
+		d_player.set_index(index);
+	}
+	
+private:
+	Momuma::MpvPlayer &d_player;
+};
+
+
+// Forwards to a `Momuma::Database::Sqlite3`
+class MomumaBackend::Sqlite3 final : public Backend::Database
+{
+public:
+	explicit Sqlite3(Momuma::Database::Sqlite3 &database) :
+		d_database { database }
+	{
+	}
+	
+	int get_playlists(const std::function<IterFlag(Glib::ustring)> &callback) override
+	{
+		return d_database.get_playlists(callback);
+	}
+	
+	int get_media_paths(const Glib::ustring &playlist,
+		const std::function<IterFlag(std::filesystem::path)> &callback
+	) override {
+		return d_database.get_media_paths(playlist, callback);
+	}
+	
+private:
+	Momuma::Database::Sqlite3 &d_database;
+};
+
+
+
+// public
+// ==================================================
+
+MomumaBackend::MomumaBackend(const fs::path &folder) :
+	m_momuma { folder },
+	m_player { }, m_database { }
+{
+	if (!m_momuma) { return; }
+	
+	m_player = std::make_unique<MpvPlayer>(m_momuma.get_player());
+	m_database = std::make_unique<Sqlite3>(m_momuma.get_database());
+}
+
+MomumaBackend::~MomumaBackend(void) = default;
+
+bool MomumaBackend::is_valid(void) const
+{
+	return m_player != nullptr;
+}
+
+auto MomumaBackend::get_player(void) -> Player&
+{
+	assert(m_player);
+	return *m_player;
+}
+
+auto MomumaBackend::get_database(void) -> Database&
+{
+	assert(m_database);
+	return *m_database;
+}
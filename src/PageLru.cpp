@@ -0,0 +1,90 @@
+#include <charconv>
+#include <glibmm/miscutils.h>
+#include <momuma/spdlog.h>
+
+#include "PageLru.h"
+
+
+// public
+// ==================================================
+
+size_t PageLru::budget_from_env(void)
+{
+	const std::string value = Glib::getenv(BUDGET_ENV);
+	if (value.empty()) { return DEFAULT_BUDGET; }
+	
+	size_t megabytes = 0;
+	const char *const end = value.data() + value.size();
+	const auto [ptr, error] = std::from_chars(value.data(), end, megabytes);
+	if (error != std::errc() || ptr != end || megabytes == 0) {
+		SPDLOG_WARN("Ignoring invalid {:s}='{:s}'", BUDGET_ENV, value);
+		return DEFAULT_BUDGET;
+	}
+	return megabytes << 20;
+}
+
+PageLru::PageLru(const size_t budget) :
+	m_budget { budget },
+	m_order { }, m_entries { }
+{
+}
+
+void PageLru::touch(const PageId page)
+{
+	const auto iter = m_entries.find(page);
+	if (iter != m_entries.end()) {
+		m_order.erase(iter->second);
+	}
+	m_order.push_front({ page, Clock::now() });
+	m_entries[page] = m_order.begin();
+}
+
+void PageLru::forget(const PageId page)
+{
+	const auto iter = m_entries.find(page);
+	if (iter == m_entries.end()) { return; }
+	
+	m_order.erase(iter->second);
+	m_entries.erase(iter);
+}
+
+std::vector<PageId> PageLru::select_victims(
+	const sigc::slot<size_t(PageId)> &usage, const sigc::slot<bool(PageId)> &evictable
+) const {
+	std::vector<std::pair<PageId, size_t>> usages;
+	usages.reserve(m_order.size());
+	size_t total = 0;
+	for (const Entry &entry : m_order) {
+		const size_t bytes = usage(entry.page);
+		usages.emplace_back(entry.page, bytes);
+		total += bytes;
+	}
+	
+	std::vector<PageId> victims;
+	if (total <= m_budget) { return victims; }
+	
+	const Clock::time_point recent = Clock::now() - MIN_INACTIVE;
+	auto entry = m_order.rbegin();
+	for (auto iter = usages.rbegin(); iter != usages.rend() && total > m_budget;
+		++iter, ++entry
+	) {
+		const auto [page, bytes] = *iter;
+		if (entry->focused > recent) { break; } // the remaining pages are even more recent
+		if (bytes == 0 || !evictable(page)) { continue; }
+		
+		victims.push_back(page);
+		total -= bytes;
+	}
+	
+	if (total > m_budget) {
+		SPDLOG_DEBUG("The pages use {:d} KiB, over the budget of {:d} KiB",
+			total >> 10, m_budget >> 10
+		);
+	}
+	return victims;
+}
+
+size_t PageLru::budget(void) const
+{
+	return m_budget;
+}
@@ -3,6 +3,15 @@
 #include "Pages.h"
 
 
+size_t paths_memory(const std::vector<fs::path> &paths)
+{
+	size_t bytes = paths.capacity() * sizeof(fs::path);
+	for (const fs::path &p : paths) {
+		bytes += p.native().capacity();
+	}
+	return bytes;
+}
+
 PageMap::PageMap(void) :
 	m_playing { PageId::Null }
 {
@@ -18,6 +27,11 @@ bool PageMap::has_playing_page(void)
 	return m_playing != PageId::Null && this->contains(m_playing);
 }
 
+void PageMap::set_playing(const PageId id)
+{
+	m_playing = id;
+}
+
 void PageMap::connect_page_destroyed(Gui::PlaylistNotebook &src)
 {
 	src.signal_page_destroyed().connect(
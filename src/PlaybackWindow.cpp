@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <glibmm/main.h>
+#include <momuma/spdlog.h>
+
+#include "PlaybackWindow.h"
+
+
+// public
+// ==================================================
+
+PlaybackWindow::PlaybackWindow(Backend::Player &player) :
+	d_player { player },
+	m_page { PageId::Null }, m_paths { }, m_first { 0 }, m_size { 0 },
+	m_filler { }, m_fillEnd { 0 }
+{
+}
+
+PlaybackWindow::~PlaybackWindow(void)
+{
+	m_filler.disconnect();
+}
+
+bool PlaybackWindow::load(const PageId page, Paths paths, const size_t row)
+{
+	m_page = page;
+	m_paths = std::move(paths);
+	return this->rebuild(row);
+}
+
+bool PlaybackWindow::jump(const size_t row)
+{
+	const std::optional<int64_t> index = this->row_to_index(row);
+	if (!index.has_value()) {
+		return this->rebuild(row);
+	}
+	
+	d_player.set_index(static_cast<int>(index.value()));
+	this->advance();
+	return true;
+}
+
+void PlaybackWindow::advance(void)
+{
+	const std::optional<size_t> row = this->current_row();
+	if (!row.has_value()) { return; }
+	
+	this->trim(row.value());
+	this->fill_until(std::min(row.value() + AHEAD + 1, this->rows()));
+}
+
+void PlaybackWindow::reset(void)
+{
+	m_filler.disconnect();
+	m_page = PageId::Null;
+	m_paths.reset();
+	m_first = m_size = 0;
+}
+
+PageId PlaybackWindow::page(void) const
+{
+	return m_page;
+}
+
+size_t PlaybackWindow::rows(void) const
+{
+	return m_paths ? m_paths->size() : 0;
+}
+
+std::optional<size_t> PlaybackWindow::current_row(void) const
+{
+	return this->index_to_row(d_player.get_index());
+}
+
+std::optional<size_t> PlaybackWindow::index_to_row(const int64_t index) const
+{
+	if (index < 0 || static_cast<size_t>(index) >= m_size) { return std::nullopt; }
+	return m_first + static_cast<size_t>(index);
+}
+
+std::optional<int64_t> PlaybackWindow::row_to_index(const size_t row) const
+{
+	if (row < m_first || row - m_first >= m_size) { return std::nullopt; }
+	return static_cast<int64_t>(row - m_first);
+}
+
+
+
+// private
+// ==================================================
+
+bool PlaybackWindow::rebuild(const size_t row)
+{
+	if (row >= this->rows()) {
+		SPDLOG_ERROR("Row {:d} is out of range ({:d} rows)", row, this->rows());
+		return false;
+	}
+	
+	m_filler.disconnect();
+	d_player.stop_playback();
+	m_first = row;
+	m_size = 0;
+	
+	// the rest is appended once the playback started
+	if (!this->append_until(row + 1)) { return false; }
+	d_player.set_index(0);
+	this->fill_until(std::min(row + AHEAD + 1, this->rows()));
+	return true;
+}
+
+void PlaybackWindow::trim(const size_t row)
+{
+	// the indices of the entries left move down, the rows they map to don't. A player that can't
+	// remove them keeps them until the window is rebuilt.
+	while (m_first + AHEAD < row && d_player.remove_media(0)) {
+		++m_first;
+		--m_size;
+	}
+}
+
+bool PlaybackWindow::append_until(const size_t end)
+{
+	const std::vector<std::filesystem::path> &paths = *m_paths;
+	while (m_first + m_size < end) {
+		const mpv_error err = d_player.append_media(paths[m_first + m_size]);
+		if (err != MPV_ERROR_SUCCESS) {
+			SPDLOG_ERROR("Failed to append mpv media: ({:d}) {:s}",
+				err, mpv_error_string(err)
+			);
+			return false;
+		}
+		++m_size;
+	}
+	return true;
+}
+
+void PlaybackWindow::fill_until(const size_t end)
+{
+	m_fillEnd = end;
+	if (m_first + m_size >= end || m_filler.connected()) { return; }
+	
+	m_filler = Glib::signal_idle().connect(sigc::mem_fun(*this, &PlaybackWindow::cb__fill));
+}
+
+bool PlaybackWindow::cb__fill(void)
+{
+	const size_t end = std::min(m_first + m_size + FILL_CHUNK, m_fillEnd);
+	if (!this->append_until(end)) { return false; }
+	
+	const bool done = (m_first + m_size >= m_fillEnd);
+	if (done) {
+		SPDLOG_DEBUG("Playback window of rows [{:d}, {:d})", m_first, m_first + m_size);
+	}
+	return !done;
+}
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cerrno>
+#include <glibmm/main.h>
+#include <momuma/spdlog.h>
+#include <sys/eventfd.h>
+#include <system_error>
+#include <unistd.h>
+
+#include "PlayerEventPump.h"
+#include "LoopMonitor.h"
+
+
+// events drained per wakeup, the player rarely has more than a few queued
+constexpr int MAX_EVENTS_PER_PUMP = 16;
+
+// wake up a bit after the stream should have ended, so its end event is already queued
+constexpr chrono::milliseconds STREAM_END_SLACK(5);
+
+// upper bound of a wakeup while playing, in case the stream doesn't end when expected
+constexpr chrono::milliseconds MAX_PLAYING_DELAY(1000);
+
+
+// public
+// ==================================================
+
+PlayerEventPump::PlayerEventPump(Backend::Player &player) :
+	d_player { player }, m_eventFd { -1 }, m_wokenUp { false },
+	m_source { }, m_burstStep { BURST_DELAYS.size() }, m_pumping { false }, m_wakeups { 0 }
+{
+	// not a semaphore, a read takes every wakeup at once
+	m_eventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (m_eventFd < 0) {
+		throw std::system_error(errno, std::generic_category(), "eventfd");
+	}
+	m_wokenUp = player.set_wakeup(
+		[fd = m_eventFd](void) -> void
+		{
+			const uint64_t one = 1;
+			// can only fail when the counter would overflow, it's readable then anyway
+			(void)!::write(fd, &one, sizeof(one));
+		}
+	);
+	if (m_wokenUp) {
+		m_source = Glib::signal_io().connect(
+			sigc::mem_fun(*this, &PlayerEventPump::cb__readable),
+			m_eventFd, Glib::IO_IN, Glib::PRIORITY_HIGH_IDLE
+		);
+		SPDLOG_DEBUG("The player wakes the event pump up");
+		return;
+	}
+	
+	SPDLOG_DEBUG("The player can't wake the event pump up, its events are polled");
+	const auto cb = sigc::mem_fun(*this, &PlayerEventPump::cb__player_event);
+	player.signal_streamStarted.connect(sigc::hide(cb));
+	player.signal_streamEnded.connect(sigc::hide(cb));
+	player.signal_stateChanged.connect(sigc::hide(sigc::hide(sigc::hide(cb))));
+}
+
+PlayerEventPump::~PlayerEventPump(void)
+{
+	if (m_wokenUp) { (void)d_player.set_wakeup(nullptr); }
+	m_source.disconnect();
+	::close(m_eventFd);
+}
+
+void PlayerEventPump::kick(void)
+{
+	if (m_wokenUp) { return; } // the events are handled as soon as they're queued
+	
+	m_burstStep = 0;
+	if (m_pumping) { return; } // rescheduled once the current drain is done
+	
+	m_source.disconnect();
+	m_source = Glib::signal_idle().connect(
+		sigc::mem_fun(*this, &PlayerEventPump::cb__pump), Glib::PRIORITY_HIGH_IDLE
+	);
+}
+
+bool PlayerEventPump::is_woken_up(void) const
+{
+	return m_wokenUp;
+}
+
+uint64_t PlayerEventPump::wakeups(void) const
+{
+	return m_wakeups;
+}
+
+
+
+// private
+// ==================================================
+
+bool PlayerEventPump::cb__readable(Glib::IOCondition)
+{
+	MONITOR_CALLBACK("PlayerEventPump::cb__readable");
+	uint64_t count = 0;
+	if (::read(m_eventFd, &count, sizeof(count)) != sizeof(count)) { return true; }
+	++m_wakeups;
+	
+	// one event per wakeup, those past the batch are left for the next iteration
+	const uint64_t handled = std::min<uint64_t>(count, MAX_EVENTS_PER_PUMP);
+	if (count > handled) {
+		const uint64_t left = count - handled;
+		(void)!::write(m_eventFd, &left, sizeof(left));
+	}
+	for (uint64_t i = 0; i < handled; ++i) {
+		d_player.handle_event();
+	}
+	return true;
+}
+
+bool PlayerEventPump::cb__pump(void)
+{
+	MONITOR_CALLBACK("PlayerEventPump::cb__pump");
+	++m_wakeups;
+	m_pumping = true;
+	for (int i = 0; i < MAX_EVENTS_PER_PUMP; ++i) {
+		d_player.handle_event();
+	}
+	m_pumping = false;
+	
+	this->schedule_next();
+	return false; // every source is a one-shot, `schedule_next()` armed a new one if needed
+}
+
+void PlayerEventPump::schedule_next(void)
+{
+	if (m_burstStep < BURST_DELAYS.size()) {
+		this->schedule(BURST_DELAYS[m_burstStep++]);
+		return;
+	}
+	if (d_player.get_state() != Backend::Player::State::PLAY) {
+		return; // nothing happens until the next command
+	}
+	
+	const std::optional remaining = this->time_until_stream_end();
+	this->schedule(std::clamp(remaining.value_or(MAX_PLAYING_DELAY) + STREAM_END_SLACK,
+		chrono::milliseconds(1), MAX_PLAYING_DELAY
+	));
+}
+
+void PlayerEventPump::schedule(const chrono::milliseconds delay)
+{
+	m_source = Glib::signal_timeout().connect(
+		sigc::mem_fun(*this, &PlayerEventPump::cb__pump),
+		static_cast<unsigned int>(delay.count()), Glib::PRIORITY_HIGH_IDLE
+	);
+}
+
+auto PlayerEventPump::time_until_stream_end(void) -> std::optional<chrono::milliseconds>
+{
+	mpv_error errPos, errDur;
+	const chrono::microseconds position = d_player.get_position(errPos);
+	const chrono::microseconds duration = d_player.get_duration(errDur);
+	if (errPos != MPV_ERROR_SUCCESS || errDur != MPV_ERROR_SUCCESS) {
+		return std::nullopt;
+	}
+	return chrono::duration_cast<chrono::milliseconds>(duration - position);
+}
+
+void PlayerEventPump::cb__player_event(void)
+{
+	m_burstStep = 0;
+}
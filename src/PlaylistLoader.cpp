@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cassert>
+#include <momuma/spdlog.h>
+
+#include "PlaylistLoader.h"
+
+
+// public
+// ==================================================
+
+PlaylistLoader::PlaylistLoader(Gui::PlaylistNotebook &notebook, MediaProber &prober,
+	TaskScheduler &scheduler
+) :
+	d_notebook { notebook }, d_prober { prober }, d_scheduler { scheduler },
+	m_loading { }
+{
+}
+
+PlaylistLoader::~PlaylistLoader(void)
+{
+	// the tasks refer to the loader, they must not outlive it
+	const std::vector<PageId> pages(m_loading.begin(), m_loading.end());
+	for (const PageId page : pages) {
+		d_scheduler.cancel_page(page);
+	}
+}
+
+void PlaylistLoader::load(const PageId page, Paths paths, RowLookup lookup)
+{
+	assert(!this->is_loading(page));
+	if (!paths || paths->empty()) {
+		m_signal_loaded.emit(page);
+		return;
+	}
+	
+	m_loading.insert(page);
+	d_scheduler.spawn(this->load_task(page, std::move(paths), std::move(lookup)),
+		TaskScheduler::Priority::DEFAULT, d_scheduler.page_token(page)
+	);
+}
+
+bool PlaylistLoader::is_loading(const PageId page) const
+{
+	return m_loading.contains(page);
+}
+
+auto PlaylistLoader::signal_loaded(void) -> sigc::signal<void(PageId)>
+{
+	return m_signal_loaded;
+}
+
+
+
+// private
+// ==================================================
+
+TaskScheduler::Task PlaylistLoader::load_task(const PageId page,
+	const Paths paths, const RowLookup lookup
+) {
+	// forgets the page however the task ends, cancelled or not
+	struct Loading
+	{
+		std::unordered_set<PageId> &set;
+		PageId id;
+		~Loading(void) { set.erase(id); }
+	};
+	const Loading loading { m_loading, page };
+	
+	const Glib::ustring title = d_notebook.get_page(page).get_name();
+	int shownPercent = this->show_progress(page, title, 0, paths->size());
+	
+	std::vector<Gui::NotebookRowData> rows;
+	rows.reserve(BATCH_ROWS);
+	for (size_t first = 0; first < paths->size(); first += BATCH_ROWS) {
+		co_await TaskScheduler::Yield{};
+		
+		rows.clear();
+		std::vector<MediaProber::Request> requests;
+		const size_t end = std::min(first + BATCH_ROWS, paths->size());
+		for (size_t row = first; row < end; ++row) {
+			const std::filesystem::path &path = (*paths)[row];
+			std::optional<Gui::NotebookRowData> data = lookup(path);
+			if (!data.has_value()) {
+				// shows a placeholder until the duration is probed
+				requests.push_back({ row, path });
+				data = Gui::NotebookRowData { path.filename().string(),
+					Gui::NotebookRowData::UNKNOWN_DURATION
+				};
+			}
+			rows.push_back(std::move(data.value()));
+		}
+		d_notebook.get_page(page).extend_rows(rows);
+		d_prober.probe(page, std::move(requests));
+		
+		const size_t percent = end * 100 / paths->size();
+		if (static_cast<int>(percent) != shownPercent) {
+			shownPercent = this->show_progress(page, title, end, paths->size());
+		}
+	}
+	
+	// the page keeps its original title
+	Pango::AttrList attrs;
+	d_notebook.page_rename(page, title, attrs);
+	SPDLOG_DEBUG("Loaded the {:d} rows of '{:s}'", paths->size(), title);
+	m_loading.erase(page);
+	m_signal_loaded.emit(page);
+}
+
+int PlaylistLoader::show_progress(const PageId page,
+	const Glib::ustring &title, const size_t loaded, const size_t total
+) {
+	const int percent = static_cast<int>(loaded * 100 / total);
+	Pango::AttrList attrs;
+	d_notebook.page_rename(page, fmt::format("{:s} ({:d}%)", title.raw(), percent), attrs);
+	return percent;
+}
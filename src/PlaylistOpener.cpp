@@ -0,0 +1,119 @@
+#include <iterator>
+#include <memory>
+#include <momuma/spdlog.h>
+
+#include "LoopMonitor.h"
+#include "PlaylistOpener.h"
+
+
+// public
+// ==================================================
+
+PlaylistOpener::PlaylistOpener(Gui::PlaylistNotebook &notebook, PageMap &pages,
+	DatabaseService &database, MetadataCache &cache, MediaProber &prober,
+	PlaylistLoader &loader
+) :
+	d_notebook { notebook }, d_pages { pages }, d_database { database }, d_cache { cache },
+	d_prober { prober }, d_loader { loader }
+{
+	d_notebook.signal_page_remove().connect(
+		sigc::mem_fun(*this, &PlaylistOpener::cb__page_remove)
+	);
+	d_prober.signal_probed().connect(
+		sigc::mem_fun(*this, &PlaylistOpener::cb__durations_probed)
+	);
+}
+
+PageId PlaylistOpener::open(const Glib::ustring &playlist)
+{
+	const PageId id = d_notebook.page_create(playlist);
+	d_pages[id] = PageData { playlist, false, nullptr, { }, 0, std::nullopt, std::nullopt };
+	this->read(id);
+	return id;
+}
+
+void PlaylistOpener::read(const PageId id)
+{
+	PageData &data = d_pages.at(id);
+	
+	// the paths are read on the database's thread, the rows are made and shown a few at a time
+	// by the loader once they're all read
+	auto paths = std::make_shared<std::vector<fs::path>>();
+	data.query = d_database.get_media_paths(data.name,
+		[paths](std::vector<fs::path> &&chunk) -> void
+		{
+			paths->insert(paths->end(), std::make_move_iterator(chunk.begin()),
+				std::make_move_iterator(chunk.end())
+			);
+		},
+		[this, id, paths](const bool success) -> void
+		{
+			if (!success) {
+				SPDLOG_ERROR("Failed to get all media paths");
+			}
+			this->load_rows(id, std::move(*paths));
+		}
+	);
+}
+
+void PlaylistOpener::load_rows(const PageId id, std::vector<fs::path> &&paths)
+{
+	PageData &page = d_pages.at(id);
+	page.pathsMemory = paths_memory(paths);
+	page.paths = std::make_shared<const std::vector<fs::path>>(std::move(paths));
+	
+	// durations are taken from the cache when possible, otherwise they're probed in the
+	// background and the rows show a placeholder until then
+	d_loader.load(id, page.paths,
+		[this](const fs::path &p) -> std::optional<Gui::NotebookRowData>
+		{
+			const std::optional key = MetadataCache::make_key(p);
+			if (!key.has_value()) { return std::nullopt; }
+			
+			std::optional entry = d_cache.find(key.value());
+			if (!entry.has_value()) { return std::nullopt; }
+			return Gui::NotebookRowData { std::move(entry->name),
+				chrono::duration_cast<chrono::seconds>(entry->duration)
+			};
+		}
+	);
+}
+
+
+
+// private
+// ==================================================
+
+void PlaylistOpener::cb__page_remove(const PageId id)
+{
+	const auto it = d_pages.find(id);
+	if (it == d_pages.end()) { return; }
+	
+	it->second.query.cancel();
+	d_pages.erase(it);
+}
+
+void PlaylistOpener::cb__durations_probed(const PageId id,
+	const std::vector<MediaProber::Probed> &batch
+) {
+	MONITOR_CALLBACK("PlaylistOpener::cb__durations_probed");
+	SPDLOG_TRACE("{:s}: {:d} durations", SPDLOG_FUNCTION, batch.size());
+	
+	std::vector<std::pair<size_t, chrono::seconds>> durations;
+	durations.reserve(batch.size());
+	for (const MediaProber::Probed &probed : batch) {
+		durations.emplace_back(probed.row,
+			chrono::duration_cast<chrono::seconds>(probed.duration)
+		);
+		// a failed probe isn't cached, so the file is probed again next time
+		if (probed.duration <= chrono::milliseconds(0)) { continue; }
+		
+		std::optional key = MetadataCache::make_key(probed.path);
+		if (key.has_value()) {
+			d_cache.insert(key.value(), MetadataCache::Entry {
+				probed.duration, probed.path.filename().string()
+			});
+		}
+	}
+	d_notebook.get_page(id).set_durations(durations);
+}
@@ -0,0 +1,37 @@
+#include <momuma/spdlog.h>
+
+#include "RowPlayer.h"
+
+
+// public
+// ==================================================
+
+RowPlayer::RowPlayer(Gui::PlaylistNotebook &notebook, PageMap &pages, Backend::Player &player,
+	PlaybackWindow &playback, PlayerEventPump &pump
+) :
+	d_notebook { notebook }, d_pages { pages }, d_player { player }, d_playback { playback },
+	d_pump { pump }
+{
+}
+
+void RowPlayer::play(const PageId page, PlaybackWindow::Paths paths, const size_t row)
+{
+	// unmark the previously played song
+	if (d_pages.has_playing_page()) {
+		d_notebook.get_page(d_pages.get_playing()).set_playing_row(std::nullopt);
+	}
+	
+	// only a window of the page around the row is loaded in the player
+	if (page != d_playback.page() || d_player.playlist_empty()) {
+		spdlog::trace("1) Row activated");
+		(void)d_playback.load(page, std::move(paths), row);
+	}
+	else {
+		(void)d_playback.jump(row);
+	}
+	
+	d_player.set_play(true);
+	d_pump.kick();
+	d_notebook.get_page(page).set_playing_row(row);
+	d_pages.set_playing(page);
+}
@@ -0,0 +1,336 @@
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <momuma/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SessionSnapshot.h"
+
+
+constexpr char FILE_MAGIC[8] = { 'M', 'M', 'G', 'S', 'E', 'S', 'S', '\0' };
+constexpr uint32_t FILE_VERSION = 1;
+// marks a missing index
+constexpr uint32_t NONE = UINT32_MAX;
+
+struct FileHeader
+{
+	char magic[sizeof(FILE_MAGIC)];
+	uint32_t version;
+	uint32_t pageCount;
+	uint32_t rowCount;
+	uint32_t currentPage;
+	uint32_t playingPage;
+	uint32_t playingRow;
+	uint64_t stringsSize;
+	double volume; // NaN when unknown
+};
+
+struct SessionSnapshot::PageRecord
+{
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t firstRow;
+	uint32_t rowCount;
+	uint32_t topRow;
+};
+
+struct SessionSnapshot::RowRecord
+{
+	uint32_t pathOffset;
+	uint32_t pathLength;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	int32_t duration; // seconds, negative when unknown
+};
+
+static_assert(sizeof(FileHeader) == 48);
+
+
+[[nodiscard]] static inline uint32_t to_record(const std::optional<size_t> index)
+{
+	return index.has_value() ? static_cast<uint32_t>(index.value()) : NONE;
+}
+
+[[nodiscard]] static inline std::optional<size_t> from_record(const uint32_t index)
+{
+	return index == NONE ? std::nullopt : std::optional<size_t>(index);
+}
+
+
+// Builder
+// ==================================================
+
+SessionSnapshot::Builder::Builder(void) :
+	m_pages { }, m_rows { }, m_strings { },
+	m_current { }, m_playing { }, m_volume { }
+{
+}
+
+SessionSnapshot::Builder::~Builder(void) = default;
+SessionSnapshot::Builder::Builder(Builder&&) = default;
+auto SessionSnapshot::Builder::operator=(Builder&&) -> Builder& = default;
+
+void SessionSnapshot::Builder::add_page(const std::string_view name,
+	const std::optional<size_t> topRow
+) {
+	const auto [offset, length] = this->add_string(name);
+	m_pages.push_back({ offset, length, static_cast<uint32_t>(m_rows.size()), 0,
+		to_record(topRow)
+	});
+}
+
+void SessionSnapshot::Builder::add_row(const std::string_view path,
+	const std::string_view name, const chrono::seconds duration
+) {
+	assert(!m_pages.empty());
+	
+	RowRecord record { };
+	std::tie(record.pathOffset, record.pathLength) = this->add_string(path);
+	std::tie(record.nameOffset, record.nameLength) = this->add_string(name);
+	record.duration = duration < chrono::seconds(0) ? -1
+		: static_cast<int32_t>(std::min<chrono::seconds::rep>(duration.count(), INT32_MAX));
+	m_rows.push_back(record);
+	++m_pages.back().rowCount;
+}
+
+void SessionSnapshot::Builder::copy_page(const SessionSnapshot &snapshot, const size_t page)
+{
+	const Page source = snapshot.page(page);
+	this->add_page(source.name, source.topRow);
+	for (size_t row = 0; row < source.rows; ++row) {
+		const Row r = snapshot.row(page, row);
+		this->add_row(r.path, r.name, r.duration);
+	}
+}
+
+void SessionSnapshot::Builder::mark_current(void)
+{
+	assert(!m_pages.empty());
+	m_current = m_pages.size() - 1;
+}
+
+void SessionSnapshot::Builder::mark_playing(const size_t row)
+{
+	assert(!m_pages.empty());
+	m_playing = { m_pages.size() - 1, row };
+}
+
+void SessionSnapshot::Builder::set_volume(const double volume)
+{
+	m_volume = volume;
+}
+
+size_t SessionSnapshot::Builder::pages(void) const
+{
+	return m_pages.size();
+}
+
+bool SessionSnapshot::Builder::write(const fs::path &file) const
+{
+	FileHeader header { };
+	std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+	header.version = FILE_VERSION;
+	header.pageCount = static_cast<uint32_t>(m_pages.size());
+	header.rowCount = static_cast<uint32_t>(m_rows.size());
+	header.currentPage = to_record(m_current);
+	header.playingPage = m_playing.has_value() ? to_record(m_playing->first) : NONE;
+	header.playingRow = m_playing.has_value() ? to_record(m_playing->second) : NONE;
+	header.stringsSize = m_strings.size();
+	header.volume = m_volume.value_or(std::numeric_limits<double>::quiet_NaN());
+	
+	// write to a temporary file, then replace the old one
+	std::error_code err;
+	fs::create_directories(file.parent_path(), err);
+	const fs::path tmpFile = fs::path(file).concat(".tmp");
+	{
+		std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(m_pages.data()),
+			static_cast<std::streamsize>(m_pages.size() * sizeof(PageRecord))
+		);
+		out.write(reinterpret_cast<const char*>(m_rows.data()),
+			static_cast<std::streamsize>(m_rows.size() * sizeof(RowRecord))
+		);
+		out.write(m_strings.data(), static_cast<std::streamsize>(m_strings.size()));
+		if (!out.flush()) {
+			SPDLOG_ERROR("Failed to write session '{:s}'", tmpFile.string());
+			fs::remove(tmpFile, err);
+			return false;
+		}
+	}
+	
+	// a mapping of the old file stays valid, it keeps the replaced file alive
+	fs::rename(tmpFile, file, err);
+	if (err) {
+		SPDLOG_ERROR("Failed to replace session '{:s}': {:s}",
+			file.string(), err.message()
+		);
+		fs::remove(tmpFile, err);
+		return false;
+	}
+	
+	SPDLOG_INFO("Saved session ({:d} pages, {:d} rows)", m_pages.size(), m_rows.size());
+	return true;
+}
+
+auto SessionSnapshot::Builder::add_string(const std::string_view s) -> std::pair<uint32_t, uint32_t>
+{
+	assert(m_strings.size() + s.size() < UINT32_MAX);
+	const auto offset = static_cast<uint32_t>(m_strings.size());
+	m_strings.append(s);
+	return { offset, static_cast<uint32_t>(s.size()) };
+}
+
+
+
+// SessionSnapshot - public
+// ==================================================
+
+SessionSnapshot::SessionSnapshot(fs::path file) :
+	m_file { std::move(file) },
+	m_map { }, m_pages { }, m_rows { }, m_strings { },
+	m_current { }, m_playing { }, m_volume { }
+{
+	this->map_file();
+}
+
+SessionSnapshot::~SessionSnapshot(void)
+{
+	this->close();
+}
+
+bool SessionSnapshot::empty(void) const
+{
+	return m_map.empty();
+}
+
+const fs::path& SessionSnapshot::file(void) const
+{
+	return m_file;
+}
+
+size_t SessionSnapshot::page_count(void) const
+{
+	return m_pages.size();
+}
+
+SessionSnapshot::Page SessionSnapshot::page(const size_t page) const
+{
+	const PageRecord &record = m_pages[page];
+	// a corrupted file must never make us read outside of the mapping
+	const bool valid = static_cast<size_t>(record.firstRow) + record.rowCount <= m_rows.size();
+	return Page { this->string(record.nameOffset, record.nameLength),
+		valid ? record.rowCount : 0, from_record(record.topRow)
+	};
+}
+
+SessionSnapshot::Row SessionSnapshot::row(const size_t page, const size_t row) const
+{
+	const RowRecord &record = m_rows[m_pages[page].firstRow + row];
+	return Row { this->string(record.pathOffset, record.pathLength),
+		this->string(record.nameOffset, record.nameLength),
+		chrono::seconds(record.duration)
+	};
+}
+
+std::optional<size_t> SessionSnapshot::current_page(void) const
+{
+	return m_current;
+}
+
+std::optional<std::pair<size_t, size_t>> SessionSnapshot::playing(void) const
+{
+	return m_playing;
+}
+
+std::optional<double> SessionSnapshot::volume(void) const
+{
+	return m_volume;
+}
+
+void SessionSnapshot::close(void)
+{
+	if (m_map.empty()) { return; }
+	
+	::munmap(const_cast<std::byte*>(m_map.data()), m_map.size());
+	m_map = { };
+	m_pages = { };
+	m_rows = { };
+	m_strings = { };
+}
+
+
+
+// SessionSnapshot - private
+// ==================================================
+
+bool SessionSnapshot::map_file(void)
+{
+	static_assert(sizeof(PageRecord) == 20, "the file layout mustn't depend on padding");
+	static_assert(sizeof(RowRecord) == 20, "the file layout mustn't depend on padding");
+	
+	const int fd = ::open(m_file.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) { return false; }
+	
+	struct stat st;
+	void *addr = MAP_FAILED;
+	if (::fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(FileHeader))) {
+		const auto size = static_cast<size_t>(st.st_size);
+		addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	::close(fd);
+	
+	if (addr == MAP_FAILED) {
+		SPDLOG_WARN("Failed to map session '{:s}'", m_file.string());
+		return false;
+	}
+	m_map = std::span(static_cast<const std::byte*>(addr), static_cast<size_t>(st.st_size));
+	
+	FileHeader header;
+	std::memcpy(&header, m_map.data(), sizeof(header));
+	
+	const bool valid = std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0
+		&& header.version == FILE_VERSION
+		&& m_map.size() == sizeof(FileHeader) + header.pageCount * sizeof(PageRecord)
+			+ header.rowCount * sizeof(RowRecord) + header.stringsSize;
+	if (!valid) {
+		SPDLOG_WARN("Ignoring invalid session '{:s}'", m_file.string());
+		this->close();
+		return false;
+	}
+	
+	const std::byte *const pages = m_map.data() + sizeof(FileHeader);
+	const std::byte *const rows = pages + header.pageCount * sizeof(PageRecord);
+	const std::byte *const strings = rows + header.rowCount * sizeof(RowRecord);
+	m_pages = std::span(reinterpret_cast<const PageRecord*>(pages), header.pageCount);
+	m_rows = std::span(reinterpret_cast<const RowRecord*>(rows), header.rowCount);
+	m_strings = std::span(reinterpret_cast<const char*>(strings), header.stringsSize);
+	
+	m_current = from_record(header.currentPage);
+	if (m_current.has_value() && m_current.value() >= m_pages.size()) { m_current.reset(); }
+	if (header.playingPage < m_pages.size()
+		&& header.playingRow < this->page(header.playingPage).rows
+	) {
+		m_playing = { header.playingPage, header.playingRow };
+	}
+	if (!std::isnan(header.volume)) { m_volume = header.volume; }
+	
+	SPDLOG_INFO("Mapped session '{:s}' ({:d} pages, {:d} rows)",
+		m_file.string(), m_pages.size(), m_rows.size()
+	);
+	return true;
+}
+
+std::string_view SessionSnapshot::string(const uint32_t offset, const uint32_t length) const
+{
+	// a corrupted file must never make us read outside of the mapping
+	if (static_cast<size_t>(offset) + length > m_strings.size()) {
+		return { };
+	}
+	return std::string_view(m_strings.data() + offset, length);
+}
@@ -0,0 +1,67 @@
+#include <array>
+#include <momuma/spdlog.h>
+#include <optional>
+
+#include "Startup.h"
+
+
+namespace Startup
+{
+
+static Clock::time_point s_begin;
+static std::array<std::optional<Clock::duration>, static_cast<size_t>(Phase::COUNT)> s_reached;
+
+[[nodiscard]] static constexpr const char* phase_name(const Phase phase)
+{
+	switch (phase)
+	{
+	case Phase::INIT: return "init";
+	case Phase::BACKEND: return "backend";
+	case Phase::FIRST_FRAME: return "first frame";
+	case Phase::INTERACTIVE: return "interactive";
+	default: return "?";
+	}
+}
+
+[[nodiscard]] static inline double to_ms(const Clock::duration d)
+{
+	return chrono::duration<double, std::milli>(d).count();
+}
+
+void begin(void)
+{
+	s_begin = Clock::now();
+	s_reached.fill(std::nullopt);
+}
+
+void reach(const Phase phase)
+{
+	std::optional<Clock::duration> &reached = s_reached[static_cast<size_t>(phase)];
+	if (reached.has_value()) { return; }
+	
+	reached = Clock::now() - s_begin;
+	SPDLOG_DEBUG("Startup: {:s} after {:.1f} ms", phase_name(phase), to_ms(reached.value()));
+	
+	if (phase == Phase::INTERACTIVE) {
+		const auto at = [](const Phase p) -> double
+		{
+			return to_ms(s_reached[static_cast<size_t>(p)].value_or(Clock::duration()));
+		};
+		// a single line, to compare between builds
+		SPDLOG_INFO("Startup: init {:.1f} ms, backend {:.1f} ms, first frame {:.1f} ms,"
+			" interactive {:.1f} ms",
+			at(Phase::INIT), at(Phase::BACKEND), at(Phase::FIRST_FRAME),
+			at(Phase::INTERACTIVE)
+		);
+	}
+	else if (has_reached(Phase::BACKEND) && has_reached(Phase::FIRST_FRAME)) {
+		reach(Phase::INTERACTIVE);
+	}
+}
+
+bool has_reached(const Phase phase)
+{
+	return s_reached[static_cast<size_t>(phase)].has_value();
+}
+
+}
@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cassert>
+#include <gdkmm/frameclock.h>
+#include <glibmm/main.h>
+#include <momuma/spdlog.h>
+
+#include "TaskScheduler.h"
+#include "LoopMonitor.h"
+
+
+// TaskScheduler::CancelToken
+// ==================================================
+
+TaskScheduler::CancelToken::CancelToken(void) :
+	m_cancelled { std::make_shared<bool>(false) }
+{
+}
+
+bool TaskScheduler::CancelToken::is_cancelled(void) const
+{
+	return *m_cancelled;
+}
+
+void TaskScheduler::CancelToken::cancel(void)
+{
+	*m_cancelled = true;
+}
+
+
+
+// TaskScheduler::Task
+// ==================================================
+
+auto TaskScheduler::Task::promise_type::get_return_object(void) -> Task
+{
+	return Task(Handle::from_promise(*this));
+}
+
+void TaskScheduler::Task::promise_type::unhandled_exception(void)
+{
+	// the task ends, the other ones keep running
+	try {
+		throw;
+	}
+	catch (const std::exception &ex) {
+		SPDLOG_ERROR("Task failed: {:s}", ex.what());
+	}
+	catch (...) {
+		SPDLOG_ERROR("Task failed with an unknown exception");
+	}
+}
+
+bool TaskScheduler::Task::promise_type::YieldAwaiter::await_ready(void) const
+{
+	return scheduler == nullptr || !scheduler->budget_spent();
+}
+
+auto TaskScheduler::Task::promise_type::await_transform(Yield) const -> YieldAwaiter
+{
+	return YieldAwaiter { scheduler };
+}
+
+TaskScheduler::Task::Task(Task &&other) :
+	m_handle { std::exchange(other.m_handle, nullptr) }
+{
+}
+
+auto TaskScheduler::Task::operator=(Task &&other) -> Task&
+{
+	if (this != &other) {
+		if (m_handle) { m_handle.destroy(); }
+		m_handle = std::exchange(other.m_handle, nullptr);
+	}
+	return *this;
+}
+
+TaskScheduler::Task::~Task(void)
+{
+	if (m_handle) { m_handle.destroy(); }
+}
+
+TaskScheduler::Task::Task(const Handle handle) :
+	m_handle { handle }
+{
+}
+
+
+
+// TaskScheduler - public
+// ==================================================
+
+TaskScheduler::TaskScheduler(Gtk::Widget &widget) :
+	d_widget { widget },
+	m_queues { }, m_pageTokens { }, m_source { }, m_tick { 0 }, m_unmap { }, m_deadline { },
+	m_frame { -1 }, m_spent { }, m_running { false }
+{
+	m_unmap = d_widget.signal_unmap().connect(sigc::mem_fun(*this, &TaskScheduler::cb__unmap));
+}
+
+TaskScheduler::~TaskScheduler(void)
+{
+	m_source.disconnect();
+	m_unmap.disconnect();
+	if (m_tick != 0) { d_widget.remove_tick_callback(m_tick); }
+}
+
+void TaskScheduler::spawn(Task task, const Priority priority, CancelToken token)
+{
+	assert(task.m_handle && !task.m_handle.done());
+	task.m_handle.promise().scheduler = this;
+	m_queues.at(static_cast<size_t>(priority)).push_back({ std::move(task), std::move(token) });
+	this->schedule();
+}
+
+auto TaskScheduler::page_token(const PageId page) -> CancelToken
+{
+	return m_pageTokens[page];
+}
+
+void TaskScheduler::cancel_page(const PageId page)
+{
+	const auto iter = m_pageTokens.find(page);
+	if (iter == m_pageTokens.end()) { return; }
+	
+	iter->second.cancel();
+	m_pageTokens.erase(iter);
+	
+	// when called from a task, the tasks are dropped once it returns
+	if (!m_running) {
+		this->drop_cancelled();
+	}
+}
+
+size_t TaskScheduler::pending(void) const
+{
+	size_t count = 0;
+	for (const std::deque<Entry> &queue : m_queues) {
+		count += queue.size();
+	}
+	return count;
+}
+
+bool TaskScheduler::budget_spent(void) const
+{
+	return Clock::now() >= m_deadline;
+}
+
+
+
+// TaskScheduler - private
+// ==================================================
+
+void TaskScheduler::schedule(void)
+{
+	if (m_source.connected() || m_tick != 0) { return; }
+	
+	// below the redraws, a frame is only delayed by one budget at most
+	m_source = Glib::signal_idle().connect(
+		sigc::mem_fun(*this, &TaskScheduler::cb__run), Glib::PRIORITY_DEFAULT_IDLE
+	);
+}
+
+bool TaskScheduler::cb__run(void)
+{
+	MONITOR_CALLBACK("TaskScheduler::cb__run");
+	// without frames, e.g while the widget is hidden, each run gets a budget of its own
+	const Glib::RefPtr<Gdk::FrameClock> frameClock = d_widget.get_mapped() ?
+		d_widget.get_frame_clock() : Glib::RefPtr<Gdk::FrameClock>();
+	const gint64 frame = frameClock ? frameClock->get_frame_counter() : -1;
+	if (!frameClock || frame != m_frame) {
+		m_frame = frame;
+		m_spent = Clock::duration::zero();
+	}
+	
+	const Clock::time_point begin = Clock::now();
+	m_deadline = this->compute_deadline(FRAME_BUDGET - m_spent);
+	
+	while (std::deque<Entry> *queue = this->next_queue()) {
+		Entry &entry = queue->front();
+		bool finished = entry.token.is_cancelled();
+		if (!finished) {
+			// spawning tasks only appends to the queues, so `entry` stays valid
+			m_running = true;
+			entry.task.m_handle.resume();
+			m_running = false;
+			finished = entry.task.m_handle.done() || entry.token.is_cancelled();
+		}
+		
+		if (finished) {
+			queue->pop_front();
+		}
+		// an unfinished task only returns when it yielded
+		if (!finished || this->budget_spent()) { break; }
+	}
+	
+	this->drop_cancelled();
+	m_spent += Clock::now() - begin;
+	if (this->pending() == 0) { return false; }
+	if (!frameClock || m_spent < FRAME_BUDGET) { return true; }
+	
+	// the idle source would run again right away, within the same frame
+	m_tick = d_widget.add_tick_callback(sigc::mem_fun(*this, &TaskScheduler::cb__next_frame));
+	return false;
+}
+
+bool TaskScheduler::cb__next_frame(const Glib::RefPtr<Gdk::FrameClock>&)
+{
+	m_tick = 0;
+	this->schedule();
+	return false;
+}
+
+void TaskScheduler::cb__unmap(void)
+{
+	if (m_tick == 0) { return; }
+	
+	d_widget.remove_tick_callback(m_tick);
+	m_tick = 0;
+	this->schedule();
+}
+
+auto TaskScheduler::compute_deadline(const Clock::duration budget) const -> Clock::time_point
+{
+	const Clock::time_point now = Clock::now();
+	Clock::time_point deadline = now + budget;
+	
+	const Glib::RefPtr<const Gdk::FrameClock> frameClock = d_widget.get_frame_clock();
+	if (frameClock) {
+		// times of the frame clock are in microseconds, from `g_get_monotonic_time()`
+		const gint64 frameTime = frameClock->get_frame_time();
+		gint64 refreshInterval = 0, presentationTime = 0;
+		frameClock->get_refresh_info(frameTime, refreshInterval, presentationTime);
+		
+		const gint64 nextFrame = (presentationTime > 0) ?
+			presentationTime : frameTime + refreshInterval;
+		const gint64 untilNextFrame = nextFrame - g_get_monotonic_time();
+		// otherwise the clock is idle, nothing is being drawn
+		if (untilNextFrame > 0) {
+			const std::chrono::microseconds untilNext(untilNextFrame);
+			deadline = std::min(deadline, now + untilNext);
+		}
+	}
+	return std::max(deadline, now + MIN_BUDGET);
+}
+
+void TaskScheduler::drop_cancelled(void)
+{
+	for (std::deque<Entry> &queue : m_queues) {
+		std::erase_if(queue,
+			[](const Entry &entry) -> bool { return entry.token.is_cancelled(); }
+		);
+	}
+}
+
+auto TaskScheduler::next_queue(void) -> std::deque<Entry>*
+{
+	for (std::deque<Entry> &queue : m_queues) {
+		if (!queue.empty()) { return &queue; }
+	}
+	return nullptr;
+}
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <momuma/spdlog.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Trace.h"
+
+
+namespace Trace
+{
+
+struct Event
+{
+	const char *name;
+	Clock::time_point begin;
+	Clock::duration duration;
+};
+
+// spans of a thread, only written by that thread
+struct Buffer
+{
+	size_t tid;
+	std::string name; // guarded by `s_mutex`
+	std::unique_ptr<Event[]> events;
+	// number of spans ever recorded, the last `BUFFER_SPANS` are kept
+	std::atomic<size_t> count;
+};
+
+// the buffers outlive their thread, so the spans of the threads that ended are kept
+static std::mutex s_mutex;
+static std::vector<std::unique_ptr<Buffer>> s_buffers;
+static const Clock::time_point s_epoch = Clock::now();
+
+static thread_local Buffer *t_buffer = nullptr;
+
+
+[[nodiscard]] static Buffer& thread_buffer(void)
+{
+	if (t_buffer != nullptr) { return *t_buffer; }
+	
+	auto buffer = std::make_unique<Buffer>();
+	buffer->events = std::make_unique<Event[]>(BUFFER_SPANS);
+	buffer->count = 0;
+	
+	const std::lock_guard lock(s_mutex);
+	buffer->tid = s_buffers.size() + 1;
+	buffer->name = fmt::format("thread {:d}", buffer->tid);
+	t_buffer = s_buffers.emplace_back(std::move(buffer)).get();
+	return *t_buffer;
+}
+
+[[nodiscard]] static inline double to_us(const Clock::duration d)
+{
+	return chrono::duration<double, std::micro>(d).count();
+}
+
+void record(const char *const name, const Clock::time_point begin, const Clock::time_point end)
+{
+	Buffer &buffer = thread_buffer();
+	const size_t count = buffer.count.load(std::memory_order_relaxed);
+	buffer.events[count % BUFFER_SPANS] = Event { name, begin, end - begin };
+	buffer.count.store(count + 1, std::memory_order_release);
+}
+
+void set_thread_name(const char *const name)
+{
+	Buffer &buffer = thread_buffer();
+	const std::lock_guard lock(s_mutex);
+	buffer.name = name;
+}
+
+bool write_chrome_json(const fs::path &file)
+{
+	std::ofstream out(file, std::ios::trunc);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	
+	size_t spans = 0;
+	{
+		const std::lock_guard lock(s_mutex);
+		bool first = true;
+		for (const std::unique_ptr<Buffer> &buffer : s_buffers) {
+			out << (first ? "" : ",\n") << fmt::format(
+				R"({{"ph":"M","name":"thread_name","pid":1,"tid":{:d},)"
+				R"("args":{{"name":"{:s}"}}}})",
+				buffer->tid, buffer->name
+			);
+			first = false;
+			
+			const size_t count = buffer->count.load(std::memory_order_acquire);
+			const size_t begin = count > BUFFER_SPANS ? count - BUFFER_SPANS : 0;
+			for (size_t i = begin; i < count; ++i) {
+				const Event &event = buffer->events[i % BUFFER_SPANS];
+				out << ",\n" << fmt::format(
+					R"({{"ph":"X","name":"{:s}","pid":1,"tid":{:d},)"
+					R"("ts":{:.3f},"dur":{:.3f}}})",
+					event.name, buffer->tid, to_us(event.begin - s_epoch),
+					to_us(event.duration)
+				);
+			}
+			spans += count - begin;
+		}
+	}
+	out << "\n]}\n";
+	
+	if (!out.flush()) {
+		SPDLOG_ERROR("Failed to write the trace to '{:s}'", file.string());
+		return false;
+	}
+	SPDLOG_INFO("Wrote {:d} spans to '{:s}'", spans, file.string());
+	return true;
+}
+
+void write_from_env(void)
+{
+	const char *const file = std::getenv(FILE_ENV);
+	if (file == nullptr || *file == '\0') { return; }
+
+#if MOMUMA_GTK_TRACING
+	(void)write_chrome_json(file);
+#else
+	SPDLOG_WARN("{:s} is set, but this build doesn't record spans (see the `tracing` option)",
+		FILE_ENV
+	);
+#endif
+}
+
+}
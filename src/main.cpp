@@ -1,6 +1,8 @@
 #include <momuma/spdlog.h>
 
 #include "Application.h"
+#include "Startup.h"
+#include "Trace.h"
 
 
 namespace MomumaGtk
@@ -11,6 +13,9 @@ namespace MomumaGtk
 
 int main(int argc, char **argv)
 {
+	Startup::begin();
+	TRACE_THREAD_NAME("main");
+	
 	bindtextdomain(GETTEXT_PACKAGE, PACKAGE_LOCALEDIR);
 	bind_textdomain_codeset(GETTEXT_PACKAGE, "UTF-8");
 	textdomain(GETTEXT_PACKAGE);
@@ -21,13 +26,22 @@ int main(int argc, char **argv)
 	if (!Momuma::init()) {
 		SPDLOG_CRITICAL("Failed to initiate Momuma");
 	}
-	Application app;
-	
-	// Gtk causes the UI to mirror whenever the locale (or `LANGUAGE` env
-	// variable) is set to a RTL language.
-	// Needs to be called after the Gtk::Application is created.
-	Gtk::Widget::set_default_direction(Gtk::TEXT_DIR_LTR);
-	
-	MomumaGtk::app = &app;
-	return app.run(argc, argv);
+	Startup::reach(Startup::Phase::INIT);
+	int status;
+	{
+		// the backend is created in the background, see `Application::cb__backend_ready()`
+		Application app;
+		
+		// Gtk causes the UI to mirror whenever the locale (or `LANGUAGE` env
+		// variable) is set to a RTL language.
+		// Needs to be called after the Gtk::Application is created.
+		Gtk::Widget::set_default_direction(Gtk::TEXT_DIR_LTR);
+		
+		MomumaGtk::app = &app;
+		status = app.run(argc, argv);
+		MomumaGtk::app = nullptr;
+	}
+	// once the application is destroyed, along with the threads recording spans
+	Trace::write_from_env();
+	return status;
 }
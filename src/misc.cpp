@@ -1,3 +1,4 @@
+#include <cassert>
 #include <fmt/format.h>
 #include <glibmm/miscutils.h>
 #include <gtkmm/container.h>
@@ -10,17 +11,32 @@ namespace Utils
 {
 
 std::string time_to_ui_string(const std::chrono::seconds time)
+{
+	char buffer[32];
+	const size_t length = time_to_ui_string(time, buffer);
+	return std::string(buffer, length);
+}
+
+size_t time_to_ui_string(const std::chrono::seconds time, const std::span<char> buffer)
 {
 	namespace chrono = std::chrono;
+	assert(!buffer.empty());
 	const auto hours = chrono::duration_cast<chrono::hours>(time);
 	const auto minutes = chrono::duration_cast<chrono::minutes>(time) - hours;
 	const auto seconds = chrono::duration_cast<chrono::seconds>(time) - hours - minutes;
 	
-	std::string s;
-	if (hours > chrono::hours(0)) {
-		s += fmt::format("{:d}:", hours.count());
-	}
-	return s + fmt::format("{:02d}:{:02d}", minutes.count(), seconds.count());
+	const size_t maxLength = buffer.size() - 1;
+	fmt::format_to_n_result<char*> res = (hours > chrono::hours(0)) ?
+		fmt::format_to_n(buffer.data(), maxLength, "{:d}:{:02d}:{:02d}",
+			hours.count(), minutes.count(), seconds.count()
+		) :
+		fmt::format_to_n(buffer.data(), maxLength, "{:02d}:{:02d}",
+			minutes.count(), seconds.count()
+		);
+	
+	const size_t length = std::min(res.size, maxLength);
+	buffer[length] = '\0';
+	return length;
 }
 
 Pango::AttrList create_attr_list(std::initializer_list<Pango::Attribute> attrs)